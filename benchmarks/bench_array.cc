@@ -0,0 +1,53 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/array.hh"
+
+// reads and writes of packed array elements at runtime indices, as in a register file model
+
+constexpr uint64_t accesses = 1024;
+
+template <typename T, int count>
+void index_read(benchmark::State &state) {
+    logic::packed_array<T, count - 1, 0> array;
+    std::mt19937 rng(count);
+    std::vector<logic::logic<15, 0>> indices;
+    for (uint64_t i = 0; i < accesses; i++) indices.emplace_back(rng() % count);
+    for (auto _ : state) {
+        for (auto const &idx : indices) {
+            auto v = array[idx];
+            benchmark::DoNotOptimize(v);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * accesses));
+}
+
+template <typename T, int count>
+void index_update(benchmark::State &state) {
+    logic::packed_array<T, count - 1, 0> array;
+    std::mt19937 rng(count);
+    std::vector<logic::logic<15, 0>> indices;
+    for (uint64_t i = 0; i < accesses; i++) indices.emplace_back(rng() % count);
+    auto const value = T(42);
+    for (auto _ : state) {
+        for (auto const &idx : indices) array.update(idx, value);
+        benchmark::DoNotOptimize(array);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * accesses));
+}
+
+// native storage, sub-word elements in a big number, word sized and wide elements
+BENCHMARK_TEMPLATE(index_read, logic::logic<7, 0>, 8);
+BENCHMARK_TEMPLATE(index_read, logic::logic<12, 0>, 64);
+BENCHMARK_TEMPLATE(index_read, logic::logic<63, 0>, 32);
+BENCHMARK_TEMPLATE(index_read, logic::bit<12, 0>, 64);
+BENCHMARK_TEMPLATE(index_read, logic::logic<199, 0>, 16);
+BENCHMARK_TEMPLATE(index_update, logic::logic<7, 0>, 8);
+BENCHMARK_TEMPLATE(index_update, logic::logic<12, 0>, 64);
+BENCHMARK_TEMPLATE(index_update, logic::logic<63, 0>, 32);
+BENCHMARK_TEMPLATE(index_update, logic::bit<12, 0>, 64);
+BENCHMARK_TEMPLATE(index_update, logic::logic<199, 0>, 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,61 @@
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "logic/logic.hh"
+
+// binary and hex strings of wide 4-state values, parsed and formatted at every simd level the
+// cpu supports. the argument is the simd level
+
+constexpr int size = 1024;
+using value_type = logic::logic<size - 1, 0>;
+
+value_type random_logic() {
+    std::mt19937_64 rng(size);
+    value_type result;
+    for (auto &v : result.value.value.values) v = rng();
+    // a few x and z bits
+    for (auto &v : result.xz_mask.value.values) v = rng() & rng() & rng();
+    return result;
+}
+
+bool set_level(benchmark::State &state) {
+    auto const level = static_cast<logic::util::simd_level>(state.range(0));
+    if (logic::util::set_simd_level(level) != level) {
+        state.SkipWithError("not supported");
+        return false;
+    }
+    return true;
+}
+
+void parse(benchmark::State &state, std::string_view fmt) {
+    if (!set_level(state)) return;
+    auto const str = std::to_string(size) + "'" + std::string(fmt) + random_logic().str(fmt);
+    for (auto _ : state) {
+        value_type v(str);
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * str.size()));
+}
+
+void format(benchmark::State &state, std::string_view fmt) {
+    if (!set_level(state)) return;
+    auto const v = random_logic();
+    std::array<char, size + 1> buffer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(v);
+        benchmark::DoNotOptimize(v.format_to(buffer.begin(), buffer.end(), fmt));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * v.str(fmt).size()));
+}
+
+void parse_bin(benchmark::State &state) { parse(state, "b"); }
+void parse_hex(benchmark::State &state) { parse(state, "h"); }
+void format_bin(benchmark::State &state) { format(state, "b"); }
+void format_hex(benchmark::State &state) { format(state, "h"); }
+
+BENCHMARK(parse_bin)->DenseRange(0, 2);
+BENCHMARK(parse_hex)->DenseRange(0, 2);
+BENCHMARK(format_bin)->DenseRange(0, 2);
+BENCHMARK(format_hex)->DenseRange(0, 2);
+
+BENCHMARK_MAIN();
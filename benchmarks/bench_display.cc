@@ -0,0 +1,29 @@
+#include "benchmark/benchmark.h"
+#include "logic/display.hh"
+
+// a typical $display line, formatted value by value with str() and as one compiled format
+
+void display_str(benchmark::State &state) {
+    auto const a = logic::logic<31, 0>(0xdead'beef);
+    auto const b = logic::logic<127, 0>("128'h1234_5678_9abc_def0_0123_4567_89ab_cdef");
+    for (auto _ : state) {
+        auto s = "a: " + a.str("0h") + " b: " + b.str("d");
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+void display_compiled(benchmark::State &state) {
+    auto const a = logic::logic<31, 0>(0xdead'beef);
+    auto const b = logic::logic<127, 0>("128'h1234_5678_9abc_def0_0123_4567_89ab_cdef");
+    std::array<char, 128> buffer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(
+            logic::sformatf_to<"a: %0h b: %d">(buffer.begin(), buffer.end(), a, b));
+    }
+}
+
+BENCHMARK(display_str);
+BENCHMARK(display_compiled);
+
+BENCHMARK_MAIN();
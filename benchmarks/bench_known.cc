@@ -0,0 +1,90 @@
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/logic.hh"
+
+// logic holding only 0 and 1 against bit. once an operator has checked that neither operand has
+// x or z, it runs the same code as bit, so the two should stay close
+
+constexpr uint64_t elements = 64;
+
+template <typename T>
+std::vector<T> random_values(uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<T> result(elements);
+    for (auto &v : result) {
+        logic::bit<T::size - 1, 0> b;
+        if constexpr (logic::util::native_num(T::size)) {
+            b.value = rng();
+        } else {
+            for (auto &w : b.value.values) w = rng();
+        }
+        b.mask_off();
+        v = T(b);
+    }
+    return result;
+}
+
+template <typename T, typename F>
+void run(benchmark::State &state, F &&op) {
+    auto const a = random_values<T>(1);
+    auto const b = random_values<T>(2);
+    // not a vector, which would pack bool results
+    auto c = std::make_unique<decltype(op(a[0], b[0]))[]>(elements);
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < elements; i++) c[i] = op(a[i], b[i]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+}
+
+template <typename T>
+void add(benchmark::State &state) {
+    run<T>(state, [](auto const &a, auto const &b) { return a + b; });
+}
+
+template <typename T>
+void and_(benchmark::State &state) {
+    run<T>(state, [](auto const &a, auto const &b) { return a & b; });
+}
+
+template <typename T>
+void not_(benchmark::State &state) {
+    run<T>(state, [](auto const &a, auto const &) { return ~a; });
+}
+
+template <typename T>
+void eq(benchmark::State &state) {
+    run<T>(state, [](auto const &a, auto const &b) { return a == b; });
+}
+
+template <typename T>
+void lt(benchmark::State &state) {
+    run<T>(state, [](auto const &a, auto const &b) { return a < b; });
+}
+
+template <typename T>
+void shl(benchmark::State &state) {
+    // shift amounts within the width
+    run<T>(state, [](auto const &a, auto const &b) { return a << (b & T(T::size - 1)); });
+}
+
+#define KNOWN_BENCHMARK(name, size)                             \
+    BENCHMARK_TEMPLATE(name, logic::bit<(size)-1, 0>);         \
+    BENCHMARK_TEMPLATE(name, logic::logic<(size)-1, 0>)
+
+#define KNOWN_BENCHMARKS(name)    \
+    KNOWN_BENCHMARK(name, 32);    \
+    KNOWN_BENCHMARK(name, 128);   \
+    KNOWN_BENCHMARK(name, 1024)
+
+KNOWN_BENCHMARKS(add);
+KNOWN_BENCHMARKS(and_);
+KNOWN_BENCHMARKS(not_);
+KNOWN_BENCHMARKS(eq);
+KNOWN_BENCHMARKS(lt);
+KNOWN_BENCHMARKS(shl);
+
+BENCHMARK_MAIN();
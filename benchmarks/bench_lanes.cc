@@ -0,0 +1,58 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/lanes.hh"
+
+// a 32-bit ripple carry adder as a gate netlist, evaluated for 64 stimuli one bit<0> at a time
+// against one evaluation on 64 lanes. the lanes version should cost about one scalar evaluation
+
+constexpr auto width = 32;
+constexpr uint64_t stimuli = 64;
+
+template <typename T>
+void full_adder(const T &a, const T &b, T &carry, T &sum) {
+    auto const p = a ^ b;
+    sum = p ^ carry;
+    carry = (a & b) | (p & carry);
+}
+
+void adder_scalar(benchmark::State &state) {
+    std::mt19937_64 rng(width);
+    std::vector<std::array<logic::bit<0>, width>> a(stimuli), b(stimuli), sum(stimuli);
+    for (uint64_t s = 0; s < stimuli; s++) {
+        for (auto i = 0; i < width; i++) {
+            a[s][i] = logic::bit<0>(rng() & 1);
+            b[s][i] = logic::bit<0>(rng() & 1);
+        }
+    }
+    for (auto _ : state) {
+        for (uint64_t s = 0; s < stimuli; s++) {
+            logic::bit<0> carry(0);
+            for (auto i = 0; i < width; i++) full_adder(a[s][i], b[s][i], carry, sum[s][i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * stimuli));
+}
+
+void adder_lanes(benchmark::State &state) {
+    std::mt19937_64 rng(width);
+    logic::bit_lanes<width, stimuli> a, b, sum;
+    for (auto i = 0; i < width; i++) {
+        a[i].values[0] = rng();
+        b[i].values[0] = rng();
+    }
+    for (auto _ : state) {
+        logic::lanes<stimuli> carry;
+        for (auto i = 0; i < width; i++) full_adder(a[i], b[i], carry, sum[i]);
+        benchmark::DoNotOptimize(sum);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * stimuli));
+}
+
+BENCHMARK(adder_scalar);
+BENCHMARK(adder_lanes);
+
+BENCHMARK_MAIN();
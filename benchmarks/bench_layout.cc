@@ -0,0 +1,95 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/interleaved.hh"
+
+// split (logic) against interleaved value/xz words, over populations of wide vectors large enough
+// to stream from memory rather than cache
+
+// bits per population, per operand
+constexpr uint64_t population_bits = 1ull << 26;
+
+template <typename T>
+std::vector<T> random_population() {
+    std::mt19937_64 rng(T::size);
+    std::vector<T> result(population_bits / T::size);
+    for (auto &v : result) {
+        logic::logic<T::size - 1, 0> l(0);
+        for (auto i = 0u; i < T::size; i++) {
+            auto const r = rng() % 16;
+            // mostly known bits, with the occasional x or z
+            if (r == 0) {
+                l.set_x(i);
+            } else if (r == 1) {
+                l.set_z(i);
+            } else {
+                l.set(i, r & 1);
+            }
+        }
+        v = T(l);
+    }
+    return result;
+}
+
+template <typename T>
+void set_bytes(benchmark::State &state, uint64_t operands) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * operands * population_bits /
+                                                 4 / 8));
+}
+
+template <typename T>
+void layout_and(benchmark::State &state) {
+    auto const a = random_population<T>();
+    auto const b = random_population<T>();
+    std::vector<T> c(a.size());
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < a.size(); i++) c[i] = a[i] & b[i];
+        benchmark::ClobberMemory();
+    }
+    set_bytes<T>(state, 3);
+}
+
+template <typename T>
+void layout_or(benchmark::State &state) {
+    auto const a = random_population<T>();
+    auto const b = random_population<T>();
+    std::vector<T> c(a.size());
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < a.size(); i++) c[i] = a[i] | b[i];
+        benchmark::ClobberMemory();
+    }
+    set_bytes<T>(state, 3);
+}
+
+template <typename T>
+void layout_not(benchmark::State &state) {
+    auto const a = random_population<T>();
+    std::vector<T> c(a.size());
+    for (auto _ : state) {
+        for (uint64_t i = 0; i < a.size(); i++) c[i] = ~a[i];
+        benchmark::ClobberMemory();
+    }
+    set_bytes<T>(state, 2);
+}
+
+template <int size>
+using split = logic::logic<size - 1, 0>;
+template <int size>
+using interleaved = logic::interleaved_logic<size - 1, 0>;
+
+#define LAYOUT_BENCHMARK(name, size)                \
+    BENCHMARK_TEMPLATE(name, split<size>);          \
+    BENCHMARK_TEMPLATE(name, interleaved<size>)
+
+#define LAYOUT_BENCHMARKS(name)    \
+    LAYOUT_BENCHMARK(name, 1024);  \
+    LAYOUT_BENCHMARK(name, 4096);  \
+    LAYOUT_BENCHMARK(name, 16384); \
+    LAYOUT_BENCHMARK(name, 65536)
+
+LAYOUT_BENCHMARKS(layout_and);
+LAYOUT_BENCHMARKS(layout_or);
+LAYOUT_BENCHMARKS(layout_not);
+
+BENCHMARK_MAIN();
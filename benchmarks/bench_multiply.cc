@@ -0,0 +1,112 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/big_num.hh"
+
+// big_num multiplication at the 2048 and 4096-bit widths of the crypto models, and the word
+// kernels behind it, to check karatsuba_threshold and short_mul_threshold against. a truncated
+// product of that width stays on the schoolbook kernel, which beats mul_short there, while a
+// full product, e.g. of operands extended to twice their width, goes through mul_karatsuba
+
+template <uint64_t size>
+logic::big_num<size> random_big_num(std::mt19937_64 &rng) {
+    logic::big_num<size> result;
+    for (auto &v : result.values) v = rng();
+    result.mask_off();
+    return result;
+}
+
+// a * b truncated to size
+template <uint64_t size>
+void mul_truncated(benchmark::State &state) {
+    std::mt19937_64 rng(size);
+    auto const a = random_big_num<size>(rng), b = random_big_num<size>(rng);
+    for (auto _ : state) {
+        auto c = a * b;
+        benchmark::DoNotOptimize(c);
+    }
+}
+
+// the 2 * size product of two size-bit values
+template <uint64_t size>
+void mul_widening(benchmark::State &state) {
+    std::mt19937_64 rng(size);
+    auto const a = random_big_num<size>(rng).template extend<2 * size>();
+    auto const b = random_big_num<size>(rng).template extend<2 * size>();
+    for (auto _ : state) {
+        auto c = a * b;
+        benchmark::DoNotOptimize(c);
+    }
+}
+
+template <uint64_t n>
+struct kernel_operands {
+    std::vector<uint64_t> a = std::vector<uint64_t>(n);
+    std::vector<uint64_t> b = std::vector<uint64_t>(n);
+    std::vector<uint64_t> r = std::vector<uint64_t>(2 * n);
+    std::vector<uint64_t> scratch = std::vector<uint64_t>(
+        logic::util::max(logic::util::karatsuba_scratch_size(n),
+                         logic::util::mul_short_scratch_size(n)));
+
+    kernel_operands() {
+        std::mt19937_64 rng(n);
+        for (auto &w : a) w = rng();
+        for (auto &w : b) w = rng();
+    }
+};
+
+// full products of n words
+template <uint64_t n>
+void full_basecase(benchmark::State &state) {
+    kernel_operands<n> o;
+    for (auto _ : state) {
+        logic::util::mul_basecase(o.r.data(), 2 * n, o.a.data(), n, o.b.data(), n);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <uint64_t n>
+void full_karatsuba(benchmark::State &state) {
+    kernel_operands<n> o;
+    for (auto _ : state) {
+        logic::util::mul_karatsuba(o.r.data(), o.a.data(), o.b.data(), n, o.scratch.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+// products of n words truncated to n words
+template <uint64_t n>
+void short_basecase(benchmark::State &state) {
+    kernel_operands<n> o;
+    for (auto _ : state) {
+        logic::util::mul_basecase(o.r.data(), n, o.a.data(), n, o.b.data(), n);
+        benchmark::ClobberMemory();
+    }
+}
+
+// mul_short only splits from short_mul_threshold words, so below that this is the same as
+// short_basecase. build with a smaller -DLOGIC_KARATSUBA_THRESHOLD to compare
+template <uint64_t n>
+void short_karatsuba(benchmark::State &state) {
+    kernel_operands<n> o;
+    for (auto _ : state) {
+        logic::util::mul_short(o.r.data(), o.a.data(), o.b.data(), n, o.scratch.data());
+        benchmark::ClobberMemory();
+    }
+}
+
+BENCHMARK_TEMPLATE(mul_truncated, 2048);
+BENCHMARK_TEMPLATE(mul_truncated, 4096);
+BENCHMARK_TEMPLATE(mul_widening, 2048);
+BENCHMARK_TEMPLATE(mul_widening, 4096);
+BENCHMARK_TEMPLATE(full_basecase, 32);
+BENCHMARK_TEMPLATE(full_karatsuba, 32);
+BENCHMARK_TEMPLATE(full_basecase, 64);
+BENCHMARK_TEMPLATE(full_karatsuba, 64);
+BENCHMARK_TEMPLATE(short_basecase, 32);
+BENCHMARK_TEMPLATE(short_karatsuba, 32);
+BENCHMARK_TEMPLATE(short_basecase, 64);
+BENCHMARK_TEMPLATE(short_karatsuba, 64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,192 @@
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "logic/logic.hh"
+
+// every operator of bit, logic and big_num over the widths we care about. benchmarks are named
+// op/type/width so that runs from two releases line up, e.g.
+//     bench_operators --benchmark_out=new.json --benchmark_out_format=json
+//     compare.py benchmarks old.json new.json
+// (compare.py ships with google benchmark.) the bench_operators_json target writes the json
+//
+// types are bit, logic holding only 0 and 1 (logic2), logic with x and z mixed in (logic4) and
+// big_num, which only exists past 64 bits
+
+// operands per iteration
+constexpr uint64_t elements = 16;
+
+template <typename T>
+struct operands {
+    std::vector<T> a;
+    std::vector<T> b;
+    // never 0
+    std::vector<T> divisors;
+    // known and within the width
+    std::vector<T> amounts;
+    std::vector<uint64_t> raw_amounts;
+    // literals of a, for parsing
+    std::vector<std::string> literals;
+};
+
+template <int size>
+logic::bit<size - 1, 0> random_bit(std::mt19937_64 &rng) {
+    logic::bit<size - 1, 0> b;
+    if constexpr (logic::util::native_num(size)) {
+        b.value = rng();
+    } else {
+        for (auto &w : b.value.values) w = rng();
+    }
+    b.mask_off();
+    return b;
+}
+
+template <int size>
+logic::logic<size - 1, 0> random_logic(std::mt19937_64 &rng, bool four_state) {
+    logic::logic<size - 1, 0> l(random_bit<size>(rng));
+    if (!four_state) return l;
+    // one bit in eight is x or z
+    for (auto i = 0; i < size; i++) {
+        auto const r = rng() % 16;
+        if (r == 0) l.set_x(i);
+        if (r == 1) l.set_z(i);
+    }
+    return l;
+}
+
+// make converts a random logic into the benchmarked type
+template <int size, typename F>
+auto make_operands(bool four_state, F &&make) {
+    using T = decltype(make(logic::logic<size - 1, 0>()));
+    std::mt19937_64 rng(size);
+    operands<T> result;
+    for (auto i = 0u; i < elements; i++) {
+        auto const a = random_logic<size>(rng, four_state);
+        result.a.emplace_back(make(a));
+        result.b.emplace_back(make(random_logic<size>(rng, four_state)));
+        auto d = random_logic<size>(rng, four_state);
+        d.set(0, true);
+        result.divisors.emplace_back(make(d));
+        auto const amount = rng() % size;
+        result.amounts.emplace_back(make(logic::logic<size - 1, 0>(amount)));
+        result.raw_amounts.emplace_back(amount);
+        result.literals.emplace_back(std::to_string(size).append("'h").append(a.str("h")));
+    }
+    return result;
+}
+
+template <typename T, typename F>
+void add_operator(std::string const &name, std::shared_ptr<const operands<T>> const &ops,
+                  F &&op) {
+    benchmark::RegisterBenchmark(name.c_str(), [ops, op](benchmark::State &state) {
+        // not a vector, which would pack bool results
+        auto c = std::make_unique<decltype(op(*ops, 0))[]>(elements);
+        for (auto _ : state) {
+            for (uint64_t i = 0; i < elements; i++) c[i] = op(*ops, i);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * elements));
+    });
+}
+
+// operators shared by all types
+template <int size, typename T>
+void add_common(std::string const &suffix, std::shared_ptr<const operands<T>> const &ops) {
+    auto add = [&](std::string const &op_name, auto &&op) {
+        add_operator<T>(std::string(op_name).append(suffix), ops, op);
+    };
+    using O = operands<T>;
+    // bitwise
+    add("and", [](O const &o, uint64_t i) { return o.a[i] & o.b[i]; });
+    add("or", [](O const &o, uint64_t i) { return o.a[i] | o.b[i]; });
+    add("xor", [](O const &o, uint64_t i) { return o.a[i] ^ o.b[i]; });
+    add("not", [](O const &o, uint64_t i) { return ~o.a[i]; });
+    // arithmetic
+    add("add", [](O const &o, uint64_t i) { return o.a[i] + o.b[i]; });
+    add("sub", [](O const &o, uint64_t i) { return o.a[i] - o.b[i]; });
+    add("mul", [](O const &o, uint64_t i) { return o.a[i] * o.b[i]; });
+    add("div", [](O const &o, uint64_t i) { return o.a[i] / o.divisors[i]; });
+    add("mod", [](O const &o, uint64_t i) { return o.a[i] % o.divisors[i]; });
+    add("neg", [](O const &o, uint64_t i) { return -o.a[i]; });
+    // comparisons
+    add("eq", [](O const &o, uint64_t i) { return o.a[i] == o.b[i]; });
+    add("ne", [](O const &o, uint64_t i) { return o.a[i] != o.b[i]; });
+    add("lt", [](O const &o, uint64_t i) { return o.a[i] < o.b[i]; });
+    add("ge", [](O const &o, uint64_t i) { return o.a[i] >= o.b[i]; });
+    // slices
+    add("slice", [](O const &o, uint64_t i) {
+        return o.a[i].template slice<size - 1, size / 2>();
+    });
+    add("concat", [](O const &o, uint64_t i) { return o.a[i].concat(o.b[i]); });
+    // reductions
+    add("r_and", [](O const &o, uint64_t i) { return o.a[i].r_and(); });
+    add("r_xor", [](O const &o, uint64_t i) { return o.a[i].r_xor(); });
+    // parsing
+    add("parse", [](O const &o, uint64_t i) { return T(o.literals[i]); });
+}
+
+// bit and logic
+template <int size, typename T>
+void add_vector(std::string const &type, std::shared_ptr<const operands<T>> const &ops) {
+    auto const suffix = std::string("/").append(type).append("/").append(std::to_string(size));
+    add_common<size>(suffix, ops);
+    auto add = [&](std::string const &op_name, auto &&op) {
+        add_operator<T>(std::string(op_name).append(suffix), ops, op);
+    };
+    using O = operands<T>;
+    add("shl", [](O const &o, uint64_t i) { return o.a[i] << o.amounts[i]; });
+    add("shr", [](O const &o, uint64_t i) { return o.a[i] >> o.amounts[i]; });
+    add("ashr", [](O const &o, uint64_t i) { return o.a[i].ashr(o.amounts[i]); });
+    add("r_or", [](O const &o, uint64_t i) { return o.a[i].r_or(); });
+    add("str", [](O const &o, uint64_t i) { return o.a[i].str("h"); });
+    add("str_d", [](O const &o, uint64_t i) { return o.a[i].str("d"); });
+}
+
+template <int size>
+void add_big_num() {
+    auto ops = std::make_shared<const operands<logic::big_num<size, false>>>(
+        make_operands<size>(false, [](auto const &l) { return l.value.value; }));
+    auto const suffix = std::string("/big_num/").append(std::to_string(size));
+    add_common<size>(suffix, ops);
+    auto add = [&](std::string const &op_name, auto &&op) {
+        add_operator<logic::big_num<size, false>>(std::string(op_name).append(suffix), ops, op);
+    };
+    using O = operands<logic::big_num<size, false>>;
+    add("shl", [](O const &o, uint64_t i) { return o.a[i] << o.raw_amounts[i]; });
+    add("shr", [](O const &o, uint64_t i) { return o.a[i] >> o.raw_amounts[i]; });
+    add("ashr", [](O const &o, uint64_t i) { return o.a[i].ashr(o.raw_amounts[i]); });
+    add("r_or", [](O const &o, uint64_t i) { return o.a[i].any_set(); });
+}
+
+template <int size>
+void add_width() {
+    auto to_bit = [](logic::logic<size - 1, 0> const &l) { return l.value; };
+    auto same = [](logic::logic<size - 1, 0> const &l) { return l; };
+    add_vector<size>("bit", std::make_shared<const decltype(make_operands<size>(false, to_bit))>(
+                                make_operands<size>(false, to_bit)));
+    add_vector<size>("logic2", std::make_shared<const decltype(make_operands<size>(false, same))>(
+                                   make_operands<size>(false, same)));
+    add_vector<size>("logic4", std::make_shared<const decltype(make_operands<size>(true, same))>(
+                                   make_operands<size>(true, same)));
+    if constexpr (!logic::util::native_num(size)) add_big_num<size>();
+}
+
+int main(int argc, char **argv) {
+    add_width<1>();
+    add_width<8>();
+    add_width<32>();
+    add_width<64>();
+    add_width<65>();
+    add_width<128>();
+    add_width<256>();
+    add_width<1024>();
+    add_width<4096>();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "logic/logic.hh"
+
+// reductions should scale with the number of words. bytes/s stays flat as the width grows
+
+template <int size>
+logic::bit<size - 1, 0> random_bit() {
+    std::mt19937_64 rng(size);
+    logic::bit<size - 1, 0> result;
+    if constexpr (logic::util::native_num(size)) {
+        result.value = rng();
+    } else {
+        for (auto &v : result.value.values) v = rng();
+    }
+    result.mask_off();
+    return result;
+}
+
+template <int size>
+void set_bytes(benchmark::State &state) {
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (size / 8));
+}
+
+template <int size>
+void bit_r_and(benchmark::State &state) {
+    // all ones is the worst case since there is no early exit
+    auto a = ~logic::bit<size - 1, 0>(0u);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_and());
+    }
+    set_bytes<size>(state);
+}
+
+template <int size>
+void bit_r_or(benchmark::State &state) {
+    logic::bit<size - 1, 0> a(0u);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_or());
+    }
+    set_bytes<size>(state);
+}
+
+template <int size>
+void bit_r_xor(benchmark::State &state) {
+    auto a = random_bit<size>();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_xor());
+    }
+    set_bytes<size>(state);
+}
+
+template <int size>
+void logic_r_and(benchmark::State &state) {
+    logic::logic<size - 1, 0> a(0u);
+    a = ~a;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_and());
+    }
+    set_bytes<size>(state);
+}
+
+template <int size>
+void logic_r_or(benchmark::State &state) {
+    logic::logic<size - 1, 0> a(0u);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_or());
+    }
+    set_bytes<size>(state);
+}
+
+template <int size>
+void logic_r_xor(benchmark::State &state) {
+    logic::logic<size - 1, 0> a(random_bit<size>());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(a.r_xor());
+    }
+    set_bytes<size>(state);
+}
+
+#define REDUCTION_BENCHMARK(name)                                                              \
+    BENCHMARK_TEMPLATE(name, 64);                                                              \
+    BENCHMARK_TEMPLATE(name, 256);                                                             \
+    BENCHMARK_TEMPLATE(name, 1024);                                                            \
+    BENCHMARK_TEMPLATE(name, 4096);                                                            \
+    BENCHMARK_TEMPLATE(name, 16384);                                                           \
+    BENCHMARK_TEMPLATE(name, 65536)
+
+REDUCTION_BENCHMARK(bit_r_and);
+REDUCTION_BENCHMARK(bit_r_or);
+REDUCTION_BENCHMARK(bit_r_xor);
+REDUCTION_BENCHMARK(logic_r_and);
+REDUCTION_BENCHMARK(logic_r_or);
+REDUCTION_BENCHMARK(logic_r_xor);
+
+BENCHMARK_MAIN();
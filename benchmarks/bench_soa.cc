@@ -0,0 +1,82 @@
+#include <memory>
+#include <random>
+
+#include "benchmark/benchmark.h"
+#include "logic/soa.hh"
+
+// an element-wise and and an x scan over a 128K entry memory of 3-bit and 32-bit logic, as an
+// unpacked_array against a soa_array
+
+constexpr auto entries = 128 * 1024;
+
+template <int width>
+using memory = logic::unpacked_array<logic::logic<width - 1, 0>, entries - 1, 0>;
+template <int width>
+using soa_memory = logic::soa_array<logic::logic<width - 1, 0>, entries - 1, 0>;
+
+template <int width>
+void fill(memory<width> &a) {
+    std::mt19937_64 rng(width);
+    for (auto &v : a.value) v = logic::logic<width - 1, 0>(rng());
+}
+
+template <int width>
+void and_unpacked(benchmark::State &state) {
+    // too large for the stack
+    auto a = std::make_unique<memory<width>>(), b = std::make_unique<memory<width>>();
+    fill<width>(*a);
+    fill<width>(*b);
+    for (auto _ : state) {
+        for (auto i = 0; i < entries; i++) a->value[i] = a->value[i] & b->value[i];
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entries));
+}
+
+template <int width>
+void and_soa(benchmark::State &state) {
+    auto a = std::make_unique<memory<width>>(), b = std::make_unique<memory<width>>();
+    fill<width>(*a);
+    fill<width>(*b);
+    soa_memory<width> sa(*a), sb(*b);
+    for (auto _ : state) {
+        sa &= sb;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entries));
+}
+
+template <int width>
+void any_x_unpacked(benchmark::State &state) {
+    auto a = std::make_unique<memory<width>>();
+    fill<width>(*a);
+    for (auto _ : state) {
+        bool r = false;
+        for (auto const &v : a->value) r |= v.xz_mask.any_set();
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entries));
+}
+
+template <int width>
+void any_x_soa(benchmark::State &state) {
+    auto a = std::make_unique<memory<width>>();
+    fill<width>(*a);
+    soa_memory<width> sa(*a);
+    for (auto _ : state) {
+        auto r = sa.any_x();
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * entries));
+}
+
+BENCHMARK_TEMPLATE(and_unpacked, 3);
+BENCHMARK_TEMPLATE(and_soa, 3);
+BENCHMARK_TEMPLATE(and_unpacked, 32);
+BENCHMARK_TEMPLATE(and_soa, 32);
+BENCHMARK_TEMPLATE(any_x_unpacked, 3);
+BENCHMARK_TEMPLATE(any_x_soa, 3);
+BENCHMARK_TEMPLATE(any_x_unpacked, 32);
+BENCHMARK_TEMPLATE(any_x_soa, 32);
+
+BENCHMARK_MAIN();
@@ -76,43 +76,49 @@ public:
         VT::template update_<end_addr - 1, start_addr>(v);
     }
 
+    // runtime index: one masked extract for elements up to 64 bits, a word copy for wider ones.
+    // an x or z index, or one out of range, reads x
     template <int op_msb, int op_lsb, bool op_signed>
     auto operator[](const logic<op_msb, op_lsb, op_signed> &op) const {
-        // if the value is too big, we return X
-        static const auto size_logic = logic<31, 0>(array_size);
-        if (op.xz_mask.any_set() || op >= size_logic) [[unlikely]] {
-            using T_ = typename util::get_array_base_type<T, base_size, T::is_4state>::type;
-            return T_{};
+        // x, or 0 for a 2-state array
+        typename util::get_array_base_type<T, base_size, T::is_4state>::type result;
+        auto const i = element_offset(op);
+        if (i >= element_count) [[unlikely]] {
+            return result;
+        }
+        if constexpr (is_4state) {
+            util::set_words(result.value, extract_element(this->value, i));
+            util::set_words(result.xz_mask, extract_element(this->xz_mask, i));
         } else {
-            int index;
-            if constexpr (util::native_num(logic<op_msb, op_lsb>::size)) {
-                index = op.value.value;
-            } else {
-                index = op.value.value[0];
-            }
-            auto idx = index - util::min(msb, lsb);
-            auto start_addr = idx * base_size;
-            auto end_addr = (idx + 1) * base_size;
-            return VT::template slice<base_size>(start_addr, end_addr);
+            util::set_words(result, extract_element(static_cast<const VT &>(*this), i));
         }
+        return result;
     }
 
+    // writes to an x or z index, or one out of range, are dropped. value is zero extended or
+    // truncated to the element size
     template <int op_msb, int op_lsb, bool op_signed, typename K>
     void update(const logic<op_msb, op_lsb, op_signed> &op, const K &value) {
-        static const auto size_logic = logic<31, 0>(array_size);
-        if (op.xz_mask.any_set() || op >= size_logic) [[unlikely]] {
+        auto const i = element_offset(op);
+        if (i >= element_count) [[unlikely]] {
             return;
-        } else {
-            int index;
-            if constexpr (util::native_num(logic<op_msb, op_lsb>::size)) {
-                index = op.value.value;
+        }
+        if constexpr (is_4state) {
+            if constexpr (K::is_4state) {
+                insert_element(this->value, i, util::get_words(value.value));
+                insert_element(this->xz_mask, i, util::get_words(value.xz_mask));
             } else {
-                index = op.value.value[0];
+                insert_element(this->value, i, util::get_words(value));
+                insert_element(this->xz_mask, i, std::array<uint64_t, 1>{});
             }
-            auto idx = index - util::min(msb, lsb);
-            int start_addr = idx * base_size;
-            int end_addr = (idx + 1) * base_size;
-            VT::template update_(start_addr, end_addr, value);
+        } else if constexpr (K::is_4state) {
+            // x and z are written as 0 in a 2-state array
+            auto words = util::get_words(value.value);
+            auto const xz_mask = util::get_words(value.xz_mask);
+            for (auto j = 0u; j < words.size(); j++) words[j] &= ~xz_mask[j];
+            insert_element(static_cast<VT &>(*this), i, words);
+        } else {
+            insert_element(static_cast<VT &>(*this), i, util::get_words(value));
         }
     }
 
@@ -121,6 +127,74 @@ public:
     explicit packed_array(std::string_view v) : VT(v) {}
 
     packed_array() = default;
+
+private:
+    static constexpr uint64_t element_count = util::abs_diff(msb, lsb) + 1;
+    static constexpr uint64_t element_words = (base_size + 63) / 64;
+
+    // position of the element at a runtime index, element_count if there is none
+    template <int op_msb, int op_lsb, bool op_signed>
+    static uint64_t element_offset(const logic<op_msb, op_lsb, op_signed> &op) {
+        if (op.xz_mask.any_set()) return element_count;
+        auto const words = util::get_words(op.value);
+        for (auto j = 1u; j < words.size(); j++) {
+            if (words[j]) return element_count;
+        }
+        // indices below the lowest one wrap around and are out of range as well
+        auto const i = words[0] - static_cast<uint64_t>(util::min(msb, lsb));
+        return i < element_count ? i : element_count;
+    }
+
+    // bits [i * base_size, (i + 1) * base_size) of the value or the xz mask of the array. every
+    // word of an element is one shift of at most two storage words, and a plain copy if elements
+    // are word aligned
+    template <typename B>
+    static std::array<uint64_t, element_words> extract_element(const B &b, uint64_t i) {
+        std::array<uint64_t, element_words> result;
+        auto const start = i * base_size;
+        if constexpr (B::native_num) {
+            result[0] = (static_cast<uint64_t>(b.value) >> start) & util::tail_mask(base_size);
+        } else if constexpr (base_size % 64 == 0) {
+            std::copy_n(b.value.values.begin() + start / 64, element_words, result.begin());
+        } else {
+            auto const *w = b.value.values.data() + start / 64;
+            auto const shift = start % 64;
+            for (uint64_t j = 0; j < element_words; j++) {
+                auto const count = util::min<uint64_t>(64, base_size - j * 64);
+                auto v = w[j] >> shift;
+                if (shift + count > 64) v |= w[j + 1] << (64 - shift);
+                result[j] = v & util::tail_mask(count);
+            }
+        }
+        return result;
+    }
+
+    template <typename B, uint64_t n>
+    static void insert_element(B &b, uint64_t i, const std::array<uint64_t, n> &words) {
+        auto const start = i * base_size;
+        // bits past the end of words are 0
+        auto word = [&words](uint64_t j) { return j < n ? words[j] : 0; };
+        if constexpr (B::native_num) {
+            auto const mask = util::tail_mask(base_size) << start;
+            auto const v = (static_cast<uint64_t>(b.value) & ~mask) | ((words[0] << start) & mask);
+            b.value = util::native_value<typename B::T>(v, B::size);
+        } else if constexpr (base_size % 64 == 0) {
+            auto *w = b.value.values.data() + start / 64;
+            for (uint64_t j = 0; j < element_words; j++) w[j] = word(j);
+        } else {
+            auto *w = b.value.values.data() + start / 64;
+            auto const shift = start % 64;
+            for (uint64_t j = 0; j < element_words; j++) {
+                auto const count = util::min<uint64_t>(64, base_size - j * 64);
+                auto const mask = util::tail_mask(count);
+                auto const v = word(j) & mask;
+                w[j] = (w[j] & ~(mask << shift)) | (v << shift);
+                if (shift + count > 64) {
+                    w[j + 1] = (w[j + 1] & ~(mask >> (64 - shift))) | (v >> (64 - shift));
+                }
+            }
+        }
+    }
 };
 
 template <typename T, int msb, int lsb>
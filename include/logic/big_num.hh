@@ -5,7 +5,428 @@
 
 #include "util.hh"
 
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_addcll) && __has_builtin(__builtin_subcll)
+#define LOGIC_BUILTIN_ADDC
+#endif
+#endif
+
+#if !defined(LOGIC_BUILTIN_ADDC) && (defined(__x86_64__) || defined(_M_X64))
+#include <immintrin.h>
+#define LOGIC_X86_ADDC
+#endif
+
 namespace logic {
+
+#ifndef LOGIC_KARATSUBA_THRESHOLD
+#define LOGIC_KARATSUBA_THRESHOLD 32
+#endif
+// number of 64-bit words below which we fall back to the schoolbook multiplication
+// can be tuned at build time via -DLOGIC_KARATSUBA_THRESHOLD=<words>
+constexpr uint64_t karatsuba_threshold = LOGIC_KARATSUBA_THRESHOLD;
+static_assert(karatsuba_threshold >= 4, "Karatsuba threshold too small");
+// truncated schoolbook products only compute half of the partial products, so the
+// crossover point is higher
+constexpr uint64_t short_mul_threshold = 3 * karatsuba_threshold;
+
+namespace util {
+/*
+ * word-level kernels shared by big number arithmetic
+ * all of them work on little endian word arrays, i.e. ptr[0] is the least significant word
+ */
+
+// a + b + carry_in, with the carry out written to carry_out. carry_in has to be 0 or 1
+// the intrinsics keep the carry in the flag register so the whole chain is adc instructions
+inline uint64_t addc(uint64_t a, uint64_t b, uint64_t carry_in, uint64_t &carry_out) {
+#if defined(LOGIC_BUILTIN_ADDC)
+    unsigned long long c;
+    auto r = __builtin_addcll(a, b, carry_in, &c);
+    carry_out = c;
+    return r;
+#elif defined(LOGIC_X86_ADDC)
+    unsigned long long r;
+    carry_out = _addcarry_u64(static_cast<unsigned char>(carry_in), a, b, &r);
+    return r;
+#else
+    auto v = a + b;
+    auto r = v + carry_in;
+    carry_out = (v < a) | (r < v);
+    return r;
+#endif
+}
+
+// a - b - borrow_in, with the borrow out written to borrow_out. borrow_in has to be 0 or 1
+inline uint64_t subb(uint64_t a, uint64_t b, uint64_t borrow_in, uint64_t &borrow_out) {
+#if defined(LOGIC_BUILTIN_ADDC)
+    unsigned long long c;
+    auto r = __builtin_subcll(a, b, borrow_in, &c);
+    borrow_out = c;
+    return r;
+#elif defined(LOGIC_X86_ADDC)
+    unsigned long long r;
+    borrow_out = _subborrow_u64(static_cast<unsigned char>(borrow_in), a, b, &r);
+    return r;
+#else
+    auto v = a - b;
+    auto r = v - borrow_in;
+    borrow_out = (a < b) | (v < borrow_in);
+    return r;
+#endif
+}
+
+// r[0, n) = a[0, n) + b[0, n), returns the carry out
+inline uint64_t add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n) {
+    uint64_t carry = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        r[i] = addc(a[i], b[i], carry, carry);
+    }
+    return carry;
+}
+
+// r[0, n) = a[0, n) - b[0, n), returns the borrow out
+inline uint64_t sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n) {
+    uint64_t borrow = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        r[i] = subb(a[i], b[i], borrow, borrow);
+    }
+    return borrow;
+}
+
+// r[0, n) = -a[0, n) in 2's complement, in a single pass
+inline void neg_n(uint64_t *r, const uint64_t *a, uint64_t n) {
+    uint64_t borrow = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        r[i] = subb(0, a[i], borrow, borrow);
+    }
+}
+
+// r[0, n) += 1, returns the carry out. stops as soon as the carry is absorbed
+inline uint64_t inc_n(uint64_t *r, uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        if (++r[i] != 0) return 0;
+    }
+    return 1;
+}
+
+// r[0, n) -= 1, returns the borrow out
+inline uint64_t dec_n(uint64_t *r, uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        if (r[i]-- != 0) return 0;
+    }
+    return 1;
+}
+
+// r[0, ceil(count / 64)) = bits [start, start + count) of a[0, n). bits past the end of a are 0
+constexpr void extract_bits(uint64_t *r, const uint64_t *a, uint64_t n, uint64_t start,
+                            uint64_t count) {
+    auto const words = (count + 63) / 64;
+    auto const offset = start / 64;
+    auto const shift = start % 64;
+    auto word = [a, n](uint64_t i) { return i < n ? a[i] : 0; };
+    for (uint64_t i = 0; i < words; i++) {
+        auto v = word(offset + i) >> shift;
+        if (shift) v |= word(offset + i + 1) << (64 - shift);
+        r[i] = v;
+    }
+    if (count % 64) r[words - 1] &= tail_mask(count);
+}
+
+// bits [start, start + count) of r[0, n) = bits [0, count) of a[0, m). bits past the end of a
+// are 0 and bits past the end of r are dropped
+constexpr void insert_bits(uint64_t *r, uint64_t n, uint64_t start, uint64_t count,
+                           const uint64_t *a, uint64_t m) {
+    if (start >= n * 64) return;
+    count = min(count, n * 64 - start);
+    auto word = [a, m](uint64_t i) { return i < m ? a[i] : 0; };
+    uint64_t done = 0;
+    for (auto i = start / 64; done < count; i++) {
+        // one destination word at a time
+        auto const lo = done ? 0 : start % 64;
+        auto const bits = min(64 - lo, count - done);
+        auto const mask = tail_mask(bits) << lo;
+        auto const src_shift = done % 64;
+        auto v = word(done / 64) >> src_shift;
+        if (src_shift) v |= word(done / 64 + 1) << (64 - src_shift);
+        r[i] = (r[i] & ~mask) | ((v << lo) & mask);
+        done += bits;
+    }
+}
+
+// reverses the order of the slice-bit blocks inside a word. slice has to divide 64
+template <uint64_t slice>
+requires(slice > 0 && 64 % slice == 0) constexpr uint64_t reverse_blocks(uint64_t v) {
+    if constexpr (slice <= 1) {
+        v = ((v >> 1) & 0x5555'5555'5555'5555ull) | ((v & 0x5555'5555'5555'5555ull) << 1);
+    }
+    if constexpr (slice <= 2) {
+        v = ((v >> 2) & 0x3333'3333'3333'3333ull) | ((v & 0x3333'3333'3333'3333ull) << 2);
+    }
+    if constexpr (slice <= 4) {
+        v = ((v >> 4) & 0x0F0F'0F0F'0F0F'0F0Full) | ((v & 0x0F0F'0F0F'0F0F'0F0Full) << 4);
+    }
+    if constexpr (slice <= 8) {
+        v = __builtin_bswap64(v);
+    } else {
+        if constexpr (slice <= 16) {
+            v = ((v >> 16) & 0x0000'FFFF'0000'FFFFull) | ((v & 0x0000'FFFF'0000'FFFFull) << 16);
+        }
+        if constexpr (slice <= 32) v = (v >> 32) | (v << 32);
+    }
+    return v;
+}
+
+// r[0, n) = the low size bits of a[0, n) streamed as {<<slice{a}}, LRM 11.4.14.2: slices are cut
+// from the lsb and laid out in reverse order, so a short trailing slice, the top bits of a, ends up
+// at the bottom. r can't alias a
+template <uint64_t slice>
+requires(slice > 0) constexpr void stream_left_n(uint64_t *r, const uint64_t *a, uint64_t n,
+                                                 uint64_t size) {
+    auto const full = size / slice;
+    auto const rest = size % slice;
+    // bits of a in full slices
+    auto const top = full * slice;
+    if constexpr (64 % slice == 0) {
+        // the slices line up with word boundaries from bit 0. reversing the words and the slices
+        // inside each of them puts slice i at the top of the n words, so the full slices only
+        // have to be shifted down into place. the short slice is left out and added below
+        for (uint64_t i = 0; i < n; i++) {
+            auto const j = n - 1 - i;
+            auto v = a[j];
+            if (top <= j * 64) {
+                v = 0;
+            } else if (top < (j + 1) * 64) {
+                v &= tail_mask(top);
+            }
+            r[i] = reverse_blocks<slice>(v);
+        }
+        if (auto const pad = n * 64 - size) {
+            for (uint64_t i = 0; i < n; i++) {
+                r[i] = (r[i] >> pad) | (i + 1 < n ? r[i + 1] << (64 - pad) : 0);
+            }
+        }
+        if (rest) {
+            uint64_t v;
+            extract_bits(&v, a, n, top, rest);
+            r[0] |= v;
+        }
+    } else {
+        std::array<uint64_t, (slice + 63) / 64> block;
+        for (uint64_t i = 0; i < full; i++) {
+            extract_bits(block.data(), a, n, i * slice, slice);
+            insert_bits(r, n, size - (i + 1) * slice, slice, block.data(), block.size());
+        }
+        if (rest) {
+            extract_bits(block.data(), a, n, top, rest);
+            insert_bits(r, n, 0, rest, block.data(), block.size());
+        }
+    }
+    if (size % 64) r[n - 1] &= tail_mask(size);
+}
+
+// r[0, n) += a[0, m) with m <= n, carry propagates up to n words. returns the carry out
+inline uint64_t add_to(uint64_t *r, uint64_t n, const uint64_t *a, uint64_t m) {
+    auto carry = add_n(r, r, a, m);
+    for (auto i = m; i < n && carry; i++) {
+        carry = ++r[i] == 0;
+    }
+    return carry;
+}
+
+// r[0, n) -= a[0, m) with m <= n, borrow propagates up to n words. returns the borrow out
+inline uint64_t sub_from(uint64_t *r, uint64_t n, const uint64_t *a, uint64_t m) {
+    auto borrow = sub_n(r, r, a, m);
+    for (auto i = m; i < n && borrow; i++) {
+        borrow = r[i]-- == 0;
+    }
+    return borrow;
+}
+
+// r[0, nr) = lowest nr words of a[0, na) * b[0, nb). r can't alias a or b
+// single pass schoolbook multiplication with carries accumulated in place
+inline void mul_basecase(uint64_t *r, uint64_t nr, const uint64_t *a, uint64_t na,
+                         const uint64_t *b, uint64_t nb) {
+    std::fill(r, r + nr, 0);
+    for (uint64_t i = 0; i < util::min(na, nr); i++) {
+        if (a[i] == 0) continue;
+        uint64_t carry = 0;
+        auto const end = util::min(nb, nr - i);
+        for (uint64_t j = 0; j < end; j++) {
+            __uint128_t v = static_cast<__uint128_t>(a[i]) * b[j] + r[i + j] + carry;
+            r[i + j] = static_cast<uint64_t>(v);
+            carry = static_cast<uint64_t>(v >> 64);
+        }
+        if (i + nb < nr) r[i + nb] = carry;
+    }
+}
+
+// scratch words needed by mul_karatsuba for n-word operands
+constexpr uint64_t karatsuba_scratch_size(uint64_t n) {
+    if (n < karatsuba_threshold) return 0;
+    auto const m = n - n / 2 + 1;
+    return 4 * m + karatsuba_scratch_size(m);
+}
+
+// r[0, 2n) = a[0, n) * b[0, n). r can't alias a or b
+// t needs to hold at least karatsuba_scratch_size(n) words
+inline void mul_karatsuba(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n,
+                          uint64_t *t) {
+    if (n < karatsuba_threshold) {
+        mul_basecase(r, 2 * n, a, n, b, n);
+        return;
+    }
+    // a = a1 * B^h + a0, where B = 2^64
+    auto const h = n / 2;
+    auto const m = n - h;
+    // z0 = a0 * b0 and z2 = a1 * b1 go straight into the result
+    mul_karatsuba(r, a, b, h, t);
+    mul_karatsuba(r + 2 * h, a + h, b + h, m, t);
+    // (a0 + a1) and (b0 + b1) need one extra word for the carry
+    auto *sa = t;
+    auto *sb = t + m + 1;
+    auto *z1 = t + 2 * (m + 1);
+    std::copy(a + h, a + n, sa);
+    sa[m] = add_to(sa, m, a, h);
+    std::copy(b + h, b + n, sb);
+    sb[m] = add_to(sb, m, b, h);
+    // z1 = (a0 + a1)(b0 + b1) - z0 - z2 = a0 * b1 + a1 * b0
+    mul_karatsuba(z1, sa, sb, m + 1, z1 + 2 * (m + 1));
+    sub_from(z1, 2 * (m + 1), r, 2 * h);
+    sub_from(z1, 2 * (m + 1), r + 2 * h, 2 * m);
+    // z1 fits in n + 1 words, which is always within the top part of the result
+    add_to(r + h, 2 * n - h, z1, n + 1);
+}
+
+// scratch words needed by mul_short for n-word operands
+constexpr uint64_t mul_short_scratch_size(uint64_t n) {
+    if (n < short_mul_threshold) return 0;
+    auto const h = n - n / 2;
+    auto const l = n / 2;
+    return util::max(2 * h + karatsuba_scratch_size(h), l + mul_short_scratch_size(l));
+}
+
+// r[0, n) = lowest n words of a[0, n) * b[0, n). r can't alias a or b
+// since the result is truncated, we only need the full product of the low halves.
+// the cross products are truncated recursively and the high product is not needed at all
+inline void mul_short(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t n,
+                      uint64_t *t) {
+    if (n < short_mul_threshold) {
+        mul_basecase(r, n, a, n, b, n);
+        return;
+    }
+    auto const h = n - n / 2;
+    auto const l = n / 2;
+    mul_karatsuba(t, a, b, h, t + 2 * h);
+    std::copy(t, t + n, r);
+    mul_short(t, a, b + h, l, t + l);
+    add_to(r + h, l, t, l);
+    mul_short(t, a + h, b, l, t + l);
+    add_to(r + h, l, t, l);
+}
+
+// q[0, na - nb + 1) = a[0, na) / b[0, nb) and r[0, nb) = a[0, na) % b[0, nb)
+// requires na >= nb and b[nb - 1] != 0. t needs to hold at least na + nb + 1 words
+// this is Knuth's Algorithm D (TAOCP Vol 2, 4.3.1) using 64-bit digits
+inline void div_mod_n(uint64_t *q, uint64_t *r, const uint64_t *a, uint64_t na, const uint64_t *b,
+                      uint64_t nb, uint64_t *t) {
+    if (nb == 1) {
+        // short division, one word at a time
+        __uint128_t rem = 0;
+        for (uint64_t i = na; i > 0; i--) {
+            auto v = (rem << 64) | a[i - 1];
+            q[i - 1] = static_cast<uint64_t>(v / b[0]);
+            rem = v % b[0];
+        }
+        r[0] = static_cast<uint64_t>(rem);
+        return;
+    }
+
+    // normalize so that the top bit of the divisor is set. this keeps the estimated
+    // quotient digit off by at most 2
+    auto const shift = static_cast<uint64_t>(__builtin_clzll(b[nb - 1]));
+    auto *un = t;
+    auto *vn = t + na + 1;
+    if (shift == 0) {
+        std::copy(a, a + na, un);
+        un[na] = 0;
+        std::copy(b, b + nb, vn);
+    } else {
+        un[na] = a[na - 1] >> (64 - shift);
+        for (uint64_t i = na - 1; i > 0; i--) {
+            un[i] = (a[i] << shift) | (a[i - 1] >> (64 - shift));
+        }
+        un[0] = a[0] << shift;
+        for (uint64_t i = nb - 1; i > 0; i--) {
+            vn[i] = (b[i] << shift) | (b[i - 1] >> (64 - shift));
+        }
+        vn[0] = b[0] << shift;
+    }
+
+    auto const v_hi = vn[nb - 1];
+    auto const v_lo = vn[nb - 2];
+    for (uint64_t jj = na - nb + 1; jj > 0; jj--) {
+        auto const j = jj - 1;
+        // estimate the quotient digit from the top two words
+        auto const num = (static_cast<__uint128_t>(un[j + nb]) << 64) | un[j + nb - 1];
+        auto q_hat = num / v_hi;
+        auto r_hat = num % v_hi;
+        while ((q_hat >> 64) || q_hat * v_lo > ((r_hat << 64) | un[j + nb - 2])) {
+            q_hat--;
+            r_hat += v_hi;
+            if (r_hat >> 64) break;
+        }
+
+        // multiply and subtract
+        __int128_t borrow = 0;
+        __int128_t diff;
+        for (uint64_t i = 0; i < nb; i++) {
+            auto p = q_hat * vn[i];
+            diff = static_cast<__int128_t>(un[i + j]) - borrow - static_cast<uint64_t>(p);
+            un[i + j] = static_cast<uint64_t>(diff);
+            borrow = static_cast<__int128_t>(p >> 64) - (diff >> 64);
+        }
+        diff = static_cast<__int128_t>(un[j + nb]) - borrow;
+        un[j + nb] = static_cast<uint64_t>(diff);
+
+        if (diff < 0) [[unlikely]] {
+            // estimation was one too large. add it back
+            q_hat--;
+            un[j + nb] += add_n(un + j, un + j, vn, nb);
+        }
+        q[j] = static_cast<uint64_t>(q_hat);
+    }
+
+    // un-normalize the remainder
+    if (shift == 0) {
+        std::copy(un, un + nb, r);
+    } else {
+        for (uint64_t i = 0; i < nb - 1; i++) {
+            r[i] = (un[i] >> shift) | (un[i + 1] << (64 - shift));
+        }
+        r[nb - 1] = un[nb - 1] >> shift;
+    }
+}
+
+// base^e[0, n) mod 2^64, by squaring from the least significant bit
+constexpr uint64_t pow_n(uint64_t base, const uint64_t *e, uint64_t n) {
+    while (n > 0 && e[n - 1] == 0) n--;
+    uint64_t result = 1;
+    for (uint64_t i = 0; i < n; i++) {
+        auto v = e[i];
+        for (auto j = 0; j < 64; j++) {
+            if (v & 1) result *= base;
+            v >>= 1;
+            if (!v && i + 1 == n) return result;
+            base *= base;
+            // there is at least one more bit set
+            if (base == 0) return 0;
+            if (base == 1) return result;
+        }
+    }
+    return result;
+}
+
+}  // namespace util
+
 template <uint64_t size, bool signed_>
 struct big_num {
 public:
@@ -79,31 +500,29 @@ public:
     template <uint64_t a, uint64_t b>
     requires(util::max(a, b) < size) big_num<util::abs_diff(a, b) + 1, false>
     inline slice() const {
-        if constexpr (size <= util::max(a, b)) {
-            // out of bound access
-            return big_num<util::abs_diff(a, b) + 1>(0);
-        }
-
-        big_num<util::abs_diff(a, b) + 1, false> res;
-        constexpr auto max = util::max(a, b);
         constexpr auto min = util::min(a, b);
-        for (uint64_t i = min; i <= max; i++) {
-            auto idx = i - min;
-            res.set(idx, this->operator[](i));
+        constexpr auto target_size = util::abs_diff(a, b) + 1;
+        big_num<target_size, false> res;
+        if constexpr (min % big_num_threshold == 0) {
+            // word aligned, just copy
+            constexpr auto offset = min / big_num_threshold;
+            std::copy(values.begin() + offset, values.begin() + offset + res.s, res.values.begin());
+            res.mask_off();
+        } else {
+            // everything is known at compile time so this unrolls into shifts and masks
+            util::extract_bits(res.values.data(), values.data(), s, min, target_size);
         }
         return res;
     }
 
-    // this is inefficient since we don't know what the values are during runtime
     template <uint32_t target_size>
     big_num<target_size, false> slice(uint64_t a, uint64_t b) const {
         auto start = util::min(a, b);
         auto end = util::max(a, b);
         big_num<target_size, false> result;
-
-        for (auto i = start; i <= end; i++) {
-            result.set(i - start, get(i));
-        }
+        // bits past the end are 0
+        util::extract_bits(result.values.data(), values.data(), s, start,
+                           util::min<uint64_t>(end - start + 1, target_size));
         return result;
     }
 
@@ -114,9 +533,7 @@ public:
             for (auto i = 0ul; i < s; i++) result.values[i] = values[i];
             // based on the sign, need to fill out leading ones
             if constexpr (signed_) {
-                for (uint64_t i = size; i < op_size; i++) {
-                    result.set(i, true);
-                }
+                if (negative()) result.fill_high(size);
             }
             return result;
         } else {
@@ -135,16 +552,14 @@ public:
             result.values[i] = num.values[i];
         }
         // then copy over the current on
-        for (auto i = ss; i < final_size; i++) {
-            auto idx = i - ss;
-            result.set(i, get(idx));
-        }
+        util::insert_bits(result.values.data(), result.s, ss, size, values.data(), s);
 
         return result;
     }
 
     [[maybe_unused]] [[nodiscard]] uint64_t popcount() const {
-        return std::accumulate(values.begin(), values.end(), std::popcount);
+        return std::transform_reduce(values.begin(), values.end(), uint64_t{0}, std::plus<>(),
+                                     [](auto v) { return std::popcount(v); });
     }
 
     void mask_off() {
@@ -170,9 +585,7 @@ public:
             result.values[i] = ~values[i];
         }
         // mask off the top bit, if any
-        for (auto i = size; i < s * big_num_threshold; i++) {
-            result.set(i, false);
-        }
+        result.mask_off();
         return result;
     }
 
@@ -298,39 +711,41 @@ public:
 
     // reduction
     [[maybe_unused]] [[nodiscard]] bool r_and() const {
-        // only if all the bit are set
-        auto b = std::all_of(values.begin(), values.begin() + s - 1, [](auto const v) {
-            return v == std::numeric_limits<uint64_t>::max();
-        });
-        if constexpr (values.size() * 8 == size) {
-            return b;
-        } else {
-            if (b) return false;
-
-            for (uint64_t i = (values.size() - 1); i < s; i++) {
-                if (!get(i)) return false;
-            }
+        // all ones, with only the used bits of the top word
+        for (uint64_t i = 0; i < s - 1; i++) {
+            if (values[i] != std::numeric_limits<big_num_holder_type>::max()) return false;
         }
-        return true;
+        return values[s - 1] == util::tail_mask(size);
     }
 
     [[maybe_unused]] [[nodiscard]] bool r_xor() const {
-        bool b = get<0>();
-        for (auto i = 1u; i < size; i++) {
-            b = b ^ get(i);
-        }
-        return b;
+        // parity of the XOR-folded words. unused bits are always 0
+        auto fold = std::reduce(values.begin(), values.end(), big_num_holder_type{0},
+                                [](auto a, auto b) { return a ^ b; });
+        return std::popcount(fold) & 1;
     }
 
     big_num<size, signed_> operator>>(uint64_t amount) const {
         // we will implement logic shifts regardless of the sign
         big_num<size, signed_> res;
-        if (amount > size) [[unlikely]]
+        if (amount >= size) [[unlikely]]
             return res;
-        for (uint64_t i = amount; i < size; i++) {
-            auto dst = i - amount;
-            res.set(dst, get(i));
+        // whole word moves plus a two-word funnel shift for the remaining bits
+        auto const word_shift = amount / big_num_threshold;
+        auto const bit_shift = amount % big_num_threshold;
+        auto const num_words = s - word_shift;
+        if (bit_shift == 0) {
+            for (uint64_t i = 0; i < num_words; i++) {
+                res.values[i] = values[i + word_shift];
+            }
+        } else {
+            for (uint64_t i = 0; i < num_words - 1; i++) {
+                res.values[i] = (values[i + word_shift] >> bit_shift) |
+                                (values[i + word_shift + 1] << (big_num_threshold - bit_shift));
+            }
+            res.values[num_words - 1] = values[s - 1] >> bit_shift;
         }
+        // unused bits are always 0, so no need to mask off
         return res;
     }
 
@@ -351,12 +766,23 @@ public:
     big_num<size, signed_> operator<<(uint64_t amount) const {
         // we will implement logic shifts regardless of the sign
         big_num<size, signed_> res;
-        if (amount > size) [[unlikely]]
+        if (amount >= size) [[unlikely]]
             return res;
-        for (uint64_t i = 0u; i < (size - amount); i++) {
-            auto dst = i + amount;
-            res.set(dst, get(i));
+        // whole word moves plus a two-word funnel shift for the remaining bits
+        auto const word_shift = amount / big_num_threshold;
+        auto const bit_shift = amount % big_num_threshold;
+        if (bit_shift == 0) {
+            for (uint64_t i = word_shift; i < s; i++) {
+                res.values[i] = values[i - word_shift];
+            }
+        } else {
+            res.values[word_shift] = values[0] << bit_shift;
+            for (uint64_t i = word_shift + 1; i < s; i++) {
+                res.values[i] = (values[i - word_shift] << bit_shift) |
+                                (values[i - word_shift - 1] >> (big_num_threshold - bit_shift));
+            }
         }
+        res.mask_off();
         return res;
     }
 
@@ -385,15 +811,10 @@ public:
                 }
                 return res;
             }
-            // set high bit
-            bool negative = this->negative();
-            for (uint64_t i = 0; i < amount; i++) {
-                auto dst = size - i - 1;
-                res.set(dst, negative);
-            }
-            for (uint64_t i = amount; i < (size - 1); i++) {
-                auto dst = i - amount;
-                res.set(dst, get(i));
+            res = (*this) >> amount;
+            // sign fill the vacated high bits
+            if (negative()) {
+                res.fill_high(size - amount);
             }
             return res;
         } else {
@@ -450,8 +871,8 @@ public:
                 }
                 return true;
             } else {
-                auto op_t = op->template extend<size>();
-                for (auto i = 0u; i < size; i++) {
+                auto op_t = op.template extend<size>();
+                for (auto i = 0u; i < s; i++) {
                     if (values[i] != op_t.values[i]) return false;
                 }
                 return true;
@@ -466,7 +887,7 @@ public:
                 return true;
             } else {
                 // the rest has to be zero
-                return std::reduce(values.begin() + op_s, values.end(), 0,
+                return std::reduce(values.begin() + op_s, values.end(), big_num_holder_type{0},
                                    [](auto a, auto b) { return a | b; }) == 0;
             }
         } else {
@@ -474,7 +895,7 @@ public:
                 if (values[i] != op.values[i]) return false;
             }
             // the rest has to be zero
-            return std::reduce(op.values.begin() + s, op.values.end(), 0,
+            return std::reduce(op.values.begin() + s, op.values.end(), big_num_holder_type{0},
                                [](auto a, auto b) { return a | b; }) == 0;
         }
         return true;
@@ -573,17 +994,24 @@ public:
     big_num<size, util::signed_result(signed_, op_signed)> operator+(
         const big_num<size, op_signed> &op) const {
         big_num<size, util::signed_result(signed_, op_signed)> result;
-        // based on the compiler explorer, using 128 bit is the "best" implementation
-        // "best" as in the fewest instructions
-        __uint128_t carry = 0;
-        for (auto i = 0u; i < s; i++) {
-            auto v = carry + values[i] + op.values[i];
-            result.values[i] = (v << 64) >> 64;
-            carry = v >> 64;
-        }
+        util::add_n(result.values.data(), values.data(), op.values.data(), s);
+        result.mask_off();
         return result;
     }
 
+    template <uint64_t op_size, bool op_signed>
+    big_num &operator+=(const big_num<op_size, op_signed> &op) {
+        if constexpr (op_size > size) {
+            util::add_n(values.data(), values.data(), op.values.data(), s);
+        } else {
+            // carry and sign extension of the shorter operand
+            auto const r = op.template extend<size>();
+            util::add_n(values.data(), values.data(), r.values.data(), s);
+        }
+        mask_off();
+        return *this;
+    }
+
     template <uint64_t target_size, uint64_t op_size, bool op_signed>
     requires(target_size >=
              util::max(size, op_size)) auto add(const big_num<op_size, op_signed> &op) const {
@@ -602,8 +1030,34 @@ public:
     template <bool op_signed>
     big_num<size, util::signed_result(signed_, op_signed)> operator-(
         const big_num<size, op_signed> &op) const {
-        auto neg = op.negate();
-        return (*this) + neg;
+        big_num<size, util::signed_result(signed_, op_signed)> result;
+        util::sub_n(result.values.data(), values.data(), op.values.data(), s);
+        result.mask_off();
+        return result;
+    }
+
+    template <uint64_t op_size, bool op_signed>
+    big_num &operator-=(const big_num<op_size, op_signed> &op) {
+        if constexpr (op_size > size) {
+            util::sub_n(values.data(), values.data(), op.values.data(), s);
+        } else {
+            auto const r = op.template extend<size>();
+            util::sub_n(values.data(), values.data(), r.values.data(), s);
+        }
+        mask_off();
+        return *this;
+    }
+
+    big_num &operator++() {
+        util::inc_n(values.data(), s);
+        mask_off();
+        return *this;
+    }
+
+    big_num &operator--() {
+        util::dec_n(values.data(), s);
+        mask_off();
+        return *this;
     }
 
     template <uint64_t target_size, uint64_t op_size, bool op_signed>
@@ -631,39 +1085,32 @@ public:
             __uint128_t b = op.values[0];
             __uint128_t c = a * b;
             result.values[0] = (c << 64) >> 64;
-            result.values[1] = c >> 64;
+            if constexpr (s > 1) result.values[1] = c >> 64;
+            result.mask_off();
             return result;
         }
-        // we're not using Karatsuba's algorithm since it can get infinitely recursion or underflow
-        // easily given our current setup
-        // using text book version of multiply, which is O(n^2)
-        // we use __uint128 for speed up
-        big_num<size, false> temp;
-        for (uint64_t i = 0; i < s; i++) {
-            if (values[i] == 0) continue;
-            for (uint j = 0; j < s; j++) {
-                // deal with special cases
-                if (op.values[j] == 0) continue;
-                __uint128_t a = values[i];
-                __uint128_t b = op.values[j];
-                __uint128_t c = a * b;
-                uint64_t hi = c >> 64u;
-                uint64_t lo = (c << 64u) >> 64;
-
-                if ((i + j) < size) {
-                    temp.values[i + j] = lo;
-                    result = result + temp;
-                    temp.values[i + j] = 0;
-                }
-                if ((i + j + 1) < size) {
-                    temp.values[i + j + 1] = hi;
-                    result = result + temp;
-                    temp.values[i + j + 1] = 0;
-                }
-            }
+        // skip the leading zero words. if either of the operand is short, schoolbook
+        // multiplication is already linear in the number of words of the other one
+        auto const na = used_words();
+        auto const nb = op.used_words();
+        constexpr auto h = (s + 1) / 2;
+        if (h >= karatsuba_threshold && util::max(na, nb) <= h && util::min(na, nb) > h - h / 4) {
+            // both operands fill most of the low half, e.g. they were extended to twice their
+            // width, so this is a full product of the low halves. an odd s has one word more
+            // than the result holds
+            std::array<big_num_holder_type, 2 * h + util::karatsuba_scratch_size(h)> t;
+            util::mul_karatsuba(t.data(), values.data(), op.values.data(), h, t.data() + 2 * h);
+            std::copy_n(t.begin(), s, result.values.begin());
+        } else if (util::min(na, nb) < short_mul_threshold) {
+            util::mul_basecase(result.values.data(), s, values.data(), na, op.values.data(), nb);
+        } else {
+            // two's complement truncated product is the same as the unsigned one
+            std::array<big_num_holder_type, util::mul_short_scratch_size(s)> scratch;
+            util::mul_short(result.values.data(), values.data(), op.values.data(), s,
+                            scratch.data());
         }
-        auto res = result;
-        return res;
+        result.mask_off();
+        return result;
     }
 
     template <uint64_t target_size, uint64_t op_size, bool op_signed>
@@ -718,40 +1165,50 @@ public:
         return result;
     }
 
-    template <uint64_t target_size, uint64_t op_size, bool op_signed>
-    requires(target_size >=
-             util::max(size, op_size)) auto power(const big_num<op_size, op_signed> &op) const {
-        // resize things to target size
-        auto l = this->template extend<target_size>();
-        // power by squaring
-        // https://en.wikipedia.org/wiki/Exponentiation_by_squaring
-        // TODO:
-        //  IMPLEMENT LRM Table 11-4
-        big_num<target_size, util::signed_result(signed_, op_signed)> result;
-        if (op.is_one()) {
-            return l;
-        } else if (!any_set()) {
-            // ill-defined. use 0
-            // or raise zero to some number, which is zero as well
-            return result;
-        } else if (!op.any_set()) {
-            result.values[0] = 1u;
-            return result;
+    // power operator following LRM Table 11-4, truncated to size. 0 to a negative power is x,
+    // which becomes 0 here; 4-state callers need to check for it
+    template <uint64_t op_size, bool op_signed>
+    [[nodiscard]] big_num<size, signed_> pow(const big_num<op_size, op_signed> &op) const {
+        big_num<size, signed_> result;
+        if constexpr (op_signed) {
+            if (op.negative()) {
+                // only 1 and -1 don't round to 0
+                if (is_one()) {
+                    result.values[0] = 1;
+                } else if (signed_ && all_set()) {
+                    if (op.values[0] & 1) {
+                        result.mask();
+                    } else {
+                        result.values[0] = 1;
+                    }
+                }
+                return result;
+            }
         }
-
-        if (op.values[0] % 2 == 0) {
-            return (l * l).power(op / 2);
-        } else {
-            // recursion
-            return (*this) * (l * l).power((op - 1) / 2);
+        result.values[0] = 1;
+        if (!op.any_set()) return result;
+        auto const bits = op.highest_bit() + 1;
+        auto base = *this;
+        for (uint64_t i = 0; i < bits; i++) {
+            if (op[i]) result = result * base;
+            if (i + 1 == bits) break;
+            base = base * base;
+            // remaining bits include the msb
+            if (!base.any_set()) [[unlikely]] {
+                result.unmask();
+                break;
+            } else if (base.is_one()) [[unlikely]] {
+                break;
+            }
         }
+        return result;
     }
 
     [[nodiscard]] big_num<size, signed_> negate() const {
         // 2's complement
-        big_num<size, signed_> result = ~(*this);
-        constexpr static auto v = big_num<size>(1ul);
-        result = result + v;
+        big_num<size, signed_> result;
+        util::neg_n(result.values.data(), values.data(), s);
+        result.mask_off();
         return result;
     }
 
@@ -771,11 +1228,14 @@ public:
         // we use the fact that SIMD instructions are faster than compare and branch
         // so summation is faster than any_of in theory
         // also all unused bit are set to 0 by default
-        auto r = std::reduce(values.begin(), values.end(), 0, [](auto a, auto b) { return a | b; });
+        // a plain loop rather than std::reduce, which GCC neither unrolls nor vectorizes as well
+        // for a fixed number of words
+        big_num_holder_type r = 0;
+        for (auto v : values) r |= v;
         return r != 0;
     }
 
-    [[maybe_unused]] void mask() {
+    [[maybe_unused]] constexpr void mask() {
         for (auto i = 0u; i < (s - 1); i++) {
             values[i] = std::numeric_limits<big_num_holder_type>::max();
         }
@@ -786,8 +1246,21 @@ public:
 
     [[maybe_unused]] void unmask() { std::fill(values.begin(), values.end(), 0); }
 
+    // set every bit in [start, size) to 1
+    void fill_high(uint64_t start) {
+        if (start >= size) return;
+        auto const a = start / big_num_threshold;
+        auto const b = start % big_num_threshold;
+        values[a] |= std::numeric_limits<big_num_holder_type>::max() << b;
+        for (auto i = a + 1; i < s; i++) {
+            values[i] = std::numeric_limits<big_num_holder_type>::max();
+        }
+        mask_off();
+    }
+
     [[nodiscard]] bool all_set() const {
-        auto v = std::reduce(values.begin(), values.begin() + s - 1, 0,
+        auto v = std::reduce(values.begin(), values.begin() + s - 1,
+                             std::numeric_limits<big_num_holder_type>::max(),
                              [](auto a, auto b) { return a & b; });
         auto constexpr max =
             std::numeric_limits<big_num_holder_type>::max() >> (s * big_num_threshold - size);
@@ -806,16 +1279,25 @@ public:
         if constexpr (s == 1) {
             return values[0] == 1u;
         } else {
-            return values[0] == 1u && (std::reduce(values.begin() + 1, values.end(), 0,
+            return values[0] == 1u && (std::reduce(values.begin() + 1, values.end(),
+                                                   big_num_holder_type{0},
                                                    [](auto a, auto b) { return a | b; }) == 0u);
         }
     }
 
+    // number of words up to the highest non-zero one
+    [[nodiscard]] uint64_t used_words() const {
+        auto n = s;
+        while (n > 0 && values[n - 1] == 0) n--;
+        return n;
+    }
+
     [[nodiscard]] bool fit_in_64() const {
-        return std::reduce(values.begin() + 1, values.end(), 0,
+        return std::reduce(values.begin() + 1, values.end(), big_num_holder_type{0},
                            [](auto a, auto b) { return a | b; }) == 0;
     }
 
+    // computes quotient and remainder in one go
     template <bool op_signed>
     std::pair<big_num<size, util::signed_result(signed_, op_signed)>,
               big_num<size, util::signed_result(signed_, op_signed)>>
@@ -831,14 +1313,14 @@ public:
         }
         if constexpr (result_signed) {
             // this implies that both of them are signed numbers
-            auto op_pos = op.negative() ? op.negate() : op;
-            auto this_pos = negative() ? negate() : *this;
-            std::tie(q, r) = this_pos.div_mode_(op);
-            // if both of them are negative or positive, the sign will cancel out
-            if (op.negative() ^ negative()) {
-                q = q.negate();
-                r = r.negate();
-            }
+            // quotient is truncated towards zero and the remainder takes the sign of the dividend
+            auto const this_negative = negative();
+            auto const op_negative = op.negative();
+            big_num<size, false> op_pos = op_negative ? op.negate() : op;
+            big_num<size, false> this_pos = this_negative ? negate() : *this;
+            auto [q_pos, r_pos] = this_pos.div_mod_unsigned(op_pos);
+            q = this_negative ^ op_negative ? q_pos.negate() : q_pos;
+            r = this_negative ? r_pos.negate() : r_pos;
         } else {
             std::tie(q, r) = div_mod_unsigned(op);
         }
@@ -846,36 +1328,26 @@ public:
     }
 
     std::pair<big_num<size, false>, big_num<size, false>> div_mod_unsigned(
-        const big_num<size, false> &op) const requires(!signed_) {
-        // deal with some special cases
-        if (op.is_one()) {
+        const big_num<size, false> &op) const {
+        // deal with some special cases. dividing by zero gives 0 and 0, the same as div_mod
+        if (!op.any_set()) [[unlikely]] {
+            return std::make_pair(big_num<size, false>{0u}, big_num<size, false>{0u});
+        } else if (op.is_one()) {
             return std::make_pair(*this, big_num<size, false>{0u});
-        } else if ((*this) == op) {
-            return std::make_pair(big_num<size, false>{1u}, big_num<size, false>{0u});
         } else if ((*this) < op) {
             return std::make_pair(big_num<size, false>{0u}, *this);
-        } else if (fit_in_64() && op.fit_in_64()) {
+        } else if (fit_in_64()) {
+            // the divisor has to fit as well
             auto q = values[0] / op.values[0];
             auto r = values[0] % op.values[0];
             return std::make_pair(big_num<size, false>{q}, big_num<size, false>{r});
         }
 
-        // code to figure out the set bit
-        auto const this_hi_bit = highest_bit();
-        auto const op_hi_bit = op.highest_bit();
-        auto const diff_bits = this_hi_bit - op_hi_bit;
-
         big_num<size, false> q;
-        big_num<size, false> r = *this;
-        for (auto i = 0u; i <= diff_bits; i++) {
-            // shift r to the correct bit, could be too big
-            auto t = op << (diff_bits - i);
-            if (r >= t) {
-                r = r - t;
-                q.set(diff_bits - i, true);
-            }
-        }
-
+        big_num<size, false> r;
+        std::array<big_num_holder_type, 2 * s + 1> scratch;
+        util::div_mod_n(q.values.data(), r.values.data(), values.data(), used_words(),
+                        op.values.data(), op.used_words(), scratch.data());
         return std::make_pair(q, r);
     }
 
@@ -901,7 +1373,7 @@ public:
 
     template <typename T>
     requires std::is_arithmetic_v<T>
-    explicit constexpr big_num(T v) : values({v}) {
+    explicit constexpr big_num(T v) : values({static_cast<big_num_holder_type>(v)}) {
         if constexpr (signed_) {
             if (v < 0) {
                 for (auto i = 1u; i < s; i++) {
@@ -924,6 +1396,18 @@ public:
 private:
     [[nodiscard]] bool get(uint64_t idx) const { return operator[](idx); }
 };
+namespace util {
+// word at a time copy of src[start, end] into the bottom of dst
+template <uint64_t dst_size, bool dst_signed, uint64_t src_size, bool src_signed>
+void copy(big_num<dst_size, dst_signed> &dst, const big_num<src_size, src_signed> &src,
+          uint64_t start, uint64_t end) {
+    auto const count = util::min(end - start + 1, dst_size);
+    std::array<uint64_t, big_num<dst_size, dst_signed>::s> bits;
+    extract_bits(bits.data(), src.values.data(), src.s, start, count);
+    insert_bits(dst.values.data(), dst.s, 0, count, bits.data(), bits.size());
+}
+}  // namespace util
+
 }  // namespace logic
 
 #endif  // LOGIC_BIG_NUM_HH
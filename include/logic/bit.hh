@@ -25,21 +25,31 @@ public:
 
     T value;
 
+    template <int, int, bool, bool>
+    friend struct bit;
+
     // basic formatting
     [[nodiscard]] std::string str(std::string_view fmt = "b") const {
+        std::string result(util::format_size(fmt, size), '\0');
+        auto *end = format_to(result.data(), result.data() + result.size(), fmt);
+        result.resize(end - result.data());
+        return result;
+    }
+
+    // formats into [first, last) without allocating. returns the end of the output, or nullptr if
+    // it doesn't fit
+    char *format_to(char *first, char *last, std::string_view fmt = "b") const {
+        return format_to(first, last, util::parse_format_spec(fmt));
+    }
+
+    char *format_to(char *first, char *last, util::format_spec spec) const {
+        if (util::decimal_fmt(spec)) return format_decimal_to(first, last, spec);
         if constexpr (native_num) {
-            if (signed_ && negative() && util::decimal_fmt(fmt)) {
-                return util::to_string(fmt, size, negate().value, true);
-            } else {
-                return util::to_string(fmt, size, value, false);
-            }
+            uint64_t v = value;
+            return util::format_to(first, last, spec, size, &v, nullptr, false, nullptr);
         } else {
-            if (signed_ && negative() && util::decimal_fmt(fmt)) {
-                auto neg = negate();
-                return util::to_string(fmt, size, neg.value.values.data(), true);
-            } else {
-                return util::to_string(fmt, size, value.values.data(), false);
-            }
+            return util::format_to(first, last, spec, size, value.values.data(), nullptr, false,
+                                   nullptr);
         }
     }
 
@@ -137,7 +147,9 @@ public:
      * relates to whether it's negative or not
      */
     [[nodiscard]] bool negative() const {
-        if constexpr (native_num) {
+        if constexpr (!signed_) {
+            return false;
+        } else if constexpr (native_num) {
             return value < 0;
         } else {
             return value.negative();
@@ -233,7 +245,9 @@ public:
     template <uint64_t target_size>
     requires(target_size < size)
         [[nodiscard]] constexpr bit<target_size - 1, 0, signed_> extend() const {
-        return slice<target_size - 1, 0>();
+        bit<target_size - 1, 0, signed_> result;
+        result.value = slice<target_size - 1, 0>().value;
+        return result;
     }
 
     // native number, but extend to a big number
@@ -269,30 +283,43 @@ public:
     /*
      * concatenation
      */
-    template <int arg0_msb, int arg0_lsb, bool arg0_signed>
-    auto concat(const bit<arg0_msb, arg0_lsb, arg0_signed> &arg0) {
-        auto constexpr arg0_size = bit<arg0_msb, arg0_lsb>::size;
-        auto constexpr final_size = size + arg0_size;
-        if constexpr (final_size < big_num_threshold) {
-            return bit<final_size - 1>(value << arg0_size | arg0.value);
+    // the final width is known up front, so every operand is written straight into its place in
+    // the result instead of going through pairwise temporaries
+    template <typename U, typename... Ts>
+    [[nodiscard]] auto concat(const U &arg0, const Ts &...args) const {
+        if constexpr (U::is_4state || (Ts::is_4state || ...)) {
+            // any 4-state operand turns the result into a logic
+            return logic<size - 1, 0>(*this).concat(arg0, args...);
         } else {
-            auto res = bit<final_size - 1>();
-            if constexpr (bit<arg0_msb, arg0_lsb>::native_num) {
-                // convert to big num
-                big_num<arg0_size, false> b(arg0.value);
-                auto big_num = value.concat(b);
-                res.big_num = big_num;
-            } else {
-                auto big_num = value.concat(arg0.value);
-                res.big_num = big_num;
-            }
-            return res;
+            return concat_(arg0, args...);
         }
     }
 
-    template <typename U, typename... Ts>
-    auto concat(U arg0, Ts... args) {
-        return concat(arg0).concat(args...);
+    /*
+     * streaming operators
+     */
+    // {<<slice{this}}
+    template <uint64_t slice = 1>
+    requires(slice > 0) [[nodiscard]] bit<size - 1, 0> stream_left() const {
+        bit<size - 1, 0> result;
+        if constexpr (native_num) {
+            auto const v = native_bits(*this);
+            uint64_t r;
+            util::stream_left_n<slice>(&r, &v, 1, size);
+            result.value = static_cast<typename bit<size - 1, 0>::T>(r);
+        } else {
+            util::stream_left_n<slice>(result.value.values.data(), value.values.data(), value.s,
+                                       size);
+        }
+        return result;
+    }
+
+    // {>>slice{this}}, which keeps the bit order as is
+    template <uint64_t slice = 1>
+    requires(slice > 0) [[nodiscard]] bit<size - 1, 0> stream_right() const {
+        bit<size - 1, 0> result;
+        result.insert_(0, size, *this);
+        return result;
     }
 
     /*
@@ -317,7 +344,7 @@ public:
 
     [[nodiscard]] uint64_t popcount() const {
         if constexpr (native_num) {
-            return std::popcount(value);
+            return std::popcount(static_cast<uint64_t>(value) & util::tail_mask(size));
         } else {
             return value.popcount();
         }
@@ -458,11 +485,12 @@ public:
 
     // reduction
     [[nodiscard]] bool r_and() const requires(native_num) {
-        auto constexpr max = std::numeric_limits<T>::max() >> (sizeof(T) * 8 - size);
-        return value == max;
+        // signed holders are sign extended, so only look at the used bits
+        auto constexpr max = util::tail_mask(size);
+        return (static_cast<uint64_t>(value) & max) == max;
     }
 
-    [[nodiscard]] bool r_and() const requires(!native_num) { return value.r_xor(); }
+    [[nodiscard]] bool r_and() const requires(!native_num) { return value.r_and(); }
 
     [[maybe_unused]] [[nodiscard]] bool r_nand() const { return !r_and(); }
 
@@ -471,11 +499,7 @@ public:
     [[maybe_unused]] [[nodiscard]] bool r_nor() const { return !r_or(); }
 
     [[nodiscard]] bool r_xor() const requires(native_num) {
-        bool b = get<0>();
-        for (auto i = 1; i < size; i++) {
-            b = b ^ get(i);
-        }
-        return b;
+        return std::popcount(static_cast<uint64_t>(value) & util::tail_mask(size)) & 1;
     }
 
     [[nodiscard]] bool r_xor() const requires(!native_num) { return value.r_xor(); }
@@ -505,12 +529,22 @@ public:
     }
 
     auto &operator++() {
-        (*this) = (*this) + one_();
+        if constexpr (native_num) {
+            value++;
+            mask_off();
+        } else {
+            ++value;
+        }
         return *this;
     }
 
     auto &operator--() {
-        (*this) = (*this) - one_();
+        if constexpr (native_num) {
+            value--;
+            mask_off();
+        } else {
+            --value;
+        }
         return *this;
     }
 
@@ -543,7 +577,10 @@ public:
         // 1. both of them are native number
         // clang doesn't allow accessing native_num as amount.native_num
         // see https://stackoverflow.com/a/44996066
-        if constexpr (native_num && bit<op_msb, op_lsb>::native_num) {
+        if constexpr (size == 1 && bit<op_msb, op_lsb>::native_num) {
+            // any shift moves the only bit out
+            res.value = value && !amount.value;
+        } else if constexpr (native_num && bit<op_msb, op_lsb>::native_num) {
             res.value = value << static_cast<T>(amount.value);
         } else if constexpr ((!native_num)) {
             res.value = value << amount.value;
@@ -703,7 +740,9 @@ public:
         if constexpr (native_num) {
             return bit<msb, lsb, signed_>(-value);
         } else {
-            return bit<msb, lsb, signed_>(value.negate());
+            bit<msb, lsb, signed_> res;
+            res.value = value.negate();
+            return res;
         }
     }
 
@@ -727,6 +766,20 @@ public:
         return result;
     }
 
+    // in-place, the result is truncated to the size of this
+    template <int op_msb, int op_lsb, bool op_signed>
+    bit &operator+=(const bit<op_msb, op_lsb, op_signed> &op) {
+        if constexpr (native_num) {
+            value += op.template extend<size>().value;
+            mask_off();
+        } else if constexpr (bit<op_msb, op_lsb>::size < size) {
+            value += op.template extend<size>().value;
+        } else {
+            value += op.value;
+        }
+        return *this;
+    }
+
     template <uint64_t target_size, int op_msb, int op_lsb, bool op_signed>
     requires(target_size >= util::max(size, bit<op_msb, op_lsb>::size)) auto add(
         const bit<op_msb, op_lsb, op_signed> &op) const {
@@ -751,6 +804,19 @@ public:
         return result;
     }
 
+    template <int op_msb, int op_lsb, bool op_signed>
+    bit &operator-=(const bit<op_msb, op_lsb, op_signed> &op) {
+        if constexpr (native_num) {
+            value -= op.template extend<size>().value;
+            mask_off();
+        } else if constexpr (bit<op_msb, op_lsb>::size < size) {
+            value -= op.template extend<size>().value;
+        } else {
+            value -= op.value;
+        }
+        return *this;
+    }
+
     template <uint64_t target_size, int op_msb, int op_lsb, bool op_signed>
     requires(target_size >= util::max(size, bit<op_msb, op_lsb>::size)) auto minus(
         const bit<op_msb, op_lsb, op_signed> &op) const {
@@ -771,7 +837,11 @@ public:
     template <int op_lsb, bool op_signed>
     auto operator*(const bit<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
         bit<size - 1, 0, util::signed_result(signed_, op_signed)> result;
-        result.value = value * op.value;
+        if constexpr (size == 1) {
+            result.value = value && op.value;
+        } else {
+            result.value = value * op.value;
+        }
         return result;
     }
 
@@ -833,6 +903,72 @@ public:
         return result;
     }
 
+    // quotient and remainder from a single division
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(bit<op_msb, op_lsb>::size != size) auto div_mod(
+        const bit<op_msb, op_lsb, op_signed> &op) const {
+        auto constexpr target_size = util::max(size, bit<op_msb, op_lsb>::size);
+        auto l = this->template extend<target_size>();
+        auto r = op.template extend<target_size>();
+        return l.div_mod(r);
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto div_mod(const bit<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        using result_type = bit<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        std::pair<result_type, result_type> result;
+        if constexpr (native_num) {
+            // divide by zero is 0, same as big numbers
+            if (op.value != 0) [[likely]] {
+                result.first.value = value / op.value;
+                result.second.value = value % op.value;
+            }
+        } else {
+            std::tie(result.first.value, result.second.value) = value.div_mod(op.value);
+        }
+        return result;
+    }
+
+    // power operator (**) following LRM Table 11-4. the result has the size and sign of the
+    // base since the exponent is self-determined
+    template <int op_msb, int op_lsb, bool op_signed>
+    [[nodiscard]] bit<size - 1, 0, signed_> pow(const bit<op_msb, op_lsb, op_signed> &op) const {
+        bit<size - 1, 0, signed_> result;
+        if constexpr (native_num) {
+            auto const base = native_bits(*this);
+            // the low word of the exponent, and whether there is more. native bases never need
+            // more than that: an odd base has an order dividing 2^62 mod 2^64, so only the low
+            // word matters, and an even one is 0 from the 64th power on
+            uint64_t e;
+            bool huge = false;
+            if constexpr (bit<op_msb, op_lsb>::native_num) {
+                e = native_bits(op);
+            } else {
+                e = op.value.values[0];
+                huge = !op.value.fit_in_64();
+            }
+            if (op_signed && op.negative()) {
+                // 0 to a negative power is x, which is 0 in 2-state
+                auto constexpr minus_one = std::numeric_limits<uint64_t>::max() >> (64 - size);
+                uint64_t r = 0;
+                if (base == 1) {
+                    r = 1;
+                } else if (signed_ && base == minus_one) {
+                    r = (e & 1) ? minus_one : 1;
+                }
+                result.value = static_cast<T>(r);
+            } else if (huge && !(base & 1)) {
+                result.value = 0;
+            } else {
+                result.value = static_cast<T>(util::pow_n(base, &e, 1));
+            }
+            result.mask_off();
+        } else {
+            result.value = value.pow(big_bits(op));
+        }
+        return result;
+    }
+
     [[nodiscard]] bit<size - 1, 0, true> to_signed() const {
         bit<size - 1, 0, true> res;
         if constexpr (native_num) {
@@ -872,7 +1008,7 @@ public:
 
     [[nodiscard]] bool any_set() const requires(!native_num) { return value.any_set(); }
 
-    void mask() {
+    constexpr void mask() {
         if constexpr (native_num) {
             if constexpr (size == 1) {
                 value = true;
@@ -934,6 +1070,10 @@ public:
     void update(const bit<op_hi, op_lo, op_signed> &op) requires(hi < size && lo < size) {
         auto constexpr start = util::min(hi, lo);
         auto constexpr end = util::max(hi, lo) + 1;
+        if constexpr (word_aligned_update<op_hi, op_lo>()) {
+            insert_(start, end - start, op);
+            return;
+        }
         for (auto i = start; i < end; i++) {
             // notice that if it is out of range, 0 will be returned
             // we need to revert the index accessing scheme here, if the endian doesn't match
@@ -943,7 +1083,7 @@ public:
             } else {
                 idx = i;
             }
-            auto b = op.operator[](idx);
+            auto b = op.operator[](idx - start);
             set(i, b);
         }
     }
@@ -1019,7 +1159,7 @@ public:
         *this = logic.value;
     }
 
-    bit() {
+    constexpr bit() {
         if constexpr (native_num) {
             // init to 0
             value = 0;
@@ -1052,6 +1192,64 @@ public:
     }
 
 private:
+    // decimal digits are the only ones that need scratch space, which is kept out of the stack
+    // frame of the other bases
+    LOGIC_NOINLINE char *format_decimal_to(char *first, char *last, util::format_spec spec) const {
+        std::array<uint64_t, util::format_scratch_words(size)> scratch;
+        if constexpr (signed_) {
+            if (negative()) {
+                auto neg = negate();
+                if constexpr (native_num) {
+                    uint64_t v = neg.value;
+                    return util::format_to(first, last, spec, size, &v, nullptr, true,
+                                           scratch.data());
+                } else {
+                    return util::format_to(first, last, spec, size, neg.value.values.data(),
+                                           nullptr, true, scratch.data());
+                }
+            }
+        }
+        if constexpr (native_num) {
+            uint64_t v = value;
+            return util::format_to(first, last, spec, size, &v, nullptr, false, scratch.data());
+        } else {
+            return util::format_to(first, last, spec, size, value.values.data(), nullptr, false,
+                                   scratch.data());
+        }
+    }
+
+    // raw bits of a native number, without sign extension
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(bit<op_msb, op_lsb>::native_num) static uint64_t
+        native_bits(const bit<op_msb, op_lsb, op_signed> &op) {
+        auto constexpr op_size = bit<op_msb, op_lsb>::size;
+        return static_cast<uint64_t>(op.value) &
+               (std::numeric_limits<uint64_t>::max() >> (64 - op_size));
+    }
+
+    template <typename U, typename... Ts>
+    auto concat_(const U &arg0, const Ts &...args) const {
+        auto constexpr final_size = size + U::size + (Ts::size + ... + 0);
+        bit<final_size - 1, 0> result;
+        auto offset = final_size - size;
+        result.insert_(offset, size, *this);
+        result.insert_(offset -= U::size, U::size, arg0);
+        (result.insert_(offset -= Ts::size, Ts::size, args), ...);
+        return result;
+    }
+
+    // big number view of any number, native or not
+    template <int op_msb, int op_lsb, bool op_signed>
+    static auto big_bits(const bit<op_msb, op_lsb, op_signed> &op) {
+        if constexpr (bit<op_msb, op_lsb>::native_num) {
+            big_num<bit<op_msb, op_lsb>::size, op_signed> result;
+            result.values[0] = native_bits(op);
+            return result;
+        } else {
+            return op.value;
+        }
+    }
+
     /*
      * unpacking, which is basically slicing as syntax sugars
      */
@@ -1178,6 +1376,10 @@ protected:
     void update_(int hi, int lo, const bit<op_msb, op_lsb, op_signed> &op) {
         auto start = util::min(hi, lo);
         auto end = util::max(hi, lo) + 1;
+        if constexpr (word_aligned_update<op_msb, op_lsb>()) {
+            insert_(start, end - start, op);
+            return;
+        }
         for (auto i = start; i < end; i++) {
             // notice that if it is out of range, 0 will be returned
             // we need to revert the index accessing scheme here, if the endian doesn't match
@@ -1192,6 +1394,36 @@ protected:
         }
     }
 
+    // both sides index from bit 0 upwards, so a slice update is a plain bit range copy
+    template <int op_msb, int op_lsb>
+    static constexpr bool word_aligned_update() {
+        return big_endian && util::min(msb, lsb) == 0 && bit<op_msb, op_lsb>::big_endian &&
+               util::min(op_msb, op_lsb) == 0;
+    }
+
+    // bits [start, start + count) = bits [0, count) of op, zero extended
+    template <int op_msb, int op_lsb, bool op_signed>
+    void insert_(uint64_t start, uint64_t count, const bit<op_msb, op_lsb, op_signed> &op) {
+        if (start >= size) [[unlikely]] return;
+        count = util::min<uint64_t>(count, size - start);
+        if constexpr (native_num) {
+            uint64_t v;
+            if constexpr (bit<op_msb, op_lsb>::native_num) {
+                v = native_bits(op);
+            } else {
+                v = op.value.values[0];
+            }
+            auto const mask = util::tail_mask(count) << start;
+            value = static_cast<T>((static_cast<uint64_t>(value) & ~mask) | ((v << start) & mask));
+        } else if constexpr (bit<op_msb, op_lsb>::native_num) {
+            auto const v = native_bits(op);
+            util::insert_bits(value.values.data(), value.s, start, count, &v, 1);
+        } else {
+            util::insert_bits(value.values.data(), value.s, start, count, op.value.values.data(),
+                              op.value.s);
+        }
+    }
+
     // compute the mask in unsigned fashion
     static constexpr auto bit_mask() requires(native_num) {
         using TU = typename util::get_holder_type<size, false>::type;
@@ -1230,6 +1462,31 @@ private:
     T &self_;
 };
 
+namespace util {
+// raw words, e.g. from parse_literal, into a bit
+template <typename T, uint64_t n>
+constexpr void set_words(T &b, const std::array<uint64_t, n> &words) {
+    if constexpr (T::native_num) {
+        b.value = native_value<typename T::T>(words[0], T::size);
+    } else {
+        b.value.values = words;
+    }
+}
+
+// and back. bits above the size are 0
+template <typename T>
+constexpr auto get_words(const T &b) {
+    std::array<uint64_t, (T::size + 63) / 64> words;
+    if constexpr (T::native_num) {
+        // signed holders are sign extended
+        words[0] = static_cast<uint64_t>(b.value) & tail_mask(T::size);
+    } else {
+        words = b.value.values;
+    }
+    return words;
+}
+}  // namespace util
+
 inline namespace literals {
 // constexpr to parse SystemVerilog literals
 // per LRM, if size not specified, the default size is 32
@@ -1240,6 +1497,19 @@ constexpr bit<31, 0, true> operator""_bit(unsigned long long value) {
 constexpr bit<63, 0, true> operator""_bit64(unsigned long long value) {
     return bit<63, 0, true>(static_cast<int64_t>(value)).extend<64>();
 }
+
+// sized literals such as "8'shF0"_bit, with the width and signedness taken from the literal and
+// the value parsed at compile time. x and z digits need _logic
+template <util::fixed_string str>
+consteval auto operator""_bit() {
+    constexpr auto format = util::parse_literal_format(str.view());
+    constexpr auto words =
+        util::parse_literal<format.size>(str.view().substr(format.pos), format.base);
+    static_assert(!words.xz(), "x or z in a 2-state literal");
+    bit<format.size - 1, 0, format.signed_> result;
+    util::set_words(result, words.value);
+    return result;
+}
 }  // namespace literals
 
 }  // namespace logic
@@ -0,0 +1,240 @@
+#ifndef LOGIC_DISPLAY_HH
+#define LOGIC_DISPLAY_HH
+
+#include "logic.hh"
+
+namespace logic {
+
+/*
+ * $display/$sformatf style formatting. a format string is compiled once into a list of literal
+ * text and argument specs, which can then render any number of argument lists without looking
+ * at the format string again. constant format strings are compiled at compile time:
+ *     sformatf<"%0h %d">(a, b)
+ * while format strings only known at runtime go through display_format:
+ *     display_format fmt("%0h %d");
+ *     fmt.format(a, b);
+ * supported specs are %b %o %h %x %d %s %c and %t with an optional width, e.g. %0h or %8d, plus
+ * %% for a percent sign. %t has no $timeformat and prints as %d. anything else, e.g. %m, is
+ * kept as literal text
+ */
+struct display_item {
+    // literal text in [offset, offset + length) of the format string
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    // the spec of the next argument, with base 0 for literal text
+    util::format_spec spec = {0, -1};
+
+    [[nodiscard]] constexpr bool is_arg() const { return spec.base != 0; }
+};
+
+namespace util {
+// calls emit(display_item) for every piece of fmt in order
+template <typename F>
+constexpr void parse_display_format(std::string_view fmt, F &&emit) {
+    uint64_t text = 0;
+    auto flush = [&](uint64_t end) {
+        if (end > text) emit(display_item{text, end - text});
+    };
+    for (uint64_t i = 0; i < fmt.size(); i++) {
+        if (fmt[i] != '%') continue;
+        auto j = i + 1;
+        int64_t width = -1;
+        for (; j < fmt.size() && fmt[j] >= '0' && fmt[j] <= '9'; j++) {
+            width = (width < 0 ? 0 : width * 10) + (fmt[j] - '0');
+        }
+        if (j == fmt.size()) break;
+        auto const c = static_cast<char>(fmt[j] | 0x20);
+        if (c == '%') {
+            // keep the first %
+            flush(i + 1);
+        } else if (c == 'b' || c == 'o' || c == 'h' || c == 'x' || c == 'd' || c == 's' ||
+                   c == 'c' || c == 't') {
+            flush(i);
+            emit(display_item{0, 0, {c == 't' ? 'd' : c, width}});
+        } else {
+            continue;
+        }
+        text = j + 1;
+        i = j;
+    }
+    flush(fmt.size());
+}
+
+constexpr uint64_t display_items(std::string_view fmt) {
+    uint64_t result = 0;
+    parse_display_format(fmt, [&result](display_item) { result++; });
+    return result;
+}
+
+constexpr uint64_t display_args(std::string_view fmt) {
+    uint64_t result = 0;
+    parse_display_format(fmt, [&result](display_item item) { result += item.is_arg(); });
+    return result;
+}
+
+// integral arguments are formatted as their own width, the way a simulator sees an int
+template <typename T>
+auto display_value(T arg) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return bit<0>(arg);
+    } else {
+        return bit<sizeof(T) * 8 - 1, 0, std::is_signed_v<T>>(arg);
+    }
+}
+
+template <typename T>
+uint64_t display_size(util::format_spec spec, const T &arg) {
+    if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+        return std::string_view(arg).size() + std::max<int64_t>(spec.width, 0);
+    } else if constexpr (std::is_integral_v<T>) {
+        return format_size(spec, decltype(display_value(arg))::size);
+    } else {
+        return format_size(spec, T::size);
+    }
+}
+
+template <typename T>
+char *display_arg(char *first, char *last, util::format_spec spec, const T &arg) {
+    if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+        // strings are right justified in the field, the same as %s of a packed value
+        auto const str = std::string_view(arg);
+        auto const width = static_cast<int64_t>(str.size());
+        auto const pad = static_cast<uint64_t>(std::max<int64_t>(spec.width - width, 0));
+        if (static_cast<uint64_t>(last - first) < pad + str.size()) return nullptr;
+        first = std::fill_n(first, pad, ' ');
+        return std::copy(str.begin(), str.end(), first);
+    } else if constexpr (std::is_integral_v<T>) {
+        return display_value(arg).format_to(first, last, spec);
+    } else {
+        return arg.format_to(first, last, spec);
+    }
+}
+
+// renders the items of fmt with args. arguments without a spec are dropped, and specs without an
+// argument print nothing
+template <typename Items, typename... Args>
+char *display_to(char *first, char *last, std::string_view fmt, const Items &items,
+                 const Args &...args) {
+    auto item = items.begin();
+    // literal text up to the next argument spec
+    auto text = [&]() {
+        for (; first && item != items.end() && !item->is_arg(); item++) {
+            if (static_cast<uint64_t>(last - first) < item->length) {
+                first = nullptr;
+            } else {
+                first = std::copy_n(fmt.data() + item->offset, item->length, first);
+            }
+        }
+    };
+    auto arg = [&](const auto &value) {
+        text();
+        if (first && item != items.end()) first = display_arg(first, last, (item++)->spec, value);
+    };
+    (arg(args), ...);
+    while (first && item != items.end()) {
+        text();
+        if (item != items.end()) item++;
+    }
+    return first;
+}
+
+// an upper bound of the rendered size
+template <typename Items, typename... Args>
+uint64_t display_size(const Items &items, const Args &...args) {
+    uint64_t result = 0;
+    for (auto const &item : items) result += item.length;
+    auto item = items.begin();
+    auto arg = [&](const auto &value) {
+        item = std::find_if(item, items.end(), [](auto const &i) { return i.is_arg(); });
+        if (item != items.end()) result += display_size((item++)->spec, value);
+    };
+    (arg(args), ...);
+    return result;
+}
+
+template <typename Items, typename... Args>
+std::string display_string(std::string_view fmt, const Items &items, const Args &...args) {
+    std::string result(display_size(items, args...), '\0');
+    auto *end = display_to(result.data(), result.data() + result.size(), fmt, items, args...);
+    result.resize(end - result.data());
+    return result;
+}
+}  // namespace util
+
+// a format string compiled at runtime
+class display_format {
+public:
+    explicit display_format(std::string fmt) : fmt_(std::move(fmt)) {
+        util::parse_display_format(fmt_, [this](display_item item) { items_.emplace_back(item); });
+    }
+
+    [[nodiscard]] uint64_t arg_count() const {
+        return std::count_if(items_.begin(), items_.end(),
+                             [](auto const &i) { return i.is_arg(); });
+    }
+
+    // renders into [first, last) without allocating. returns the end of the output, or nullptr if
+    // it doesn't fit
+    template <typename... Args>
+    char *format_to(char *first, char *last, const Args &...args) const {
+        return util::display_to(first, last, fmt_, items_, args...);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] std::string format(const Args &...args) const {
+        return util::display_string(fmt_, items_, args...);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] std::string format(const std::tuple<Args...> &args) const {
+        return std::apply([this](const auto &...a) { return format(a...); }, args);
+    }
+
+private:
+    std::string fmt_;
+    std::vector<display_item> items_;
+};
+
+// a format string compiled at compile time
+template <util::fixed_string fmt>
+struct static_display_format {
+    static constexpr auto items = [] {
+        std::array<display_item, util::display_items(fmt.view())> result;
+        auto i = 0u;
+        util::parse_display_format(fmt.view(), [&](display_item item) { result[i++] = item; });
+        return result;
+    }();
+
+    static constexpr uint64_t arg_count() { return util::display_args(fmt.view()); }
+
+    template <typename... Args>
+    static char *format_to(char *first, char *last, const Args &...args) {
+        static_assert(sizeof...(Args) == arg_count(), "argument count does not match the format");
+        return util::display_to(first, last, fmt.view(), items, args...);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] static std::string format(const Args &...args) {
+        static_assert(sizeof...(Args) == arg_count(), "argument count does not match the format");
+        return util::display_string(fmt.view(), items, args...);
+    }
+
+    template <typename... Args>
+    [[nodiscard]] static std::string format(const std::tuple<Args...> &args) {
+        return std::apply([](const auto &...a) { return format(a...); }, args);
+    }
+};
+
+template <util::fixed_string fmt, typename... Args>
+std::string sformatf(const Args &...args) {
+    return static_display_format<fmt>::format(args...);
+}
+
+template <util::fixed_string fmt, typename... Args>
+char *sformatf_to(char *first, char *last, const Args &...args) {
+    return static_display_format<fmt>::format_to(first, last, args...);
+}
+
+}  // namespace logic
+
+#endif  // LOGIC_DISPLAY_HH
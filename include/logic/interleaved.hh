@@ -0,0 +1,429 @@
+#ifndef LOGIC_INTERLEAVED_HH
+#define LOGIC_INTERLEAVED_HH
+
+#include "logic.hh"
+
+namespace logic {
+
+namespace util {
+// a word of a 4-state value in the VPI s_vpi_vecval encoding, LRM 38.13:
+//   aval bval
+//     0    0   0
+//     1    0   1
+//     0    1   z
+//     1    1   x
+struct vecval {
+    uint64_t aval;
+    uint64_t bval;
+};
+}  // namespace util
+
+template <int msb = 0, int lsb = 0, bool signed_ = false>
+struct interleaved_logic;
+
+namespace util {
+// the split layout of an operand in either layout, for the operators computed in logic
+template <int msb, int lsb, bool signed_>
+logic<msb, lsb, signed_> split_layout(const interleaved_logic<msb, lsb, signed_> &v) {
+    return v.to_logic();
+}
+
+template <int msb, int lsb, bool signed_, bool array>
+const logic<msb, lsb, signed_, array> &split_layout(const logic<msb, lsb, signed_, array> &v) {
+    return v;
+}
+
+template <int msb, int lsb, bool signed_>
+logic<msb, lsb, signed_> split_layout(const bit<msb, lsb, signed_> &v) {
+    return logic<msb, lsb, signed_>(v);
+}
+
+template <typename T>
+constexpr bool is_interleaved = false;
+
+template <int msb, int lsb, bool signed_>
+constexpr bool is_interleaved<interleaved_logic<msb, lsb, signed_>> = true;
+
+// at least one interleaved operand, and the other one is logic, bit or interleaved
+template <typename L, typename R>
+constexpr bool mixed_layout = (is_interleaved<L> || is_interleaved<R>) &&
+                              requires(const L &l, const R &r) {
+    split_layout(l);
+    split_layout(r);
+};
+
+// the operands the member operators of interleaved_logic take
+template <typename L, typename R>
+constexpr bool same_interleaved = is_interleaved<L> && is_interleaved<R> && L::size == R::size;
+}  // namespace util
+
+/*
+ * logic with an interleaved layout: every value word sits next to its xz word, the way VPI lays
+ * out aval/bval pairs. logic keeps the value and xz mask in two separate arrays, so a wide bitwise
+ * operation streams two distant blocks per operand. here it streams one, which pays off for
+ * vectors of thousands of bits and for large populations of them.
+ * bitwise operators, reductions and equality work on the word pairs directly. everything else,
+ * including operators with a logic or bit operand, goes through logic and has the same result
+ * types as logic, with vector results in the interleaved layout. to_logic()/the logic constructor
+ * convert between the two layouts
+ */
+template <int msb, int lsb, bool signed_>
+struct interleaved_logic {
+public:
+    static auto constexpr size = util::abs_diff(msb, lsb) + 1;
+    static auto constexpr words = (size + 63) / 64;
+    constexpr static auto big_endian = msb >= lsb;
+    constexpr static auto is_signed = signed_;
+    constexpr static bool is_4state = true;
+    // bits above the size are 0 in both aval and bval
+    std::array<util::vecval, words> values;
+
+    /*
+     * constructors
+     */
+    // by default everything is x
+    constexpr interleaved_logic() { fill_x(); }
+
+    template <typename T>
+    constexpr interleaved_logic(T value) requires(std::is_arithmetic_v<T>)  // NOLINT
+        : interleaved_logic(logic<msb, lsb, signed_>(value)) {}
+
+    explicit interleaved_logic(std::string_view v)
+        : interleaved_logic(logic<msb, lsb, signed_>(v)) {}
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(util::abs_diff(op_msb, op_lsb) + 1 == size) constexpr interleaved_logic(  // NOLINT
+        const logic<op_msb, op_lsb, op_signed> &l) {
+        auto const value = util::get_words(l.value);
+        auto const xz_mask = util::get_words(l.xz_mask);
+        for (uint64_t i = 0; i < words; i++) {
+            values[i] = {value[i] ^ xz_mask[i], xz_mask[i]};
+        }
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(util::abs_diff(op_msb, op_lsb) + 1 == size) constexpr interleaved_logic(  // NOLINT
+        const bit<op_msb, op_lsb, op_signed> &b) {
+        auto const value = util::get_words(b);
+        for (uint64_t i = 0; i < words; i++) values[i] = {value[i], 0};
+    }
+
+    // same width, any range or signedness
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(util::abs_diff(op_msb, op_lsb) + 1 == size) interleaved_logic &operator=(
+        const interleaved_logic<op_msb, op_lsb, op_signed> &op) {
+        values = op.values;
+        return *this;
+    }
+
+    [[nodiscard]] constexpr logic<msb, lsb, signed_> to_logic() const {
+        std::array<uint64_t, words> value, xz_mask;
+        for (uint64_t i = 0; i < words; i++) {
+            value[i] = values[i].aval ^ values[i].bval;
+            xz_mask[i] = values[i].bval;
+        }
+        logic<msb, lsb, signed_> result;
+        util::set_words(result.value, value);
+        util::set_words(result.xz_mask, xz_mask);
+        return result;
+    }
+
+    [[nodiscard]] std::string str(std::string_view fmt = "b") const {
+        return to_logic().str(fmt);
+    }
+
+    /*
+     * single bit
+     */
+    [[nodiscard]] logic<0> operator[](int idx) const {
+        if (idx > util::max(msb, lsb) || idx < util::min(msb, lsb)) [[unlikely]] {
+            return logic<0>{};
+        }
+        auto const i = index(idx);
+        auto const &w = values[i / 64];
+        logic<0> r;
+        r.value.value = ((w.aval ^ w.bval) >> (i % 64)) & 1;
+        r.xz_mask.value = (w.bval >> (i % 64)) & 1;
+        return r;
+    }
+
+    template <bool l_signed>
+    void set(int idx, const logic<0, 0, l_signed> &l) {
+        auto const i = index(idx);
+        auto &w = values[i / 64];
+        auto const bit = 1ull << (i % 64);
+        auto const xz = static_cast<bool>(l.xz_mask.value);
+        auto const aval = static_cast<bool>(l.value.value) != xz;
+        w.aval = aval ? (w.aval | bit) : (w.aval & ~bit);
+        w.bval = xz ? (w.bval | bit) : (w.bval & ~bit);
+    }
+
+    void set(int idx, bool v) { set(idx, logic<0>(v)); }
+
+    // every bit becomes x
+    constexpr void fill_x() {
+        for (auto &w : values) w = {~0ull, ~0ull};
+        values[words - 1] = {util::tail_mask(size), util::tail_mask(size)};
+    }
+
+    [[nodiscard]] bool any_xz() const {
+        uint64_t xz = 0;
+        for (auto const &w : values) xz |= w.bval;
+        return xz != 0;
+    }
+
+    explicit operator bool() const {
+        uint64_t xz = 0, v = 0;
+        for (auto const &w : values) {
+            xz |= w.bval;
+            v |= w.aval;
+        }
+        return !xz && v;
+    }
+
+    logic<0> operator!() const {
+        return any_xz() ? logic<0>::x_() : (static_cast<bool>(*this) ? logic<0>::zero_()
+                                                                     : logic<0>::one_());
+    }
+
+    /*
+     * bitwise operators, a word pair at a time. any x or z operand bit that doesn't decide the
+     * result makes it x
+     */
+    template <int op_lsb, bool op_signed>
+    auto operator&(const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        interleaved_logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
+        for (uint64_t i = 0; i < words; i++) {
+            auto const &l = values[i];
+            auto const &r = op.values[i];
+            // a known 0 on either side is 0
+            auto const aval = (l.aval | l.bval) & (r.aval | r.bval);
+            result.values[i] = {aval, (l.bval | r.bval) & aval};
+        }
+        return result;
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto operator|(const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        interleaved_logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
+        for (uint64_t i = 0; i < words; i++) {
+            auto const &l = values[i];
+            auto const &r = op.values[i];
+            // a known 1 on either side is 1
+            auto const one = (l.aval & ~l.bval) | (r.aval & ~r.bval);
+            result.values[i] = {l.aval | l.bval | r.aval | r.bval, (l.bval | r.bval) & ~one};
+        }
+        return result;
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto operator^(const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        interleaved_logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
+        for (uint64_t i = 0; i < words; i++) {
+            auto const &l = values[i];
+            auto const &r = op.values[i];
+            auto const bval = l.bval | r.bval;
+            result.values[i] = {(l.aval ^ r.aval) | bval, bval};
+        }
+        return result;
+    }
+
+    interleaved_logic<size - 1> operator~() const {
+        interleaved_logic<size - 1> result;
+        for (uint64_t i = 0; i < words; i++) {
+            result.values[i] = {~values[i].aval | values[i].bval, values[i].bval};
+        }
+        result.values[words - 1].aval &= util::tail_mask(size);
+        return result;
+    }
+
+    auto operator-() const { return interleaved(-to_logic()); }
+    auto operator+() const { return interleaved(+to_logic()); }
+
+    template <typename T>
+    interleaved_logic &operator&=(const T &op) {
+        return *this = *this & op;
+    }
+
+    template <typename T>
+    interleaved_logic &operator|=(const T &op) {
+        return *this = *this | op;
+    }
+
+    template <typename T>
+    interleaved_logic &operator^=(const T &op) {
+        return *this = *this ^ op;
+    }
+
+    /*
+     * slices and concatenation, the same as logic
+     */
+    template <int a, int b>
+    requires(util::max(a, b) < size) [[nodiscard]] auto slice() const {
+        return interleaved(to_logic().template slice<a, b>());
+    }
+
+    template <uint32_t target_size>
+    [[nodiscard]] auto slice(int a, int b) const {
+        return interleaved(to_logic().template slice<target_size>(a, b));
+    }
+
+    // operands can be in either layout
+    template <typename U, typename... Ts>
+    [[nodiscard]] auto concat(const U &arg0, const Ts &...args) const {
+        return interleaved(
+            to_logic().concat(util::split_layout(arg0), util::split_layout(args)...));
+    }
+
+    /*
+     * reductions
+     */
+    [[nodiscard]] logic<0> r_and() const {
+        // any known 0 makes it 0, then any x/z makes it x
+        uint64_t xz = 0;
+        for (uint64_t i = 0; i < words; i++) {
+            auto const tail = i == words - 1 ? util::tail_mask(size) : ~0ull;
+            if (~(values[i].aval | values[i].bval) & tail) return logic<0>::zero_();
+            xz |= values[i].bval;
+        }
+        return xz ? logic<0>::x_() : logic<0>::one_();
+    }
+
+    [[nodiscard]] logic<0> r_nand() const { return !r_and(); }
+
+    [[nodiscard]] logic<0> r_or() const {
+        // any known 1 makes it 1, then any x/z makes it x
+        uint64_t xz = 0;
+        for (auto const &w : values) {
+            if (w.aval & ~w.bval) return logic<0>::one_();
+            xz |= w.bval;
+        }
+        return xz ? logic<0>::x_() : logic<0>::zero_();
+    }
+
+    [[nodiscard]] logic<0> r_nor() const { return !r_or(); }
+
+    [[nodiscard]] logic<0> r_xor() const {
+        uint64_t xz = 0, fold = 0;
+        for (auto const &w : values) {
+            xz |= w.bval;
+            fold ^= w.aval;
+        }
+        if (xz) return logic<0>::x_();
+        return (std::popcount(fold) & 1) ? logic<0>::one_() : logic<0>::zero_();
+    }
+
+    [[nodiscard]] logic<0> r_xnor() const { return !r_xor(); }
+
+    /*
+     * equality
+     */
+    template <int op_lsb, bool op_signed>
+    logic<0> operator==(const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        if (any_xz() || op.any_xz()) return logic<0>::x_();
+        for (uint64_t i = 0; i < words; i++) {
+            if (values[i].aval != op.values[i].aval) return logic<0>::zero_();
+        }
+        return logic<0>::one_();
+    }
+
+    template <int op_lsb, bool op_signed>
+    logic<0> operator!=(const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        return !(*this == op);
+    }
+
+    // ===
+    template <int op_lsb, bool op_signed>
+    [[nodiscard]] bool match(
+        const interleaved_logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        for (uint64_t i = 0; i < words; i++) {
+            if (values[i].aval != op.values[i].aval || values[i].bval != op.values[i].bval) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    // bit position of idx, from the lowest index upwards
+    static constexpr uint64_t index(int idx) {
+        return big_endian ? idx - util::min(msb, lsb) : lsb - idx;
+    }
+};
+
+// the layout of a logic value of the same type
+template <int msb, int lsb, bool signed_, bool array>
+interleaved_logic<msb, lsb, signed_> interleaved(const logic<msb, lsb, signed_, array> &l) {
+    return interleaved_logic<msb, lsb, signed_>(l);
+}
+
+// the remaining operators, bitwise operators on different widths and operators with a logic or
+// bit operand compute in the split layout. vector results come back interleaved and comparisons
+// are logic<0>, the same as logic
+#define LOGIC_INTERLEAVED_OP(op, cond)                                                        \
+    template <typename L, typename R>                                                         \
+    requires(util::mixed_layout<L, R> && (cond)) auto operator op(const L &l, const R &r) {   \
+        return interleaved(util::split_layout(l) op util::split_layout(r));                   \
+    }
+#define LOGIC_INTERLEAVED_CMP(op, cond)                                                       \
+    template <typename L, typename R>                                                         \
+    requires(util::mixed_layout<L, R> && (cond)) logic<0> operator op(const L &l, const R &r) { \
+        return util::split_layout(l) op util::split_layout(r);                                \
+    }
+#define LOGIC_NOT_MEMBER (!util::same_interleaved<L, R>)
+
+LOGIC_INTERLEAVED_OP(&, LOGIC_NOT_MEMBER)
+LOGIC_INTERLEAVED_OP(|, LOGIC_NOT_MEMBER)
+LOGIC_INTERLEAVED_OP(^, LOGIC_NOT_MEMBER)
+LOGIC_INTERLEAVED_OP(+, true)
+LOGIC_INTERLEAVED_OP(-, true)
+LOGIC_INTERLEAVED_OP(*, true)
+LOGIC_INTERLEAVED_OP(/, true)
+LOGIC_INTERLEAVED_OP(%, true)
+LOGIC_INTERLEAVED_OP(<<, true)
+LOGIC_INTERLEAVED_OP(>>, true)
+LOGIC_INTERLEAVED_CMP(==, LOGIC_NOT_MEMBER)
+LOGIC_INTERLEAVED_CMP(!=, LOGIC_NOT_MEMBER)
+LOGIC_INTERLEAVED_CMP(<, true)
+LOGIC_INTERLEAVED_CMP(>, true)
+LOGIC_INTERLEAVED_CMP(<=, true)
+LOGIC_INTERLEAVED_CMP(>=, true)
+#undef LOGIC_NOT_MEMBER
+#undef LOGIC_INTERLEAVED_CMP
+#undef LOGIC_INTERLEAVED_OP
+
+// an integer operand of a bitwise operator takes the type of the other one, the same as the
+// integer constructor
+#define LOGIC_INTERLEAVED_INT_OP(op)                                                      \
+    template <int msb, int lsb, bool signed_, typename T>                                 \
+    requires(std::is_arithmetic_v<T>) auto operator op(                                   \
+        const interleaved_logic<msb, lsb, signed_> &l, T r) {                             \
+        return l op interleaved_logic<msb, lsb, signed_>(r);                              \
+    }                                                                                     \
+    template <int msb, int lsb, bool signed_, typename T>                                 \
+    requires(std::is_arithmetic_v<T>) auto operator op(                                   \
+        T l, const interleaved_logic<msb, lsb, signed_> &r) {                             \
+        return interleaved_logic<msb, lsb, signed_>(l) op r;                              \
+    }
+
+LOGIC_INTERLEAVED_INT_OP(&)
+LOGIC_INTERLEAVED_INT_OP(|)
+LOGIC_INTERLEAVED_INT_OP(^)
+#undef LOGIC_INTERLEAVED_INT_OP
+
+// integer shift amounts
+template <int msb, int lsb, bool signed_, typename T>
+requires(std::is_integral_v<T>) auto operator<<(const interleaved_logic<msb, lsb, signed_> &l,
+                                                T amount) {
+    return interleaved(l.to_logic() << logic<63, 0>(static_cast<uint64_t>(amount)));
+}
+
+template <int msb, int lsb, bool signed_, typename T>
+requires(std::is_integral_v<T>) auto operator>>(const interleaved_logic<msb, lsb, signed_> &l,
+                                                T amount) {
+    return interleaved(l.to_logic() >> logic<63, 0>(static_cast<uint64_t>(amount)));
+}
+
+}  // namespace logic
+
+#endif  // LOGIC_INTERLEAVED_HH
@@ -0,0 +1,417 @@
+#ifndef LOGIC_LANES_HH
+#define LOGIC_LANES_HH
+
+#include "logic.hh"
+
+namespace logic {
+
+/*
+ * bit-parallel simulation: the same signal in L independent simulations (lanes), transposed so
+ * that lane i is bit i of a lane word. a gate evaluated on lanes is a handful of word operations,
+ * so a netlist evaluated once covers every lane. the word loops have a fixed trip count and no
+ * branches, which the compiler turns into SIMD. L is any lane count, e.g. 64, 256 or 512
+ */
+
+// a single bit in every lane, 2-state
+template <uint64_t L = 64>
+requires(L > 0) struct lanes {
+public:
+    static auto constexpr size = L;
+    static auto constexpr words = (L + 63) / 64;
+    // bit i is lane i. bits past the last lane are 0
+    std::array<uint64_t, words> values = {};
+
+    /*
+     * constructors
+     */
+    // every lane is 0
+    constexpr lanes() = default;
+    // every lane is v
+    constexpr explicit lanes(bool v) {
+        if (v) fill();
+    }
+
+    /*
+     * single lane
+     */
+    [[nodiscard]] bool operator[](uint64_t lane) const {
+        return (values[lane / 64] >> (lane % 64)) & 1;
+    }
+
+    void set(uint64_t lane, bool v) {
+        auto const bit = 1ull << (lane % 64);
+        auto &w = values[lane / 64];
+        w = v ? (w | bit) : (w & ~bit);
+    }
+
+    constexpr void fill() {
+        for (auto &w : values) w = ~0ull;
+        values[words - 1] = util::tail_mask(L);
+    }
+
+    /*
+     * bitwise operators, every lane at once
+     */
+    constexpr lanes operator&(const lanes &op) const {
+        lanes result;
+        for (uint64_t i = 0; i < words; i++) result.values[i] = values[i] & op.values[i];
+        return result;
+    }
+
+    constexpr lanes operator|(const lanes &op) const {
+        lanes result;
+        for (uint64_t i = 0; i < words; i++) result.values[i] = values[i] | op.values[i];
+        return result;
+    }
+
+    constexpr lanes operator^(const lanes &op) const {
+        lanes result;
+        for (uint64_t i = 0; i < words; i++) result.values[i] = values[i] ^ op.values[i];
+        return result;
+    }
+
+    constexpr lanes operator~() const {
+        lanes result;
+        for (uint64_t i = 0; i < words; i++) result.values[i] = ~values[i];
+        result.values[words - 1] &= util::tail_mask(L);
+        return result;
+    }
+
+    // ~a & b without the intermediate, which is the common mux and mask idiom
+    constexpr lanes and_not(const lanes &op) const {
+        lanes result;
+        for (uint64_t i = 0; i < words; i++) result.values[i] = ~values[i] & op.values[i];
+        return result;
+    }
+
+    constexpr lanes &operator&=(const lanes &op) { return *this = *this & op; }
+    constexpr lanes &operator|=(const lanes &op) { return *this = *this | op; }
+    constexpr lanes &operator^=(const lanes &op) { return *this = *this ^ op; }
+
+    constexpr bool operator==(const lanes &op) const = default;
+
+    /*
+     * across lanes
+     */
+    [[nodiscard]] bool any() const {
+        uint64_t r = 0;
+        for (auto w : values) r |= w;
+        return r != 0;
+    }
+
+    [[nodiscard]] bool all() const { return !(~*this).any(); }
+
+    // number of lanes that are 1
+    [[nodiscard]] uint64_t count() const {
+        uint64_t r = 0;
+        for (auto w : values) r += std::popcount(w);
+        return r;
+    }
+};
+
+// sel ? t : f in every lane
+template <uint64_t L>
+constexpr lanes<L> mux(const lanes<L> &sel, const lanes<L> &t, const lanes<L> &f) {
+    lanes<L> result;
+    for (uint64_t i = 0; i < lanes<L>::words; i++) {
+        result.values[i] = (sel.values[i] & t.values[i]) | (~sel.values[i] & f.values[i]);
+    }
+    return result;
+}
+
+// a size-bit vector in every lane, 2-state. bits[i] is bit i of every lane
+template <int size, uint64_t L = 64>
+requires(size > 0) struct bit_lanes {
+public:
+    static auto constexpr lane_count = L;
+    std::array<lanes<L>, size> bits = {};
+
+    /*
+     * constructors
+     */
+    // every lane is 0
+    constexpr bit_lanes() = default;
+    // every lane holds b
+    template <int msb, int lsb, bool signed_>
+    requires(util::abs_diff(msb, lsb) + 1 == size) constexpr explicit bit_lanes(
+        const bit<msb, lsb, signed_> &b) {
+        auto const words = util::get_words(b);
+        for (auto i = 0; i < size; i++) bits[i] = lanes<L>((words[i / 64] >> (i % 64)) & 1);
+    }
+
+    /*
+     * lanes in and out
+     */
+    [[nodiscard]] bit<size - 1, 0> lane(uint64_t l) const {
+        std::array<uint64_t, (size + 63) / 64> words = {};
+        for (auto i = 0; i < size; i++) {
+            words[i / 64] |= static_cast<uint64_t>(bits[i][l]) << (i % 64);
+        }
+        bit<size - 1, 0> result;
+        util::set_words(result, words);
+        return result;
+    }
+
+    template <int msb, int lsb, bool signed_>
+    requires(util::abs_diff(msb, lsb) + 1 == size) void set_lane(uint64_t l,
+                                                                 const bit<msb, lsb, signed_> &b) {
+        auto const words = util::get_words(b);
+        for (auto i = 0; i < size; i++) bits[i].set(l, (words[i / 64] >> (i % 64)) & 1);
+    }
+
+    lanes<L> &operator[](int idx) { return bits[idx]; }
+    const lanes<L> &operator[](int idx) const { return bits[idx]; }
+
+    /*
+     * bitwise operators
+     */
+    constexpr bit_lanes operator&(const bit_lanes &op) const {
+        bit_lanes result;
+        for (auto i = 0; i < size; i++) result.bits[i] = bits[i] & op.bits[i];
+        return result;
+    }
+
+    constexpr bit_lanes operator|(const bit_lanes &op) const {
+        bit_lanes result;
+        for (auto i = 0; i < size; i++) result.bits[i] = bits[i] | op.bits[i];
+        return result;
+    }
+
+    constexpr bit_lanes operator^(const bit_lanes &op) const {
+        bit_lanes result;
+        for (auto i = 0; i < size; i++) result.bits[i] = bits[i] ^ op.bits[i];
+        return result;
+    }
+
+    constexpr bit_lanes operator~() const {
+        bit_lanes result;
+        for (auto i = 0; i < size; i++) result.bits[i] = ~bits[i];
+        return result;
+    }
+
+    constexpr bit_lanes &operator&=(const bit_lanes &op) { return *this = *this & op; }
+    constexpr bit_lanes &operator|=(const bit_lanes &op) { return *this = *this | op; }
+    constexpr bit_lanes &operator^=(const bit_lanes &op) { return *this = *this ^ op; }
+
+    /*
+     * reductions, one result per lane
+     */
+    [[nodiscard]] constexpr lanes<L> r_and() const {
+        auto result = bits[0];
+        for (auto i = 1; i < size; i++) result &= bits[i];
+        return result;
+    }
+
+    [[nodiscard]] constexpr lanes<L> r_or() const {
+        auto result = bits[0];
+        for (auto i = 1; i < size; i++) result |= bits[i];
+        return result;
+    }
+
+    [[nodiscard]] constexpr lanes<L> r_xor() const {
+        auto result = bits[0];
+        for (auto i = 1; i < size; i++) result ^= bits[i];
+        return result;
+    }
+
+    [[nodiscard]] constexpr lanes<L> r_nand() const { return ~r_and(); }
+    [[nodiscard]] constexpr lanes<L> r_nor() const { return ~r_or(); }
+    [[nodiscard]] constexpr lanes<L> r_xnor() const { return ~r_xor(); }
+
+    // lanes where the two vectors are equal
+    [[nodiscard]] constexpr lanes<L> eq(const bit_lanes &op) const { return (*this ^ op).r_nor(); }
+};
+
+template <int size, uint64_t L>
+constexpr bit_lanes<size, L> mux(const lanes<L> &sel, const bit_lanes<size, L> &t,
+                                 const bit_lanes<size, L> &f) {
+    bit_lanes<size, L> result;
+    for (auto i = 0; i < size; i++) result.bits[i] = mux(sel, t.bits[i], f.bits[i]);
+    return result;
+}
+
+// a size-bit vector in every lane, 4-state. the value and xz_mask lanes use the same encoding as
+// logic: a set xz bit is x when the value bit is 0 and z when it is 1
+template <int size = 1, uint64_t L = 64>
+requires(size > 0) struct logic_lanes {
+public:
+    static auto constexpr lane_count = L;
+    std::array<lanes<L>, size> value;
+    std::array<lanes<L>, size> xz_mask;
+
+    /*
+     * constructors
+     */
+    // every lane is x
+    constexpr logic_lanes() { xz_mask.fill(lanes<L>(true)); }
+    // every lane holds l
+    template <int msb, int lsb, bool signed_>
+    requires(util::abs_diff(msb, lsb) + 1 == size) constexpr explicit logic_lanes(
+        const logic<msb, lsb, signed_> &l) {
+        auto const v = util::get_words(l.value);
+        auto const xz = util::get_words(l.xz_mask);
+        for (auto i = 0; i < size; i++) {
+            value[i] = lanes<L>((v[i / 64] >> (i % 64)) & 1);
+            xz_mask[i] = lanes<L>((xz[i / 64] >> (i % 64)) & 1);
+        }
+    }
+    // the same 2-state values in every lane
+    constexpr explicit logic_lanes(const bit_lanes<size, L> &b) : value(b.bits), xz_mask() {}
+
+    /*
+     * lanes in and out
+     */
+    [[nodiscard]] logic<size - 1, 0> lane(uint64_t l) const {
+        std::array<uint64_t, (size + 63) / 64> v = {}, xz = {};
+        for (auto i = 0; i < size; i++) {
+            v[i / 64] |= static_cast<uint64_t>(value[i][l]) << (i % 64);
+            xz[i / 64] |= static_cast<uint64_t>(xz_mask[i][l]) << (i % 64);
+        }
+        logic<size - 1, 0> result;
+        util::set_words(result.value, v);
+        util::set_words(result.xz_mask, xz);
+        return result;
+    }
+
+    template <int msb, int lsb, bool signed_>
+    requires(util::abs_diff(msb, lsb) + 1 == size) void set_lane(
+        uint64_t l, const logic<msb, lsb, signed_> &op) {
+        auto const v = util::get_words(op.value);
+        auto const xz = util::get_words(op.xz_mask);
+        for (auto i = 0; i < size; i++) {
+            value[i].set(l, (v[i / 64] >> (i % 64)) & 1);
+            xz_mask[i].set(l, (xz[i / 64] >> (i % 64)) & 1);
+        }
+    }
+
+    // lanes with any x or z bit
+    [[nodiscard]] constexpr lanes<L> xz() const {
+        auto result = xz_mask[0];
+        for (auto i = 1; i < size; i++) result |= xz_mask[i];
+        return result;
+    }
+
+    /*
+     * bitwise operators, LRM 11.4.8. any x or z operand bit that doesn't decide the result
+     * makes it x
+     */
+    constexpr logic_lanes operator&(const logic_lanes &op) const {
+        logic_lanes result;
+        for (auto i = 0; i < size; i++) {
+            // a known 0 on either side is 0
+            auto const zero = ~(value[i] | xz_mask[i]) | ~(op.value[i] | op.xz_mask[i]);
+            result.xz_mask[i] = zero.and_not(xz_mask[i] | op.xz_mask[i]);
+            result.value[i] = result.xz_mask[i].and_not(value[i] & op.value[i]);
+        }
+        return result;
+    }
+
+    constexpr logic_lanes operator|(const logic_lanes &op) const {
+        logic_lanes result;
+        for (auto i = 0; i < size; i++) {
+            // a known 1 on either side is 1
+            auto const one = xz_mask[i].and_not(value[i]) | op.xz_mask[i].and_not(op.value[i]);
+            result.xz_mask[i] = one.and_not(xz_mask[i] | op.xz_mask[i]);
+            result.value[i] = one;
+        }
+        return result;
+    }
+
+    constexpr logic_lanes operator^(const logic_lanes &op) const {
+        logic_lanes result;
+        for (auto i = 0; i < size; i++) {
+            result.xz_mask[i] = xz_mask[i] | op.xz_mask[i];
+            result.value[i] = result.xz_mask[i].and_not(value[i] ^ op.value[i]);
+        }
+        return result;
+    }
+
+    constexpr logic_lanes operator~() const {
+        logic_lanes result;
+        for (auto i = 0; i < size; i++) {
+            result.xz_mask[i] = xz_mask[i];
+            result.value[i] = ~(value[i] | xz_mask[i]);
+        }
+        return result;
+    }
+
+    constexpr logic_lanes &operator&=(const logic_lanes &op) { return *this = *this & op; }
+    constexpr logic_lanes &operator|=(const logic_lanes &op) { return *this = *this | op; }
+    constexpr logic_lanes &operator^=(const logic_lanes &op) { return *this = *this ^ op; }
+
+    /*
+     * reductions, one result per lane
+     */
+    [[nodiscard]] constexpr logic_lanes<1, L> r_and() const {
+        // any known 0 makes it 0, then any x/z makes it x
+        lanes<L> zero;
+        for (auto i = 0; i < size; i++) zero |= ~(value[i] | xz_mask[i]);
+        return from_masks(zero.and_not(xz()), zero.and_not(~xz()));
+    }
+
+    [[nodiscard]] constexpr logic_lanes<1, L> r_or() const {
+        // any known 1 makes it 1, then any x/z makes it x
+        lanes<L> one;
+        for (auto i = 0; i < size; i++) one |= xz_mask[i].and_not(value[i]);
+        return from_masks(one.and_not(xz()), one);
+    }
+
+    [[nodiscard]] constexpr logic_lanes<1, L> r_xor() const {
+        auto const x = xz();
+        lanes<L> fold;
+        for (auto i = 0; i < size; i++) fold ^= value[i];
+        return from_masks(x, x.and_not(fold));
+    }
+
+    [[nodiscard]] constexpr logic_lanes<1, L> r_nand() const { return ~r_and(); }
+    [[nodiscard]] constexpr logic_lanes<1, L> r_nor() const { return ~r_or(); }
+    [[nodiscard]] constexpr logic_lanes<1, L> r_xnor() const { return ~r_xor(); }
+
+    // ==, x in every lane where either side has x or z
+    [[nodiscard]] constexpr logic_lanes<1, L> eq(const logic_lanes &op) const {
+        auto const x = xz() | op.xz();
+        lanes<L> differ;
+        for (auto i = 0; i < size; i++) differ |= value[i] ^ op.value[i];
+        return from_masks(x, ~(x | differ));
+    }
+
+    // ===, 2-state in every lane
+    [[nodiscard]] constexpr lanes<L> match(const logic_lanes &op) const {
+        lanes<L> differ;
+        for (auto i = 0; i < size; i++) {
+            differ |= (value[i] ^ op.value[i]) | (xz_mask[i] ^ op.xz_mask[i]);
+        }
+        return ~differ;
+    }
+
+private:
+    static constexpr logic_lanes<1, L> from_masks(const lanes<L> &xz, const lanes<L> &v) {
+        logic_lanes<1, L> result;
+        result.xz_mask[0] = xz;
+        result.value[0] = v;
+        return result;
+    }
+};
+
+// sel ? t : f in every lane, LRM 11.4.11: an x or z select combines both sides bit by bit, where
+// bits that agree keep their value and the rest are x
+template <int size, uint64_t L>
+constexpr logic_lanes<size, L> mux(const logic_lanes<1, L> &sel, const logic_lanes<size, L> &t,
+                                   const logic_lanes<size, L> &f) {
+    auto const sel_x = sel.xz_mask[0];
+    auto const sel_1 = sel_x.and_not(sel.value[0]);
+    auto const sel_0 = ~(sel.value[0] | sel_x);
+    logic_lanes<size, L> result;
+    for (auto i = 0; i < size; i++) {
+        auto const agree = ~((t.value[i] ^ f.value[i]) | t.xz_mask[i] | f.xz_mask[i]);
+        result.value[i] = (sel_1 & t.value[i]) | (sel_0 & f.value[i]) |
+                          (sel_x & agree & t.value[i]);
+        result.xz_mask[i] = (sel_1 & t.xz_mask[i]) | (sel_0 & f.xz_mask[i]) |
+                            agree.and_not(sel_x);
+    }
+    return result;
+}
+
+}  // namespace logic
+
+#endif  // LOGIC_LANES_HH
@@ -3,6 +3,10 @@
 
 #include "bit.hh"
 
+#if __has_include(<format>)
+#include <format>
+#endif
+
 namespace logic {
 
 template <int msb, int lsb, bool signed_, bool array>
@@ -25,26 +29,27 @@ public:
 
     // basic formatting
     [[nodiscard]] std::string str(std::string_view fmt = "b") const {
-        if constexpr (signed_) {
-            auto is_negative = value.negative();
-            if (is_negative && util::decimal_fmt(fmt)) {
-                auto value_ = value.negate().value;
-                if constexpr (util::native_num(size)) {
-                    uint64_t xz = xz_mask.value;
-                    return util::to_string(fmt, size, value_, xz, true);
-                } else {
-                    return util::to_string(fmt, size, value_.values.data(),
-                                           xz_mask.value.values.data(), true);
-                }
-            }
-        }
+        std::string result(util::format_size(fmt, size), '\0');
+        auto *end = format_to(result.data(), result.data() + result.size(), fmt);
+        result.resize(end - result.data());
+        return result;
+    }
+
+    // formats into [first, last) without allocating. returns the end of the output, or nullptr if
+    // it doesn't fit
+    char *format_to(char *first, char *last, std::string_view fmt = "b") const {
+        return format_to(first, last, util::parse_format_spec(fmt));
+    }
+
+    char *format_to(char *first, char *last, util::format_spec spec) const {
+        if (util::decimal_fmt(spec)) return format_decimal_to(first, last, spec);
         if constexpr (util::native_num(size)) {
             uint64_t v = value.value;
             uint64_t xz = xz_mask.value;
-            return util::to_string(fmt, size, v, xz, false);
+            return util::format_to(first, last, spec, size, &v, &xz, false, nullptr);
         } else {
-            return util::to_string(fmt, size, value.value.values.data(),
-                                   xz_mask.value.values.data(), false);
+            return util::format_to(first, last, spec, size, value.value.values.data(),
+                                   xz_mask.value.values.data(), false, nullptr);
         }
     }
 
@@ -89,7 +94,7 @@ public:
         if constexpr (util::native_num(util::total_size(msb, lsb))) {
             index = op.value - util::min(msb, lsb);
         } else {
-            if (op.fit_in_64() && !op.xz_mask.any_set()) {
+            if (op.fit_in_64() && op.known()) {
                 index = op.value.value[0] - util::min(msb, lsb);
             } else {
                 return x_();
@@ -161,6 +166,33 @@ public:
         value.template set<idx, false>();
     }
 
+    // every bit becomes x
+    inline void fill_x() {
+        xz_mask.mask();
+        value.clear();
+    }
+
+    // no x or z bits. operators check this once and then work on value alone, the same way bit does
+    [[nodiscard]] inline bool known() const { return !xz_mask.any_set(); }
+
+    // neither this nor op has x or z bits, in a single pass over both masks
+    template <int op_msb, int op_lsb, bool op_signed, bool op_array>
+    [[nodiscard]] inline bool known(const logic<op_msb, op_lsb, op_signed, op_array> &op) const {
+        auto constexpr op_size = logic<op_msb, op_lsb>::size;
+        if constexpr (util::native_num(size) && util::native_num(op_size)) {
+            return !(static_cast<uint64_t>(xz_mask.value) |
+                     static_cast<uint64_t>(op.xz_mask.value));
+        } else if constexpr (size == op_size) {
+            auto const &a = xz_mask.value.values;
+            auto const &b = op.xz_mask.value.values;
+            uint64_t xz = 0;
+            for (uint64_t i = 0; i < a.size(); i++) xz |= a[i] | b[i];
+            return xz == 0;
+        } else {
+            return known() && op.known();
+        }
+    }
+
     inline void set_z(int idx) {
         xz_mask.set(idx, true);
         value.set(idx, true);
@@ -236,29 +268,36 @@ public:
     /*
      * concatenation
      */
-    template <int arg0_msb, int arg0_lsb, bool arg0_signed>
-    constexpr auto concat(const logic<arg0_msb, arg0_lsb, arg0_signed> &arg0) {
-        auto constexpr final_size = size + logic<arg0_msb, arg0_lsb, arg0_signed>::size;
-        auto res = logic<final_size - 1, 0, signed_>();
-        res.value = value.concat(arg0.value);
-        // concat masks as well
-        res.xz_mask = xz_mask.concat(arg0.xz_mask);
+    // values and masks are concatenated separately, each in a single pass. bit operands carry no
+    // x or z, so their mask part is all zero
+    template <typename U, typename... Ts>
+    [[nodiscard]] auto concat(const U &arg0, const Ts &...args) const {
+        auto constexpr final_size = size + U::size + (Ts::size + ... + 0);
+        logic<final_size - 1, 0, signed_> res;
+        res.value = value.concat(value_of(arg0), value_of(args)...);
+        res.xz_mask = xz_mask.concat(xz_mask_of(arg0), xz_mask_of(args)...);
         return res;
     }
 
-    template <int arg0_msb, int arg0_lsb, bool arg0_signed>
-    constexpr auto concat(const bit<arg0_msb, arg0_lsb, arg0_signed> &arg0) {
-        auto constexpr final_size = size + bit<arg0_msb, arg0_lsb, arg0_signed>::size;
-        auto res = logic<final_size - 1, 0, signed_>();
-        res.value = value.concat(arg0);
-        // concat masks as well
-        res.xz_mask = xz_mask.template extend<final_size>();
+    /*
+     * streaming operators
+     */
+    // {<<slice{this}}
+    template <uint64_t slice = 1>
+    requires(slice > 0) [[nodiscard]] logic<size - 1, 0> stream_left() const {
+        logic<size - 1, 0> res;
+        res.value = value.template stream_left<slice>();
+        res.xz_mask = xz_mask.template stream_left<slice>();
         return res;
     }
 
-    template <typename U, typename... Ts>
-    constexpr auto concat(U arg0, Ts... args) {
-        return this->concat(arg0).concat(args...);
+    // {>>slice{this}}
+    template <uint64_t slice = 1>
+    requires(slice > 0) [[nodiscard]] logic<size - 1, 0> stream_right() const {
+        logic<size - 1, 0> res;
+        res.value = value.template stream_right<slice>();
+        res.xz_mask = xz_mask;
+        return res;
     }
 
     /*
@@ -280,11 +319,11 @@ public:
      */
     explicit operator bool() const {
         // if there is any x or z
-        return (!xz_mask.any_set()) && value.any_set();
+        return known() && value.any_set();
     }
 
     logic<0> operator!() const {
-        return xz_mask.any_set() ? x_() : (value.any_set() ? zero_() : one_());
+        return known() ? (value.any_set() ? zero_() : one_()) : x_();
     }
 
     /*
@@ -300,30 +339,15 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator&(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        // this is the truth table
-        //   0 1 x z
-        // 0 0 0 0 0
-        // 1 0 1 x x
-        // x 0 x x x
-        // z 0 x x x
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
-        result.value = value & op.value;
-        result.xz_mask = xz_mask & op.xz_mask;
-        // we have taken care of the top left and bottom case
-        // i.e.
-        // 0 0 0 0
-        // 0 1
-        // 0   x x
-        // 0   x x
-        // need to take care of the rest
-        // only happens between 1 and x/z. Notice that 1 is encoded as (1, 0) and x is (, 1)
-        //
-        auto mask = (((xz_mask ^ op.xz_mask) & ~xz_mask) & value) |     // 1   & x/z
-                    (((op.xz_mask ^ xz_mask) & ~op.xz_mask) & ~value);  // x/z & 1
-        result.value &= ~mask;
-        result.xz_mask |= mask;
-
-        return result;
+        // wide values without x or z skip the 4-state truth table. for native values it is
+        // branch free and cheaper than the check
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if constexpr (!util::native_num(size)) {
+            if (known(op)) [[likely]] {
+                return result_type{value & op.value};
+            }
+        }
+        return and_xz(op);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -359,36 +383,15 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator|(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        // this is the truth table
-        //   0 1 x z
-        // 0 0 1 x x
-        // 1 1 1 1 1
-        // x x 1 x x
-        // z x 1 x x
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
-        result.value = value | op.value;
-        result.xz_mask = xz_mask | op.xz_mask;
-        // we have taken care of the only top left case
-        // i.e.
-        // 0 0
-        // 0 1
-        //
-        //
-        // notice that for the rest of the empty cells, xz_mask is set properly
-        // we use that to create a msk of change everything into x
-        result.value &= ~result.xz_mask;
-        // now we have something like this
-        //   0 1 x z
-        // 0 0 1 x x
-        // 1 1 1 x x
-        // x x x x x
-        // z x x x x
-        // compute the mask for case // 1 & x/z and x/z & 1
-        auto mask = (((xz_mask ^ op.xz_mask) & ~xz_mask) & value) |     // 1   | x/z
-                    (((op.xz_mask ^ xz_mask) & ~op.xz_mask) & ~value);  // x/z | 1
-        result.value |= mask;
-        result.xz_mask &= ~mask;
-        return result;
+        // wide values without x or z skip the 4-state truth table. for native values it is
+        // branch free and cheaper than the check
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if constexpr (!util::native_num(size)) {
+            if (known(op)) [[likely]] {
+                return result_type{value | op.value};
+            }
+        }
+        return or_xz(op);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -424,25 +427,15 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator^(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        // this is the truth table
-        //   0 1 x z
-        // 0 1 0 x x
-        // 1 0 1 x x
-        // x x x x x
-        // z x x x x
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> result;
-        result.value = value ^ op.value;
-        result.xz_mask = xz_mask | op.xz_mask;
-        // we have taken care of the only top left case
-        // i.e.
-        // 1 0 x z
-        // 0 0 z x
-        // x z x z
-        // z x z x
-        // notice that for the rest of the empty cells, xz_mask is set properly
-        // we use that to create a msk of change everything into x
-        result.value &= ~result.xz_mask;
-        return result;
+        // wide values without x or z skip the 4-state truth table. for native values it is
+        // branch free and cheaper than the check
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if constexpr (!util::native_num(size)) {
+            if (known(op)) [[likely]] {
+                return result_type{value ^ op.value};
+            }
+        }
+        return xor_xz(op);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -470,71 +463,93 @@ public:
     }
 
     logic<size - 1> operator~() const {
-        // this is the truth table
-        //   0 1 x z
-        //   1 0 x x
-        logic<size - 1> result;
-        result.value = ~value;
-        result.xz_mask = xz_mask;
-        // change anything has xz_mask on to x
-        result.value &= ~result.xz_mask;
-        return result;
+        if constexpr (!util::native_num(size)) {
+            if (known()) [[likely]] {
+                return logic<size - 1>{~value};
+            }
+        }
+        return not_xz();
     }
 
     // reduction
+    // all of them work on whole words of value and xz_mask
     [[nodiscard]] logic<0> r_and() const {
-        // zero trump everything
-        // brute force way to compute
-        for (auto i = 0u; i < size; i++) {
-            auto b = value[i];
-            auto m = xz_mask[i];
-            if (!b && !m)
-                return zero_();
-            else if (m)
-                return x_();
+        // any known 0 makes it 0, then any x/z makes it x
+        auto constexpr tail = util::tail_mask(size);
+        if constexpr (util::native_num(size)) {
+            auto const v = static_cast<uint64_t>(value.value);
+            auto const m = static_cast<uint64_t>(xz_mask.value);
+            if (~(v | m) & tail) return zero_();
+            return (m & tail) ? x_() : one_();
+        } else {
+            auto const &v = value.value.values;
+            auto const &m = xz_mask.value.values;
+            auto constexpr n = decltype(value.value)::s;
+            uint64_t xz = 0;
+            for (uint64_t i = 0; i < n - 1; i++) {
+                if (~(v[i] | m[i])) return zero_();
+                xz |= m[i];
+            }
+            if (~(v[n - 1] | m[n - 1]) & tail) return zero_();
+            return (xz | m[n - 1]) ? x_() : one_();
         }
-        return one_();
     }
 
     [[nodiscard]] logic<0> r_nand() const { return !r_and(); }
 
     [[nodiscard]] logic<0> r_or() const {
-        for (auto i = 0u; i < size; i++) {
-            auto b = value[i];
-            auto m = xz_mask[i];
-            if (b && !m)
-                return one_();
-            else if (m)
-                return x_();
+        // any known 1 makes it 1, then any x/z makes it x
+        auto constexpr tail = util::tail_mask(size);
+        if constexpr (util::native_num(size)) {
+            auto const v = static_cast<uint64_t>(value.value);
+            auto const m = static_cast<uint64_t>(xz_mask.value);
+            if (v & ~m & tail) return one_();
+            return (m & tail) ? x_() : zero_();
+        } else {
+            // unused bits are always 0
+            auto const &v = value.value.values;
+            auto const &m = xz_mask.value.values;
+            uint64_t xz = 0;
+            for (uint64_t i = 0; i < v.size(); i++) {
+                if (v[i] & ~m[i]) return one_();
+                xz |= m[i];
+            }
+            return xz ? x_() : zero_();
         }
-        return zero_();
     }
 
     [[nodiscard]] logic<0> r_nor() const { return !r_or(); }
 
     [[nodiscard]] logic<0> r_xor() const {
-        // this is the truth table
-        //   0 1 x z
-        // 0 1 0 x x
-        // 1 0 1 x x
-        // x x x x x
-        // z x x x x
-        // if x/z is set, it's always x
-        if (xz_mask.any_set()) return x_();
-        auto bits_count = value.popcount();
-        auto zeros = size - bits_count;
-        return (zeros % 2) ? one_() : zero_();
+        // if x/z is set, it's always x. otherwise it's the parity
+        if (!known()) return x_();
+        uint64_t fold;
+        if constexpr (util::native_num(size)) {
+            fold = static_cast<uint64_t>(value.value) & util::tail_mask(size);
+        } else {
+            fold = std::reduce(value.value.values.begin(), value.value.values.end(), uint64_t{0},
+                               [](auto a, auto b) { return a ^ b; });
+        }
+        return (std::popcount(fold) & 1) ? one_() : zero_();
     }
 
     [[nodiscard]] logic<0> r_xnor() const { return !r_xor(); }
 
     auto &operator++() {
-        (*this) = (*this) + one_();
+        if (!known()) [[unlikely]] {
+            fill_x();
+        } else {
+            ++value;
+        }
         return *this;
     }
 
     auto &operator--() {
-        (*this) = (*this) - one_();
+        if (!known()) [[unlikely]] {
+            fill_x();
+        } else {
+            --value;
+        }
         return *this;
     }
 
@@ -554,15 +569,12 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     auto operator>>(const logic<op_msb, op_lsb, op_signed> &amount) const {
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> res;
-        if (amount.xz_mask.any_set() || xz_mask.any_set()) [[unlikely]] {
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if (!known(amount)) [[unlikely]] {
             // return all x
-            res.xz_mask.mask();
-        } else {
-            res.value = value >> amount.value;
-            res.xz_mask = xz_mask >> amount.value;
+            return result_type{};
         }
-        return res;
+        return result_type{value >> amount.value};
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -582,15 +594,12 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     auto operator<<(const logic<op_msb, op_lsb, op_signed> &amount) const {
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> res;
-        if (amount.xz_mask.any_set() || xz_mask.any_set()) [[unlikely]] {
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if (!known(amount)) [[unlikely]] {
             // return all x
-            res.xz_mask.mask();
-        } else {
-            res.value = value << amount.value;
-            res.xz_mask = xz_mask << amount.value;
+            return result_type{};
         }
-        return res;
+        return result_type{value << amount.value};
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -610,28 +619,22 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     auto ashr(const logic<op_msb, op_lsb, op_signed> &amount) const {
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> res;
-        if (amount.xz_mask.any_set() || xz_mask.any_set()) [[unlikely]] {
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if (!known(amount)) [[unlikely]] {
             // return all x
-            res.xz_mask.mask();
-        } else {
-            res.value = value.ashr(amount.value);
-            res.xz_mask = xz_mask.ashr(amount.value);
+            return result_type{};
         }
-        return res;
+        return result_type{value.ashr(amount.value)};
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
     auto ashl(const logic<op_msb, op_lsb, op_signed> &amount) const {
-        logic<size - 1, 0, util::signed_result(signed_, op_signed)> res;
-        if (amount.xz_mask.any_set() || xz_mask.any_set()) [[unlikely]] {
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        if (!known(amount)) [[unlikely]] {
             // return all x
-            res.xz_mask.mask();
-        } else {
-            res.value = value.ashl(amount.value);
-            res.xz_mask = xz_mask.ashl(amount.value);
+            return result_type{};
         }
-        return res;
+        return result_type{value.ashl(amount.value)};
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -644,8 +647,7 @@ public:
      */
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator==(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value == target.value ? one_() : zero_();
+        return known_or_x(known(target), value == target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -655,8 +657,7 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator!=(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value != target.value ? one_() : zero_();
+        return known_or_x(known(target), value != target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -686,8 +687,7 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator>(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value > target.value ? one_() : zero_();
+        return known_or_x(known(target), value > target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -697,8 +697,7 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator<(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value < target.value ? one_() : zero_();
+        return known_or_x(known(target), value < target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -708,8 +707,7 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator>=(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value >= target.value ? one_() : zero_();
+        return known_or_x(known(target), value >= target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -719,8 +717,7 @@ public:
 
     template <int op_msb, int op_lsb, bool op_signed>
     logic<0> operator<=(const logic<op_msb, op_lsb, op_signed> &target) const {
-        if (xz_mask.any_set() || target.xz_mask.any_set()) return x_();
-        return value <= target.value ? one_() : zero_();
+        return known_or_x(known(target), value <= target.value);
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -729,7 +726,7 @@ public:
     }
 
     constexpr auto operator-() const {
-        if (xz_mask.any_set()) return logic<msb, lsb, signed_>();
+        if (!known()) return logic<msb, lsb, signed_>();
         logic<msb, lsb, signed_> result(0);
         static_assert(!std::is_same_v<int, decltype(value)>);
         result.value = -value;
@@ -737,7 +734,7 @@ public:
     }
 
     constexpr auto operator+() const {
-        if (xz_mask.any_set()) return logic<msb, lsb, signed_>();
+        if (!known()) return logic<msb, lsb, signed_>();
         return *this;
     }
 
@@ -754,11 +751,8 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator+(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        if (xz_mask.any_set() || op.xz_mask.any_set()) [[unlikely]] {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>();
-        } else {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>{value + op.value};
-        }
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        return known_or_x(known(op), result_type{value + op.value});
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -766,6 +760,27 @@ public:
         return this->template operator+(logic(target));
     }
 
+    // in-place, the result is truncated to the size of this
+    template <int op_msb, int op_lsb, bool op_signed>
+    logic &operator+=(const logic<op_msb, op_lsb, op_signed> &op) {
+        if (!known(op)) [[unlikely]] {
+            fill_x();
+        } else {
+            value += op.value;
+        }
+        return *this;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    logic &operator+=(const bit<op_msb, op_lsb, op_signed> &op) {
+        if (!known()) [[unlikely]] {
+            fill_x();
+        } else {
+            value += op;
+        }
+        return *this;
+    }
+
     template <uint64_t target_size, int op_msb, int op_lsb, bool op_signed>
     requires(target_size >= util::max(size, logic<op_msb, op_lsb>::size)) auto add(
         const logic<op_msb, op_lsb, op_signed> &op) const {
@@ -785,11 +800,8 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator-(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        if (xz_mask.any_set() || op.xz_mask.any_set()) [[unlikely]] {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>();
-        } else {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>{value - op.value};
-        }
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        return known_or_x(known(op), result_type{value - op.value});
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -797,6 +809,26 @@ public:
         return this->template operator-(logic(target));
     }
 
+    template <int op_msb, int op_lsb, bool op_signed>
+    logic &operator-=(const logic<op_msb, op_lsb, op_signed> &op) {
+        if (!known(op)) [[unlikely]] {
+            fill_x();
+        } else {
+            value -= op.value;
+        }
+        return *this;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    logic &operator-=(const bit<op_msb, op_lsb, op_signed> &op) {
+        if (!known()) [[unlikely]] {
+            fill_x();
+        } else {
+            value -= op;
+        }
+        return *this;
+    }
+
     template <uint64_t target_size, int op_msb, int op_lsb, bool op_signed>
     requires(target_size >= util::max(size, logic<op_msb, op_lsb>::size)) auto minus(
         const logic<op_msb, op_lsb, op_signed> &op) const {
@@ -816,11 +848,8 @@ public:
 
     template <int op_lsb, bool op_signed>
     auto operator*(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
-        if (xz_mask.any_set() || op.xz_mask.any_set()) [[unlikely]] {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>();
-        } else {
-            return logic<size - 1, 0, util::signed_result(signed_, op_signed)>{value * op.value};
-        }
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        return known_or_x(known(op), result_type{value * op.value});
     }
 
     template <int op_msb, int op_lsb, bool op_signed>
@@ -848,7 +877,7 @@ public:
     template <int op_lsb, bool op_signed>
     auto operator/(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
         // if the op is 0, return x
-        if (xz_mask.any_set() || op.xz_mask.any_set() || !op.value.any_set()) [[unlikely]] {
+        if (!known(op) || !op.value.any_set()) [[unlikely]] {
             return logic<size - 1, 0, util::signed_result(signed_, op_signed)>();
         } else {
             return logic<size - 1, 0, util::signed_result(signed_, op_signed)>{value / op.value};
@@ -880,7 +909,7 @@ public:
     template <int op_lsb, bool op_signed>
     auto operator%(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
         // if the op is 0, return x
-        if (xz_mask.any_set() || op.xz_mask.any_set() || !op.value.any_set()) [[unlikely]] {
+        if (!known(op) || !op.value.any_set()) [[unlikely]] {
             return logic<size - 1, 0, util::signed_result(signed_, op_signed)>();
         } else {
             return logic<size - 1, 0, util::signed_result(signed_, op_signed)>{value % op.value};
@@ -902,6 +931,55 @@ public:
         return result;
     }
 
+    // quotient and remainder from a single division. both are x if the divisor is 0
+    template <int op_msb, int op_lsb, bool op_signed>
+    requires(logic<op_msb, op_lsb>::size != size) auto div_mod(
+        const logic<op_msb, op_lsb, op_signed> &op) const {
+        auto constexpr target_size = util::max(size, logic<op_msb, op_lsb>::size);
+        auto l = this->template extend<target_size>();
+        auto r = op.template extend<target_size>();
+        return l.div_mod(r);
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto div_mod(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        std::pair<result_type, result_type> result;
+        if (!known(op) || !op.value.any_set()) [[unlikely]] {
+            return result;
+        }
+        auto [q, r] = value.div_mod(op.value);
+        result.first = result_type{q};
+        result.second = result_type{r};
+        return result;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    auto div_mod(const bit<op_msb, op_lsb, op_signed> &op) const {
+        return this->template div_mod(logic<op_msb, op_lsb, op_signed>(op));
+    }
+
+    // power operator (**) following LRM Table 11-4. any x/z bit, or 0 to a negative power,
+    // produces x
+    template <int op_msb, int op_lsb, bool op_signed>
+    [[nodiscard]] logic<size - 1, 0, signed_> pow(
+        const logic<op_msb, op_lsb, op_signed> &op) const {
+        if (!known(op)) [[unlikely]] {
+            return {};
+        }
+        if constexpr (op_signed) {
+            if (!value.any_set() && op.value.negative()) [[unlikely]] {
+                return {};
+            }
+        }
+        return logic<size - 1, 0, signed_>{value.pow(op.value)};
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    [[nodiscard]] logic<size - 1, 0, signed_> pow(const bit<op_msb, op_lsb, op_signed> &op) const {
+        return this->template pow(logic<op_msb, op_lsb, op_signed>(op));
+    }
+
     [[nodiscard]] constexpr logic<size - 1, 0, true> to_signed() const {
         logic<size - 1, 0, true> result;
         result.value = value.to_signed();
@@ -937,7 +1015,7 @@ public:
      * value conversions
      */
     [[nodiscard]] uint64_t to_uint64() const {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_uint64();
@@ -945,56 +1023,56 @@ public:
 
     // automatic conversion
     [[nodiscard]] int8_t to_num() const requires(signed_ &&size <= 8) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] uint8_t to_num() const requires(!signed_ && size <= 8) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] int16_t to_num() const requires(signed_ &&size > 8 && size <= 16) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] uint16_t to_num() const requires(!signed_ && size > 8 && size <= 16) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] int32_t to_num() const requires(signed_ &&size > 16 && size <= 32) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] uint32_t to_num() const requires(!signed_ && size > 16 && size <= 32) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] int64_t to_num() const requires(signed_ &&size > 32 && size <= 64) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
     }
 
     [[nodiscard]] uint64_t to_num() const requires(!signed_ && size > 32 && size <= 64) {
-        if (xz_mask.any_set())
+        if (!known())
             return 0;
         else
             return value.to_num();
@@ -1023,9 +1101,8 @@ public:
 
     // conversion from bit to logic
     template <bool new_signed>
-    constexpr logic(const bit<msb, lsb, new_signed> &b) : value(b) {  // NOLINT
-        xz_mask.clear();
-    }
+    // xz_mask starts out as 0 already
+    constexpr logic(const bit<msb, lsb, new_signed> &b) : value(b) {}  // NOLINT
 
     // shifting msb and lsb
     template <int new_msb, int new_lsb, bool new_signed>
@@ -1078,8 +1155,78 @@ public:
     }
 
 private:
+    // decimal digits are the only ones that need scratch space, which is kept out of the stack
+    // frame of the other bases
+    LOGIC_NOINLINE char *format_decimal_to(char *first, char *last, util::format_spec spec) const {
+        std::array<uint64_t, util::format_scratch_words(size)> scratch;
+        if constexpr (signed_) {
+            if (value.negative()) {
+                auto value_ = value.negate().value;
+                if constexpr (util::native_num(size)) {
+                    uint64_t v = value_;
+                    uint64_t xz = xz_mask.value;
+                    return util::format_to(first, last, spec, size, &v, &xz, true,
+                                           scratch.data());
+                } else {
+                    return util::format_to(first, last, spec, size, value_.values.data(),
+                                           xz_mask.value.values.data(), true, scratch.data());
+                }
+            }
+        }
+        if constexpr (util::native_num(size)) {
+            uint64_t v = value.value;
+            uint64_t xz = xz_mask.value;
+            return util::format_to(first, last, spec, size, &v, &xz, false, scratch.data());
+        } else {
+            return util::format_to(first, last, spec, size, value.value.values.data(),
+                                   xz_mask.value.values.data(), false, scratch.data());
+        }
+    }
+
     void unmask_bit(uint64_t idx) { xz_mask.set(idx, false); }
 
+    // r when the operands are known, x otherwise. native values are selected without a branch,
+    // which keeps loops over them vectorizable
+    template <typename T>
+    static constexpr T known_or_x(bool known, const T &r) {
+        if constexpr (util::native_num(T::size)) {
+            T result = r;
+            result.value.value = known ? r.value.value : 0;
+            result.xz_mask.value = known ? 0 : T().xz_mask.value;
+            return result;
+        } else {
+            return known ? r : T();
+        }
+    }
+
+    static constexpr logic<0> known_or_x(bool known, bool r) {
+        logic<0> result;
+        result.value.value = known && r;
+        result.xz_mask.value = !known;
+        return result;
+    }
+
+    // value and xz mask views of a concat operand
+    template <int op_msb, int op_lsb, bool op_signed>
+    static const auto &value_of(const logic<op_msb, op_lsb, op_signed> &op) {
+        return op.value;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed, bool op_array>
+    static const auto &value_of(const bit<op_msb, op_lsb, op_signed, op_array> &op) {
+        return op;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed>
+    static const auto &xz_mask_of(const logic<op_msb, op_lsb, op_signed> &op) {
+        return op.xz_mask;
+    }
+
+    template <int op_msb, int op_lsb, bool op_signed, bool op_array>
+    static auto xz_mask_of(const bit<op_msb, op_lsb, op_signed, op_array> &) {
+        return bit<bit<op_msb, op_lsb>::size - 1, 0>();
+    }
+
     template <uint64_t idx>
     void unmask_bit() {
         xz_mask.template set<idx, false>();
@@ -1115,6 +1262,107 @@ private:
     }
 
 protected:
+    // bitwise operators with x or z operands
+    template <int op_lsb, bool op_signed>
+    auto and_xz(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        // this is the truth table
+        //   0 1 x z
+        // 0 0 0 0 0
+        // 1 0 1 x x
+        // x 0 x x x
+        // z 0 x x x
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        result_type result;
+        result.value = value & op.value;
+        result.xz_mask = xz_mask & op.xz_mask;
+        // we have taken care of the top left and bottom case
+        // i.e.
+        // 0 0 0 0
+        // 0 1
+        // 0   x x
+        // 0   x x
+        // need to take care of the rest
+        // only happens between 1 and x/z. Notice that 1 is encoded as (1, 0) and x is (, 1)
+        //
+        auto mask = (((xz_mask ^ op.xz_mask) & ~xz_mask) & value) |     // 1   & x/z
+                    (((op.xz_mask ^ xz_mask) & ~op.xz_mask) & ~value);  // x/z & 1
+        result.value &= ~mask;
+        result.xz_mask |= mask;
+
+        return result;
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto or_xz(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        // this is the truth table
+        //   0 1 x z
+        // 0 0 1 x x
+        // 1 1 1 1 1
+        // x x 1 x x
+        // z x 1 x x
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        result_type result;
+        result.value = value | op.value;
+        result.xz_mask = xz_mask | op.xz_mask;
+        // we have taken care of the only top left case
+        // i.e.
+        // 0 0
+        // 0 1
+        //
+        //
+        // notice that for the rest of the empty cells, xz_mask is set properly
+        // we use that to create a msk of change everything into x
+        result.value &= ~result.xz_mask;
+        // now we have something like this
+        //   0 1 x z
+        // 0 0 1 x x
+        // 1 1 1 x x
+        // x x x x x
+        // z x x x x
+        // compute the mask for case // 1 & x/z and x/z & 1
+        auto mask = (((xz_mask ^ op.xz_mask) & ~xz_mask) & value) |     // 1   | x/z
+                    (((op.xz_mask ^ xz_mask) & ~op.xz_mask) & ~value);  // x/z | 1
+        result.value |= mask;
+        result.xz_mask &= ~mask;
+        return result;
+    }
+
+    template <int op_lsb, bool op_signed>
+    auto xor_xz(const logic<size - 1 + op_lsb, op_lsb, op_signed> &op) const {
+        // this is the truth table
+        //   0 1 x z
+        // 0 1 0 x x
+        // 1 0 1 x x
+        // x x x x x
+        // z x x x x
+        using result_type = logic<size - 1, 0, util::signed_result(signed_, op_signed)>;
+        result_type result;
+        result.value = value ^ op.value;
+        result.xz_mask = xz_mask | op.xz_mask;
+        // we have taken care of the only top left case
+        // i.e.
+        // 1 0 x z
+        // 0 0 z x
+        // x z x z
+        // z x z x
+        // notice that for the rest of the empty cells, xz_mask is set properly
+        // we use that to create a msk of change everything into x
+        result.value &= ~result.xz_mask;
+        return result;
+    }
+
+    [[nodiscard]] logic<size - 1> not_xz() const {
+        // this is the truth table
+        //   0 1 x z
+        //   1 0 x x
+        logic<size - 1> result;
+        result.value = ~value;
+        result.xz_mask = xz_mask;
+        // change anything has xz_mask on to x
+        result.value &= ~result.xz_mask;
+        return result;
+    }
+
     template <int a, int b>
     requires(util::max(a, b) < size) constexpr logic<util::abs_diff(a, b)> inline slice_() const {
         if constexpr (size <= util::max(a, b)) {
@@ -1130,10 +1378,23 @@ protected:
         return result;
     }
 
+    // both sides index from bit 0 upwards, so a slice update is a plain bit range copy
+    template <int op_hi, int op_lo>
+    static constexpr bool word_aligned_update() {
+        return big_endian && util::min(msb, lsb) == 0 && logic<op_hi, op_lo>::big_endian &&
+               util::min(op_hi, op_lo) == 0;
+    }
+
     template <int hi, int lo = hi, int op_hi, int op_lo, bool op_signed>
     void update_(const logic<op_hi, op_lo, op_signed> &op) requires(hi < size && lo < size &&
                                                                     util::match_endian(hi, lo, msb,
                                                                                        lsb)) {
+        if constexpr (word_aligned_update<op_hi, op_lo>()) {
+            // out of range bits are 0 on both value and xz_mask
+            value.template update<hi, lo>(op.value);
+            xz_mask.template update<hi, lo>(op.xz_mask);
+            return;
+        }
         auto constexpr start = util::min(hi, lo);
         auto constexpr end = util::max(hi, lo) + 1;
         for (auto i = start; i < end; i++) {
@@ -1159,6 +1420,11 @@ protected:
 
     template <int op_hi, int op_lo, bool op_signed>
     void update_(int hi, int lo, const logic<op_hi, op_lo, op_signed> &op) {
+        if constexpr (word_aligned_update<op_hi, op_lo>()) {
+            value.update(hi, lo, op.value);
+            xz_mask.update(hi, lo, op.xz_mask);
+            return;
+        }
         auto start = util::min(hi, lo);
         auto end = util::max(hi, lo) + 1;
         for (auto i = start; i < end; i++) {
@@ -1193,6 +1459,19 @@ constexpr logic<31, 0, true> operator""_logic(unsigned long long value) {
 constexpr logic<63, 0, true> operator""_logic64(unsigned long long value) {
     return logic<63, 0, true>(static_cast<int64_t>(value)).extend<64>();
 }
+
+// sized literals such as "4'b10xz"_logic, with the width and signedness taken from the literal
+// and the value and xz bits parsed at compile time
+template <util::fixed_string str>
+consteval auto operator""_logic() {
+    constexpr auto format = util::parse_literal_format(str.view());
+    constexpr auto words =
+        util::parse_literal<format.size>(str.view().substr(format.pos), format.base);
+    logic<format.size - 1, 0, format.signed_> result;
+    util::set_words(result.value, words.value);
+    util::set_words(result.xz_mask, words.xz_mask);
+    return result;
+}
 }  // namespace literals
 
 // helper functions
@@ -1201,5 +1480,82 @@ auto concat(U arg0, Ts... args) {
     return arg0.concat(args...);
 }
 
+template <uint64_t slice = 1, typename U, typename... Ts>
+auto stream_left(const U &arg0, const Ts &...args) {
+    if constexpr (sizeof...(Ts) == 0) {
+        return arg0.template stream_left<slice>();
+    } else {
+        return arg0.concat(args...).template stream_left<slice>();
+    }
+}
+
+template <uint64_t slice = 1, typename U, typename... Ts>
+auto stream_right(const U &arg0, const Ts &...args) {
+    if constexpr (sizeof...(Ts) == 0) {
+        return arg0.template stream_right<slice>();
+    } else {
+        return arg0.concat(args...).template stream_right<slice>();
+    }
+}
+
+namespace util {
+// formats a bit or logic into an output iterator without allocating. the digits go through a
+// stack buffer that fits every base at its natural width, and a wider field is padded here with
+// the same character format_to pads with
+template <typename T, typename OutputIt>
+OutputIt format_to_iterator(OutputIt out, const T &v, format_spec spec) {
+    // size binary digits, or a sign and fewer decimal ones
+    std::array<char, T::size + 1> buffer;
+    if (spec.width > 0) {
+        auto const natural = format_size(format_spec{spec.base, -1}, T::size) - 1;
+        if (static_cast<uint64_t>(spec.width) > natural) {
+            auto const l = spec.base | 0x20;
+            auto const pad = l == 'b' || l == 'o' || l == 'h' || l == 'x' ? '0' : ' ';
+            out = std::fill_n(out, static_cast<uint64_t>(spec.width) - natural, pad);
+        }
+        spec.width = -1;
+    }
+    auto *end = v.format_to(buffer.data(), buffer.data() + buffer.size(), spec);
+    return std::copy(buffer.data(), end, out);
+}
+
+#if __cpp_lib_format
+// std::format support. the format spec is the one str() takes, e.g. {:h} or {:08b}, and an empty
+// one is binary
+struct formatter_base {
+    format_spec spec = {'b', -1};
+
+    constexpr auto parse(std::format_parse_context &ctx) {
+        auto it = ctx.begin();
+        while (it != ctx.end() && *it != '}') it++;
+        if (it == ctx.begin()) return it;
+        std::string_view const fmt(ctx.begin(), it);
+        spec = parse_format_spec(fmt);
+        auto const l = fmt.back() | 0x20;
+        if (fmt.find_first_not_of("0123456789") != fmt.size() - 1 ||
+            !(l == 'b' || l == 'o' || l == 'd' || l == 'h' || l == 'x' || l == 's' || l == 'c')) {
+            throw std::format_error("invalid format spec for bit or logic");
+        }
+        return it;
+    }
+
+    template <typename T, typename FormatContext>
+    auto format(const T &v, FormatContext &ctx) const {
+        return format_to_iterator(ctx.out(), v, spec);
+    }
+};
+#endif
+
+}  // namespace util
+
 }  // namespace logic
+
+#if __cpp_lib_format
+template <int msb, int lsb, bool signed_, bool array>
+struct std::formatter<logic::bit<msb, lsb, signed_, array>> : logic::util::formatter_base {};
+
+template <int msb, int lsb, bool signed_, bool array>
+struct std::formatter<logic::logic<msb, lsb, signed_, array>> : logic::util::formatter_base {};
+#endif
+
 #endif  // LOGIC_LOGIC_HH
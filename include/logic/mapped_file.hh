@@ -0,0 +1,32 @@
+#ifndef LOGIC_MAPPED_FILE_HH
+#define LOGIC_MAPPED_FILE_HH
+
+#include <string>
+#include <string_view>
+
+namespace logic::util {
+
+// read-only view of a whole file. it is memory mapped where the platform allows it, so pages are
+// only read when they are touched, and read into memory otherwise
+class mapped_file {
+public:
+    // sequential hints the OS to read ahead, for files that are read front to back
+    explicit mapped_file(const std::string &filename, bool sequential = false);
+    ~mapped_file();
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] std::string_view data() const { return data_; }
+
+private:
+    bool ok_ = false;
+    void *map_ = nullptr;
+    std::string buffer_;
+    std::string_view data_;
+};
+
+}  // namespace logic::util
+
+#endif  // LOGIC_MAPPED_FILE_HH
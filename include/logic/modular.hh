@@ -0,0 +1,452 @@
+#ifndef LOGIC_MODULAR_HH
+#define LOGIC_MODULAR_HH
+
+#include <vector>
+
+#include "bit.hh"
+
+namespace logic {
+
+namespace util {
+// compares a[0, n) with b[0, n). returns -1, 0 or 1
+inline int cmp_n(const uint64_t *a, const uint64_t *b, uint64_t n) {
+    for (uint64_t i = n; i > 0; i--) {
+        if (a[i - 1] != b[i - 1]) return a[i - 1] > b[i - 1] ? 1 : -1;
+    }
+    return 0;
+}
+
+// number of words up to the highest non-zero one
+inline uint64_t used_words(const uint64_t *a, uint64_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+// -m^-1 mod 2^64 for odd m, using Newton's iteration. every iteration doubles the correct bits
+constexpr uint64_t neg_inverse(uint64_t m) {
+    uint64_t inv = m;  // correct to 3 bits since m * m = 1 mod 8
+    for (auto i = 0; i < 5; i++) {
+        inv *= 2 - m * inv;
+    }
+    return ~inv + 1;
+}
+
+// r[0, n) = a * b * R^-1 mod m, where R = 2^(64n). a and b have to be less than m
+// t needs to hold at least n + 2 words. r can alias a or b
+// coarsely integrated operand scanning (CIOS) Montgomery multiplication
+inline void mont_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, const uint64_t *m,
+                     uint64_t n, uint64_t m_inv, uint64_t *t) {
+    std::fill(t, t + n + 2, 0);
+    for (uint64_t i = 0; i < n; i++) {
+        // t += a * b[i]
+        uint64_t carry = 0;
+        for (uint64_t j = 0; j < n; j++) {
+            __uint128_t v = static_cast<__uint128_t>(a[j]) * b[i] + t[j] + carry;
+            t[j] = static_cast<uint64_t>(v);
+            carry = static_cast<uint64_t>(v >> 64);
+        }
+        __uint128_t v = static_cast<__uint128_t>(t[n]) + carry;
+        t[n] = static_cast<uint64_t>(v);
+        t[n + 1] = static_cast<uint64_t>(v >> 64);
+        // t = (t + q * m) / 2^64, where q is chosen so that the lowest word cancels out
+        auto const q = t[0] * m_inv;
+        v = static_cast<__uint128_t>(q) * m[0] + t[0];
+        carry = static_cast<uint64_t>(v >> 64);
+        for (uint64_t j = 1; j < n; j++) {
+            v = static_cast<__uint128_t>(q) * m[j] + t[j] + carry;
+            t[j - 1] = static_cast<uint64_t>(v);
+            carry = static_cast<uint64_t>(v >> 64);
+        }
+        v = static_cast<__uint128_t>(t[n]) + carry;
+        t[n - 1] = static_cast<uint64_t>(v);
+        t[n] = t[n + 1] + static_cast<uint64_t>(v >> 64);
+    }
+    // t < 2m, so one subtraction is enough
+    if (t[n] || cmp_n(t, m, n) >= 0) {
+        sub_n(t, t, m, n);
+    }
+    std::copy(t, t + n, r);
+}
+
+// window size for the sliding window exponentiation based on the exponent bits
+constexpr uint64_t pow_window_size(uint64_t bits) {
+    if (bits > 671) return 6;
+    if (bits > 239) return 5;
+    if (bits > 79) return 4;
+    if (bits > 23) return 3;
+    return 1;
+}
+
+// r[0, n) = base^e in whatever domain ctx multiplies in. one is the identity in that domain.
+// ctx needs to provide n(), scratch_size() and mul(r, a, b, t) for n-word values
+// left-to-right sliding window exponentiation, using only the odd powers of the base
+template <typename T>
+void pow_window(const T &ctx, uint64_t *r, const uint64_t *base, const uint64_t *one,
+                const uint64_t *e, uint64_t e_words) {
+    auto const n = ctx.n();
+    e_words = used_words(e, e_words);
+    std::copy(one, one + n, r);
+    if (e_words == 0) return;
+    auto const bits = e_words * 64 - static_cast<uint64_t>(__builtin_clzll(e[e_words - 1]));
+    auto const k = pow_window_size(bits);
+    auto get_bit = [e](uint64_t i) { return (e[i / 64] >> (i % 64)) & 1; };
+
+    // table[i] = base^(2i + 1)
+    auto const table_size = 1ull << (k - 1);
+    std::vector<uint64_t> table(table_size * n);
+    std::vector<uint64_t> t(ctx.scratch_size());
+    std::vector<uint64_t> base_sqr(n);
+    std::copy(base, base + n, table.data());
+    if (table_size > 1) {
+        ctx.mul(base_sqr.data(), base, base, t.data());
+        for (uint64_t i = 1; i < table_size; i++) {
+            ctx.mul(table.data() + i * n, table.data() + (i - 1) * n, base_sqr.data(), t.data());
+        }
+    }
+
+    bool started = false;
+    auto i = static_cast<int64_t>(bits) - 1;
+    while (i >= 0) {
+        if (!get_bit(i)) {
+            if (started) ctx.mul(r, r, r, t.data());
+            i--;
+            continue;
+        }
+        // find the longest window ending with a 1
+        auto l = util::max<int64_t>(i - static_cast<int64_t>(k) + 1, 0);
+        while (!get_bit(l)) l++;
+        uint64_t window = 0;
+        for (auto j = i; j >= l; j--) {
+            window = (window << 1) | get_bit(j);
+            if (started) ctx.mul(r, r, r, t.data());
+        }
+        auto const *power = table.data() + (window >> 1) * n;
+        if (started) {
+            ctx.mul(r, r, power, t.data());
+        } else {
+            std::copy(power, power + n, r);
+            started = true;
+        }
+        i = l - 1;
+    }
+}
+
+// r[0, nm) = a[0, na) mod m[0, nm). m[nm - 1] has to be non-zero. t needs na + nm + 1 words
+// and q needs na - nm + 1 words
+inline void mod_n(uint64_t *r, const uint64_t *a, uint64_t na, const uint64_t *m, uint64_t nm,
+                  uint64_t *q, uint64_t *t) {
+    na = used_words(a, na);
+    if (na < nm || (na == nm && cmp_n(a, m, nm) < 0)) {
+        std::fill(r, r + nm, 0);
+        std::copy(a, a + na, r);
+        return;
+    }
+    div_mod_n(q, r, a, na, m, nm, t);
+}
+
+// unsigned bits of a native bit value
+template <int msb, int lsb, bool signed_>
+requires(native_num(total_size(msb, lsb))) uint64_t native_value(const bit<msb, lsb, signed_> &v) {
+    constexpr auto size = total_size(msb, lsb);
+    auto result = static_cast<uint64_t>(v.value);
+    if constexpr (size < 64) result &= (1ull << size) - 1;
+    return result;
+}
+
+}  // namespace util
+
+/*
+ * Montgomery context for a fixed odd modulus. Use it when many modular multiplications
+ * or exponentiation share the same modulus, e.g. checking modexp results in a scoreboard.
+ * values passed into multiply() are in Montgomery form, i.e. aR mod m
+ */
+template <uint64_t size>
+struct montgomery {
+public:
+    using value_type = big_num<size, false>;
+    constexpr static auto s = value_type::s;
+
+    template <bool signed_>
+    explicit montgomery(const big_num<size, signed_> &modulus) : modulus_(modulus) {
+        n_ = modulus_.used_words();
+        if (!valid()) return;
+        m_inv_ = util::neg_inverse(modulus_.values[0]);
+        // R^2 mod m, where R = 2^(64n)
+        std::vector<uint64_t> r2(2 * n_ + 1, 0), q(n_ + 2), t(3 * n_ + 2);
+        r2[2 * n_] = 1;
+        util::div_mod_n(q.data(), r2_.values.data(), r2.data(), 2 * n_ + 1, modulus_.values.data(),
+                        n_, t.data());
+        // R mod m is the Montgomery form of 1
+        one_ = to_montgomery(value_type(1u));
+    }
+
+    // Montgomery multiplication only works with odd modulus
+    [[nodiscard]] bool valid() const { return n_ > 0 && (modulus_.values[0] & 1); }
+    [[nodiscard]] const value_type &modulus() const { return modulus_; }
+
+    template <bool signed_>
+    [[nodiscard]] value_type to_montgomery(const big_num<size, signed_> &a) const {
+        auto a_ = reduce(a);
+        value_type result;
+        mul(result.values.data(), a_.values.data(), r2_.values.data());
+        return result;
+    }
+
+    [[nodiscard]] value_type from_montgomery(const value_type &a) const {
+        value_type result;
+        value_type one(1u);
+        mul(result.values.data(), a.values.data(), one.values.data());
+        return result;
+    }
+
+    // multiplication in the Montgomery domain, i.e. aR * bR -> abR
+    [[nodiscard]] value_type multiply(const value_type &a, const value_type &b) const {
+        value_type result;
+        mul(result.values.data(), a.values.data(), b.values.data());
+        return result;
+    }
+
+    template <bool a_signed, bool b_signed>
+    [[nodiscard]] value_type mulmod(const big_num<size, a_signed> &a,
+                                    const big_num<size, b_signed> &b) const {
+        if (!valid()) return {};
+        return from_montgomery(multiply(to_montgomery(a), to_montgomery(b)));
+    }
+
+    template <bool signed_, uint64_t e_size, bool e_signed>
+    [[nodiscard]] value_type powmod(const big_num<size, signed_> &a,
+                                    const big_num<e_size, e_signed> &e) const {
+        value_type result;
+        if (!valid()) return result;
+        auto base = to_montgomery(a);
+        util::pow_window(*this, result.values.data(), base.values.data(), one_.values.data(),
+                         e.values.data(), e.s);
+        return from_montgomery(result);
+    }
+
+    // interface used by util::pow_window
+    [[nodiscard]] uint64_t n() const { return n_; }
+    [[nodiscard]] uint64_t scratch_size() const { return n_ + 2; }
+    void mul(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t *t) const {
+        util::mont_mul(r, a, b, modulus_.values.data(), n_, m_inv_, t);
+    }
+
+private:
+    value_type modulus_;
+    value_type r2_;
+    value_type one_;
+    uint64_t n_ = 0;
+    uint64_t m_inv_ = 0;
+
+    void mul(uint64_t *r, const uint64_t *a, const uint64_t *b) const {
+        std::array<uint64_t, s + 2> t;
+        mul(r, a, b, t.data());
+    }
+
+    template <bool signed_>
+    value_type reduce(const big_num<size, signed_> &a) const {
+        value_type result;
+        std::array<uint64_t, s + 1> q;
+        std::array<uint64_t, 2 * s + 1> t;
+        util::mod_n(result.values.data(), a.values.data(), s, modulus_.values.data(), n_, q.data(),
+                    t.data());
+        return result;
+    }
+};
+
+/*
+ * Barrett context for a fixed modulus. Unlike Montgomery it works for even modulus as well,
+ * and values stay in the normal domain
+ */
+template <uint64_t size>
+struct barrett {
+public:
+    using value_type = big_num<size, false>;
+    constexpr static auto s = value_type::s;
+
+    template <bool signed_>
+    explicit barrett(const big_num<size, signed_> &modulus) : modulus_(modulus) {
+        n_ = modulus_.used_words();
+        if (!valid()) return;
+        // mu = floor(B^2n / m), where B = 2^64. mu takes at most n + 2 words
+        std::vector<uint64_t> b2(2 * n_ + 1, 0), r(n_), t(3 * n_ + 2);
+        b2[2 * n_] = 1;
+        util::div_mod_n(mu_.data(), r.data(), b2.data(), 2 * n_ + 1, modulus_.values.data(), n_,
+                        t.data());
+    }
+
+    [[nodiscard]] bool valid() const { return n_ > 0; }
+    [[nodiscard]] const value_type &modulus() const { return modulus_; }
+
+    template <bool a_signed, bool b_signed>
+    [[nodiscard]] value_type mulmod(const big_num<size, a_signed> &a,
+                                    const big_num<size, b_signed> &b) const {
+        value_type result;
+        if (!valid()) return result;
+        auto a_ = reduce(a);
+        auto b_ = reduce(b);
+        std::vector<uint64_t> t(scratch_size());
+        mul(result.values.data(), a_.values.data(), b_.values.data(), t.data());
+        return result;
+    }
+
+    template <bool signed_, uint64_t e_size, bool e_signed>
+    [[nodiscard]] value_type powmod(const big_num<size, signed_> &a,
+                                    const big_num<e_size, e_signed> &e) const {
+        value_type result;
+        if (!valid()) return result;
+        auto base = reduce(a);
+        // 1 mod m, which is 0 if m is 1
+        auto one = reduce(value_type(1u));
+        util::pow_window(*this, result.values.data(), base.values.data(), one.values.data(),
+                         e.values.data(), e.s);
+        return result;
+    }
+
+    // interface used by util::pow_window
+    [[nodiscard]] uint64_t n() const { return n_; }
+    [[nodiscard]] uint64_t scratch_size() const { return 8 * n_ + 8; }
+    void mul(uint64_t *r, const uint64_t *a, const uint64_t *b, uint64_t *t) const {
+        // x = a * b, which is less than m^2
+        auto *x = t;
+        util::mul_basecase(x, 2 * n_, a, n_, b, n_);
+        reduce(r, x, t + 2 * n_);
+    }
+
+private:
+    value_type modulus_;
+    std::array<uint64_t, s + 2> mu_ = {};
+    uint64_t n_ = 0;
+
+    template <bool signed_>
+    value_type reduce(const big_num<size, signed_> &a) const {
+        value_type result;
+        std::array<uint64_t, s + 1> q;
+        std::array<uint64_t, 2 * s + 1> t;
+        util::mod_n(result.values.data(), a.values.data(), s, modulus_.values.data(), n_, q.data(),
+                    t.data());
+        return result;
+    }
+
+    // r[0, n) = x[0, 2n) mod m for x < m^2. t needs 6n + 8 words
+    void reduce(uint64_t *r, const uint64_t *x, uint64_t *t) const {
+        auto const n = n_;
+        // q = floor(floor(x / B^(n - 1)) * mu / B^(n + 1)), which is at most 2 less than x / m
+        auto *q2 = t;
+        util::mul_basecase(q2, 2 * n + 3, x + n - 1, n + 1, mu_.data(), n + 2);
+        auto const *q3 = q2 + n + 1;
+        // r = x - q * m mod B^(n + 1)
+        auto *qm = t + 2 * n + 3;
+        util::mul_basecase(qm, n + 1, q3, n + 1, modulus_.values.data(), n);
+        auto *rem = qm + n + 1;
+        util::sub_n(rem, x, qm, n + 1);
+        // m with an extra zero word to line up with the remainder
+        auto *m = rem + n + 1;
+        std::copy(modulus_.values.data(), modulus_.values.data() + n, m);
+        m[n] = 0;
+        while (util::cmp_n(rem, m, n + 1) >= 0) {
+            util::sub_n(rem, rem, m, n + 1);
+        }
+        std::copy(rem, rem + n, r);
+    }
+};
+
+/*
+ * one-off modular arithmetic. notice that values are always treated as unsigned and a zero
+ * modulus produces 0, the same as division by zero
+ */
+template <uint64_t size, bool a_signed, bool b_signed, bool m_signed>
+big_num<size, false> mulmod(const big_num<size, a_signed> &a, const big_num<size, b_signed> &b,
+                            const big_num<size, m_signed> &m) {
+    big_num<size, false> result;
+    auto const nm = m.used_words();
+    if (nm == 0) return result;
+    constexpr auto s = big_num<size, false>::s;
+    // full product then reduce
+    std::array<uint64_t, 2 * s> product;
+    std::array<uint64_t, util::karatsuba_scratch_size(s)> scratch;
+    auto const na = a.used_words();
+    auto const nb = b.used_words();
+    if (util::min(na, nb) < karatsuba_threshold) {
+        util::mul_basecase(product.data(), 2 * s, a.values.data(), na, b.values.data(), nb);
+    } else {
+        util::mul_karatsuba(product.data(), a.values.data(), b.values.data(), s, scratch.data());
+    }
+    std::array<uint64_t, 2 * s + 1> q;
+    std::array<uint64_t, 3 * s + 1> t;
+    util::mod_n(result.values.data(), product.data(), 2 * s, m.values.data(), nm, q.data(),
+                t.data());
+    return result;
+}
+
+template <uint64_t size, bool a_signed, uint64_t e_size, bool e_signed, bool m_signed>
+big_num<size, false> powmod(const big_num<size, a_signed> &a, const big_num<e_size, e_signed> &e,
+                            const big_num<size, m_signed> &m) {
+    if (m.values[0] & 1) {
+        return montgomery<size>(m).powmod(a, e);
+    } else {
+        return barrett<size>(m).powmod(a, e);
+    }
+}
+
+template <int msb, int lsb, bool signed_, int op_msb, int op_lsb, bool op_signed, int m_msb,
+          int m_lsb, bool m_signed>
+requires(util::total_size(msb, lsb) == util::total_size(m_msb, m_lsb) &&
+         util::total_size(op_msb, op_lsb) ==
+             util::total_size(m_msb, m_lsb)) bit<util::total_size(msb, lsb) - 1, 0>
+    mulmod(const bit<msb, lsb, signed_> &a, const bit<op_msb, op_lsb, op_signed> &b,
+           const bit<m_msb, m_lsb, m_signed> &m) {
+    constexpr auto size = util::total_size(msb, lsb);
+    bit<size - 1, 0> result;
+    if constexpr (util::native_num(size)) {
+        auto const m_ = util::native_value(m);
+        if (m_ == 0) return result;
+        __uint128_t v = static_cast<__uint128_t>(util::native_value(a)) * util::native_value(b);
+        result.value = static_cast<typename bit<size - 1, 0>::T>(v % m_);
+    } else {
+        result.value = mulmod(a.value, b.value, m.value);
+    }
+    return result;
+}
+
+template <int msb, int lsb, bool signed_, int e_msb, int e_lsb, bool e_signed, int m_msb,
+          int m_lsb, bool m_signed>
+requires(util::total_size(msb, lsb) ==
+         util::total_size(m_msb, m_lsb)) bit<util::total_size(msb, lsb) - 1, 0>
+    powmod(const bit<msb, lsb, signed_> &a, const bit<e_msb, e_lsb, e_signed> &e,
+           const bit<m_msb, m_lsb, m_signed> &m) {
+    constexpr auto size = util::total_size(msb, lsb);
+    bit<size - 1, 0> result;
+    if constexpr (util::native_num(size)) {
+        auto const m_ = util::native_value(m);
+        if (m_ == 0) return result;
+        // square and multiply
+        __uint128_t base = util::native_value(a) % m_;
+        __uint128_t r = 1 % m_;
+        if constexpr (util::native_num(bit<e_msb, e_lsb>::size)) {
+            for (auto exp = util::native_value(e); exp; exp >>= 1) {
+                if (exp & 1) r = r * base % m_;
+                base = base * base % m_;
+            }
+        } else {
+            auto const &exp = e.value;
+            for (uint64_t i = 0; i < exp.s * 64; i++) {
+                if ((exp.values[i / 64] >> (i % 64)) & 1) r = r * base % m_;
+                base = base * base % m_;
+            }
+        }
+        result.value = static_cast<typename bit<size - 1, 0>::T>(r);
+    } else {
+        if constexpr (util::native_num(bit<e_msb, e_lsb>::size)) {
+            big_num<64, false> exp(util::native_value(e));
+            result.value = powmod(a.value, exp, m.value);
+        } else {
+            result.value = powmod(a.value, e.value, m.value);
+        }
+    }
+    return result;
+}
+
+}  // namespace logic
+
+#endif  // LOGIC_MODULAR_HH
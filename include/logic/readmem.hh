@@ -0,0 +1,105 @@
+#ifndef LOGIC_READMEM_HH
+#define LOGIC_READMEM_HH
+
+#include "array.hh"
+
+namespace logic {
+
+namespace util {
+// called for every word of a memory file with its address and digits
+using memory_visitor = void (*)(void *context, uint64_t address, std::string_view digits);
+// reads a $readmemb/$readmemh file, LRM 21.4: words separated by white space, @address
+// directives in hex and comments. addresses start at start and go up, or down if descending. the
+// file is memory mapped and large files are split into chunks that are parsed in parallel, so
+// visit is called from several threads, but never for the same address from two of them: if
+// @address directives of different chunks overlap, the chunks are read one at a time in file
+// order. threads defaults to the number of cores. returns false if the file can't be read or an
+// address is malformed
+bool read_memory(const std::string &filename, uint64_t start, memory_visitor visit, void *context,
+                 uint64_t threads = 0, bool descending = false);
+bool write_memory(const std::string &filename, std::string_view content);
+
+template <typename T>
+void parse_memory_word(T &word, std::string_view digits, char base) {
+    std::array<uint64_t, (T::size + 63) / 64> value, xz_mask;
+    parse_digits(digits, base, T::size, value.data(), xz_mask.data());
+    if constexpr (T::is_4state) {
+        set_words(word.value, value);
+        set_words(word.xz_mask, xz_mask);
+    } else {
+        // x and z read as 0 in a 2-state memory
+        for (auto i = 0u; i < value.size(); i++) value[i] &= ~xz_mask[i];
+        set_words(word, value);
+    }
+}
+
+template <char base, typename T, int msb, int lsb>
+bool readmem(const std::string &filename, unpacked_array<T, msb, lsb> &mem, int start,
+             int finish) {
+    struct context {
+        unpacked_array<T, msb, lsb> &mem;
+        uint64_t lo, hi;
+    };
+    context ctx = {mem, static_cast<uint64_t>(util::min(start, finish)),
+                   static_cast<uint64_t>(util::max(start, finish))};
+    auto visit = [](void *p, uint64_t address, std::string_view digits) {
+        auto &c = *static_cast<context *>(p);
+        // words outside of the range are ignored, as simulators do after a warning
+        if (address < c.lo || address > c.hi) return;
+        parse_memory_word(c.mem.value[address - util::min(msb, lsb)], digits, base);
+    };
+    // start > finish loads from start down to finish, LRM 21.4
+    return read_memory(filename, start, visit, &ctx, 0, start > finish);
+}
+
+template <char base, typename T, int msb, int lsb>
+bool writemem(const std::string &filename, const unpacked_array<T, msb, lsb> &mem, int start,
+              int finish) {
+    auto const spec = format_spec{base, -1};
+    auto const word_size = format_size(spec, T::size);
+    auto const lo = util::max(util::min(start, finish), util::min(msb, lsb));
+    auto const hi = util::min(util::max(start, finish), util::max(msb, lsb));
+    std::string content;
+    if (hi >= lo) content.resize((hi - lo + 1) * (word_size + 1));
+    auto *out = content.data();
+    auto *end = out + content.size();
+    for (auto i = lo; i <= hi; i++) {
+        out = mem[i].format_to(out, end, spec);
+        *out++ = '\n';
+    }
+    content.resize(out - content.data());
+    return write_memory(filename, content);
+}
+}  // namespace util
+
+// $readmemh/$readmemb into an unpacked array. start and finish are array indices and default to
+// the whole array, and start > finish loads the words in descending order. returns false if the
+// file can't be read. x and z digits are kept for logic elements and read as 0 for bit elements
+template <typename T, int msb, int lsb>
+bool readmemh(const std::string &filename, unpacked_array<T, msb, lsb> &mem,
+              int start = util::min(msb, lsb), int finish = util::max(msb, lsb)) {
+    return util::readmem<'h'>(filename, mem, start, finish);
+}
+
+template <typename T, int msb, int lsb>
+bool readmemb(const std::string &filename, unpacked_array<T, msb, lsb> &mem,
+              int start = util::min(msb, lsb), int finish = util::max(msb, lsb)) {
+    return util::readmem<'b'>(filename, mem, start, finish);
+}
+
+// $writememh/$writememb, one word per line without addresses
+template <typename T, int msb, int lsb>
+bool writememh(const std::string &filename, const unpacked_array<T, msb, lsb> &mem,
+               int start = util::min(msb, lsb), int finish = util::max(msb, lsb)) {
+    return util::writemem<'h'>(filename, mem, start, finish);
+}
+
+template <typename T, int msb, int lsb>
+bool writememb(const std::string &filename, const unpacked_array<T, msb, lsb> &mem,
+               int start = util::min(msb, lsb), int finish = util::max(msb, lsb)) {
+    return util::writemem<'b'>(filename, mem, start, finish);
+}
+
+}  // namespace logic
+
+#endif  // LOGIC_READMEM_HH
@@ -0,0 +1,331 @@
+#ifndef LOGIC_SERIALIZE_HH
+#define LOGIC_SERIALIZE_HH
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+#include "array.hh"
+#include "mapped_file.hh"
+
+namespace logic {
+
+/*
+ * binary serialization. a record is a 16 byte header followed by the raw words of every element,
+ * little-endian:
+ *     uint32_t size       bits per element
+ *     uint16_t flags      record_flags
+ *     uint16_t reserved   0
+ *     uint64_t count      elements, 1 for a single value
+ *     uint64_t words[]    per element, value words followed by xz words for 4-state values
+ * records are multiples of 8 bytes, so the words of a snapshot file stay aligned and can be read
+ * straight from a memory mapped file
+ */
+namespace util {
+enum record_flags : uint16_t { record_4state = 1, record_signed = 2 };
+
+struct record_header {
+    uint32_t size;
+    uint16_t flags;
+    uint16_t reserved;
+    uint64_t count;
+};
+static_assert(sizeof(record_header) == 16);
+
+constexpr uint64_t to_little_endian(uint64_t v) {
+    if constexpr (std::endian::native == std::endian::big) {
+        return __builtin_bswap64(v);
+    } else {
+        return v;
+    }
+}
+
+// how a single value maps to words
+template <typename T>
+struct serial_traits;
+
+template <uint64_t size_, bool signed_>
+struct serial_traits<big_num<size_, signed_>> {
+    using type = big_num<size_, signed_>;
+    static constexpr uint64_t size = size_;
+    static constexpr bool is_4state = false;
+    static constexpr bool is_signed = signed_;
+    static constexpr uint64_t words = type::s;
+
+    static void store(const type &v, uint64_t *out) { std::copy_n(v.values.data(), words, out); }
+    static void load(type &v, const uint64_t *in) { std::copy_n(in, words, v.values.data()); }
+};
+
+template <int msb, int lsb, bool signed_, bool array>
+struct serial_traits<bit<msb, lsb, signed_, array>> {
+    using type = bit<msb, lsb, signed_, array>;
+    static constexpr uint64_t size = type::size;
+    static constexpr bool is_4state = false;
+    static constexpr bool is_signed = signed_;
+    static constexpr uint64_t words = (size + 63) / 64;
+
+    static void store(const type &v, uint64_t *out) {
+        if constexpr (type::native_num) {
+            // signed holders are sign extended
+            *out = static_cast<uint64_t>(v.value) & tail_mask(size);
+        } else {
+            serial_traits<typename type::T>::store(v.value, out);
+        }
+    }
+
+    static void load(type &v, const uint64_t *in) {
+        if constexpr (type::native_num) {
+            v.value = native_value<typename type::T>(*in & tail_mask(size), size);
+        } else {
+            serial_traits<typename type::T>::load(v.value, in);
+        }
+    }
+};
+
+template <int msb, int lsb, bool signed_, bool array>
+struct serial_traits<logic<msb, lsb, signed_, array>> {
+    using type = logic<msb, lsb, signed_, array>;
+    using value_traits = serial_traits<bit<msb, lsb, signed_>>;
+    using xz_traits = serial_traits<bit<msb, lsb>>;
+    static constexpr uint64_t size = type::size;
+    static constexpr bool is_4state = true;
+    static constexpr bool is_signed = signed_;
+    static constexpr uint64_t words = value_traits::words * 2;
+
+    static void store(const type &v, uint64_t *out) {
+        value_traits::store(v.value, out);
+        xz_traits::store(v.xz_mask, out + value_traits::words);
+    }
+
+    static void load(type &v, const uint64_t *in) {
+        value_traits::load(v.value, in);
+        xz_traits::load(v.xz_mask, in + value_traits::words);
+    }
+};
+
+template <typename T, int msb, int lsb>
+struct serial_traits<packed_array<T, msb, lsb>>
+    : serial_traits<typename get_array_type<T, msb, lsb, T::is_4state>::type> {};
+
+// elements of a record, a single one for scalars
+template <typename T>
+struct serial_elements {
+    using element = T;
+    static constexpr uint64_t count = 1;
+    static const element &get(const T &v, uint64_t) { return v; }
+    static element &get(T &v, uint64_t) { return v; }
+};
+
+template <typename T, int msb, int lsb>
+struct serial_elements<unpacked_array<T, msb, lsb>> {
+    using element = T;
+    static constexpr uint64_t count = unpacked_array<T, msb, lsb>::size;
+    static const element &get(const unpacked_array<T, msb, lsb> &v, uint64_t i) {
+        return v.value[i];
+    }
+    static element &get(unpacked_array<T, msb, lsb> &v, uint64_t i) { return v.value[i]; }
+};
+
+template <typename T>
+constexpr record_header record_of() {
+    using traits = serial_traits<typename serial_elements<T>::element>;
+    return {static_cast<uint32_t>(traits::size),
+            static_cast<uint16_t>((traits::is_4state ? record_4state : 0) |
+                                  (traits::is_signed ? record_signed : 0)),
+            0, serial_elements<T>::count};
+}
+
+// a record only loads into a type of the same width and state. signedness is only informative
+constexpr bool record_matches(const record_header &a, const record_header &b) {
+    return a.size == b.size && (a.flags & record_4state) == (b.flags & record_4state) &&
+           a.count == b.count;
+}
+
+inline void write_record_header(const record_header &header, char *out) {
+    auto const words = std::array<uint64_t, 2>{
+        to_little_endian(header.size | (static_cast<uint64_t>(header.flags) << 32)),
+        to_little_endian(header.count)};
+    std::memcpy(out, words.data(), sizeof(words));
+}
+
+inline record_header read_record_header(const char *in) {
+    std::array<uint64_t, 2> words;
+    std::memcpy(words.data(), in, sizeof(words));
+    auto const tag = to_little_endian(words[0]);
+    return {static_cast<uint32_t>(tag), static_cast<uint16_t>(tag >> 32), 0,
+            to_little_endian(words[1])};
+}
+
+// a single element from its little-endian words, which need not be aligned
+template <typename T>
+void load_element(T &v, const char *in) {
+    using traits = serial_traits<T>;
+    std::array<uint64_t, traits::words> words;
+    std::memcpy(words.data(), in, sizeof(words));
+    for (auto &w : words) w = to_little_endian(w);
+    traits::load(v, words.data());
+}
+
+template <typename T>
+void store_element(const T &v, char *out) {
+    using traits = serial_traits<T>;
+    std::array<uint64_t, traits::words> words;
+    traits::store(v, words.data());
+    for (auto &w : words) w = to_little_endian(w);
+    std::memcpy(out, words.data(), sizeof(words));
+}
+}  // namespace util
+
+// bytes serialize() writes for v
+template <typename T>
+constexpr uint64_t serialized_size() {
+    using elements = util::serial_elements<T>;
+    return sizeof(util::record_header) +
+           elements::count * util::serial_traits<typename elements::element>::words * 8;
+}
+
+// writes v into out, which has room for serialized_size<T>() bytes. returns the end
+template <typename T>
+char *serialize(const T &v, char *out) {
+    using elements = util::serial_elements<T>;
+    using traits = util::serial_traits<typename elements::element>;
+    util::write_record_header(util::record_of<T>(), out);
+    out += sizeof(util::record_header);
+    for (uint64_t i = 0; i < elements::count; i++) {
+        util::store_element(elements::get(v, i), out);
+        out += traits::words * 8;
+    }
+    return out;
+}
+
+// reads v from [first, last). returns the end of the record, or nullptr if the record is
+// truncated or doesn't match the width and state of T, in which case v is left untouched
+template <typename T>
+const char *deserialize(T &v, const char *first, const char *last) {
+    using elements = util::serial_elements<T>;
+    using traits = util::serial_traits<typename elements::element>;
+    if (static_cast<uint64_t>(last - first) < serialized_size<T>()) return nullptr;
+    if (!util::record_matches(util::read_record_header(first), util::record_of<T>())) {
+        return nullptr;
+    }
+    first += sizeof(util::record_header);
+    for (uint64_t i = 0; i < elements::count; i++) {
+        util::load_element(elements::get(v, i), first);
+        first += traits::words * 8;
+    }
+    return first;
+}
+
+/*
+ * snapshot files: a 16 byte file header, the magic "LOGICSNP" then the uint32_t version and 4
+ * reserved bytes, followed by records
+ */
+constexpr uint32_t snapshot_version = 1;
+
+class snapshot_writer {
+public:
+    explicit snapshot_writer(const std::string &filename);
+
+    [[nodiscard]] bool ok() const { return static_cast<bool>(stream_); }
+
+    template <typename T>
+    bool write(const T &v) {
+        using elements = util::serial_elements<T>;
+        using traits = util::serial_traits<typename elements::element>;
+        std::array<char, sizeof(util::record_header)> header;
+        util::write_record_header(util::record_of<T>(), header.data());
+        stream_.write(header.data(), header.size());
+        // one element at a time, so that large arrays don't need a second copy in memory
+        std::array<char, traits::words * 8> words;
+        for (uint64_t i = 0; i < elements::count; i++) {
+            util::store_element(elements::get(v, i), words.data());
+            stream_.write(words.data(), words.size());
+        }
+        return ok();
+    }
+
+    bool close();
+
+private:
+    std::ofstream stream_;
+};
+
+// a record in a mapped snapshot. elements are only read, and their pages only loaded, when
+// they are accessed
+template <typename T>
+class mapped_record {
+public:
+    using traits = util::serial_traits<T>;
+
+    mapped_record() = default;
+    mapped_record(const char *data, uint64_t count) : data_(data), count_(count) {}
+
+    explicit operator bool() const { return data_ != nullptr; }
+    [[nodiscard]] uint64_t size() const { return count_; }
+
+    T operator[](uint64_t i) const {
+        T result;
+        util::load_element(result, element(i));
+        return result;
+    }
+
+    // restores elements [first, first + count) into out
+    template <typename It>
+    void read(uint64_t first, uint64_t count, It out) const {
+        for (auto i = first; i < first + count; i++) util::load_element(*out++, element(i));
+    }
+
+private:
+    [[nodiscard]] const char *element(uint64_t i) const { return data_ + i * traits::words * 8; }
+
+    const char *data_ = nullptr;
+    uint64_t count_ = 0;
+};
+
+// reads the records of a snapshot file in order, from a memory mapping of the file
+class snapshot_reader {
+public:
+    explicit snapshot_reader(const std::string &filename);
+
+    // the file exists and has a snapshot header of a supported version
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] uint32_t version() const { return version_; }
+    [[nodiscard]] bool done() const { return pos_ >= file_.data().size(); }
+
+    // the header of the next record, if there is one
+    [[nodiscard]] const char *peek(util::record_header &header) const;
+    bool skip();
+
+    // copies the next record into v. returns false if it doesn't match T, without moving on
+    template <typename T>
+    bool read(T &v) {
+        auto const data = file_.data();
+        auto const *end = deserialize(v, data.data() + pos_, data.data() + data.size());
+        if (!end) return false;
+        pos_ = end - data.data();
+        return true;
+    }
+
+    // maps the next record, of any number of T elements. the result is empty if it doesn't match
+    template <typename T>
+    mapped_record<T> map() {
+        util::record_header header;
+        auto const *data = peek(header);
+        if (!data) return {};
+        auto expected = util::record_of<T>();
+        expected.count = header.count;
+        if (!util::record_matches(header, expected)) return {};
+        skip();
+        return {data + sizeof(util::record_header), header.count};
+    }
+
+private:
+    util::mapped_file file_;
+    bool ok_ = false;
+    uint32_t version_ = 0;
+    uint64_t pos_ = 0;
+};
+
+}  // namespace logic
+
+#endif  // LOGIC_SERIALIZE_HH
@@ -0,0 +1,347 @@
+#ifndef LOGIC_SOA_HH
+#define LOGIC_SOA_HH
+
+#include <bit>
+#include <vector>
+
+#include "array.hh"
+
+namespace logic {
+
+/*
+ * a large unpacked array in structure-of-arrays layout: the value bits of every element are
+ * packed into one contiguous block of words and the xz bits into another. unpacked_array stores
+ * whole logic objects, each padded to its native holder, with its value and xz mask side by side.
+ * for register files and memories of 100K entries that wastes most of the bandwidth of a bulk
+ * operation. here a bulk operation is one pass over the words, which the compiler vectorizes.
+ *
+ * elements up to 64 bits take the next power of two bits, so they never straddle a word and 8
+ * 3-bit elements fit in 4 bytes. wider elements start on a word boundary. padding bits are 0 in
+ * both blocks. 2-state (bit) elements have no xz block
+ */
+template <typename T, int msb, int lsb>
+struct soa_array {
+public:
+    static constexpr auto size = util::total_size(msb, lsb);
+    static constexpr auto element_size = T::size;
+    static constexpr bool is_4state = T::is_4state;
+    // bits per element, including padding
+    static constexpr uint64_t stride = element_size <= 64
+                                           ? std::bit_ceil(static_cast<uint64_t>(element_size))
+                                           : (element_size + 63) / 64 * 64;
+    static constexpr uint64_t words = (size * stride + 63) / 64;
+
+    std::vector<uint64_t> value;
+    std::vector<uint64_t> xz_mask;
+
+    // everything is x, or 0 for 2-state elements, the same as unpacked_array
+    soa_array() : value(words), xz_mask(is_4state ? words : 0) {
+        if constexpr (is_4state) fill_x();
+    }
+
+    explicit soa_array(const unpacked_array<T, msb, lsb> &array) : soa_array() {
+        for (uint64_t i = 0; i < size; i++) set(i, array.value[i]);
+    }
+
+    /*
+     * elements, by offset from the lowest index
+     */
+    [[nodiscard]] T get(uint64_t i) const {
+        T result;
+        util::set_words(value_of(result), read(value, i));
+        if constexpr (is_4state) util::set_words(result.xz_mask, read(xz_mask, i));
+        return result;
+    }
+
+    void set(uint64_t i, const T &v) {
+        write(value, i, util::get_words(value_of(v)));
+        if constexpr (is_4state) write(xz_mask, i, util::get_words(v.xz_mask));
+    }
+
+    // reads and writes of one element that convert to and from T
+    struct reference {
+    public:
+        // out of range reads are x and writes are dropped, the same as unpacked_array
+        [[nodiscard]] T get() const { return i_ < size ? array_->get(i_) : T{}; }
+        operator T() const { return get(); }  // NOLINT
+
+        reference &operator=(const T &v) {
+            if (i_ < size) array_->set(i_, v);
+            return *this;
+        }
+        reference &operator=(const reference &r) { return *this = r.get(); }
+        template <typename V>
+        requires(std::is_arithmetic_v<V>) reference &operator=(V v) {
+            return *this = T(v);
+        }
+
+        [[nodiscard]] std::string str(std::string_view fmt = "b") const { return get().str(fmt); }
+
+        template <typename V>
+        reference &operator&=(const V &v) {
+            return *this = T(get() & v);
+        }
+        template <typename V>
+        reference &operator|=(const V &v) {
+            return *this = T(get() | v);
+        }
+        template <typename V>
+        reference &operator^=(const V &v) {
+            return *this = T(get() ^ v);
+        }
+        template <typename V>
+        reference &operator+=(const V &v) {
+            return *this = T(get() + v);
+        }
+        template <typename V>
+        reference &operator-=(const V &v) {
+            return *this = T(get() - v);
+        }
+
+        // the other operators compute on the element, with the same result types as T
+#define LOGIC_SOA_OP(op)                                                                  \
+    template <typename V>                                                                 \
+    friend auto operator op(const reference &l, const V &r) {                             \
+        return l.get() op r;                                                              \
+    }                                                                                     \
+    template <typename V>                                                                 \
+    requires(!std::is_same_v<V, reference>) friend auto operator op(const V &l,           \
+                                                                    const reference &r) { \
+        return l op r.get();                                                              \
+    }
+        LOGIC_SOA_OP(&)
+        LOGIC_SOA_OP(|)
+        LOGIC_SOA_OP(^)
+        LOGIC_SOA_OP(+)
+        LOGIC_SOA_OP(-)
+        LOGIC_SOA_OP(*)
+        LOGIC_SOA_OP(/)
+        LOGIC_SOA_OP(%)
+        LOGIC_SOA_OP(<<)
+        LOGIC_SOA_OP(>>)
+        LOGIC_SOA_OP(==)
+        LOGIC_SOA_OP(!=)
+        LOGIC_SOA_OP(<)
+        LOGIC_SOA_OP(>)
+        LOGIC_SOA_OP(<=)
+        LOGIC_SOA_OP(>=)
+#undef LOGIC_SOA_OP
+
+        auto operator~() const { return ~get(); }
+        auto operator!() const { return !get(); }
+        auto operator-() const { return -get(); }
+
+    private:
+        reference(soa_array *array, uint64_t i) : array_(array), i_(i) {}
+        soa_array *array_;
+        uint64_t i_;
+
+        friend soa_array;
+    };
+
+    reference operator[](int idx) { return reference(this, offset(idx)); }
+    T operator[](int idx) const {
+        auto const i = offset(idx);
+        return i < size ? get(i) : T{};
+    }
+
+    /*
+     * bulk operations, one pass over the words
+     */
+    soa_array &operator&=(const soa_array &op) {
+        if constexpr (is_4state) {
+            for (uint64_t i = 0; i < words; i++) {
+                auto const lv = value[i], lxz = xz_mask[i], rv = op.value[i], rxz = op.xz_mask[i];
+                // a known 0 on either side is 0, the rest of the x and z bits are x
+                auto const zero = ~(lv | lxz) | ~(rv | rxz);
+                auto const xz = (lxz | rxz) & ~zero;
+                xz_mask[i] = xz;
+                value[i] = lv & rv & ~xz;
+            }
+        } else {
+            for (uint64_t i = 0; i < words; i++) value[i] &= op.value[i];
+        }
+        return *this;
+    }
+
+    soa_array &operator|=(const soa_array &op) {
+        if constexpr (is_4state) {
+            for (uint64_t i = 0; i < words; i++) {
+                auto const lv = value[i], lxz = xz_mask[i], rv = op.value[i], rxz = op.xz_mask[i];
+                // a known 1 on either side is 1
+                auto const one = (lv & ~lxz) | (rv & ~rxz);
+                xz_mask[i] = (lxz | rxz) & ~one;
+                value[i] = one;
+            }
+        } else {
+            for (uint64_t i = 0; i < words; i++) value[i] |= op.value[i];
+        }
+        return *this;
+    }
+
+    soa_array &operator^=(const soa_array &op) {
+        if constexpr (is_4state) {
+            for (uint64_t i = 0; i < words; i++) {
+                auto const xz = xz_mask[i] | op.xz_mask[i];
+                xz_mask[i] = xz;
+                value[i] = (value[i] ^ op.value[i]) & ~xz;
+            }
+        } else {
+            for (uint64_t i = 0; i < words; i++) value[i] ^= op.value[i];
+        }
+        return *this;
+    }
+
+    soa_array operator&(const soa_array &op) const {
+        auto result = *this;
+        result &= op;
+        return result;
+    }
+
+    soa_array operator|(const soa_array &op) const {
+        auto result = *this;
+        result |= op;
+        return result;
+    }
+
+    soa_array operator^(const soa_array &op) const {
+        auto result = *this;
+        result ^= op;
+        return result;
+    }
+
+    soa_array operator~() const {
+        soa_array result = *this;
+        for (uint64_t i = 0; i < words; i++) {
+            auto v = value[i];
+            if constexpr (is_4state) v |= xz_mask[i];
+            result.value[i] = ~v & padding_mask(i);
+        }
+        return result;
+    }
+
+    // every element becomes v
+    void fill(const T &v) { fill(v, ~bit<element_size - 1, 0>(0)); }
+
+    // the bits of every element that are set in mask become the bits of v, e.g. a write enable
+    // over the whole memory. the rest keep their value
+    void fill(const T &v, const bit<element_size - 1, 0> &mask) {
+        auto const m = broadcast(util::get_words(mask));
+        auto const vv = broadcast(util::get_words(value_of(v)));
+        // the slots past the end of the last word stay 0
+        for (uint64_t i = 0; i < words; i++) {
+            auto const k = m[i % m.size()] & padding_mask(i);
+            value[i] = (value[i] & ~k) | (vv[i % vv.size()] & k);
+        }
+        if constexpr (is_4state) {
+            auto const xz = broadcast(util::get_words(v.xz_mask));
+            for (uint64_t i = 0; i < words; i++) {
+                auto const k = m[i % m.size()] & padding_mask(i);
+                xz_mask[i] = (xz_mask[i] & ~k) | (xz[i % xz.size()] & k);
+            }
+        }
+    }
+
+    void fill_x() requires(is_4state) {
+        for (uint64_t i = 0; i < words; i++) {
+            value[i] = 0;
+            xz_mask[i] = padding_mask(i);
+        }
+    }
+
+    // any x or z bit in any element
+    [[nodiscard]] bool any_x() const {
+        if constexpr (is_4state) {
+            uint64_t r = 0;
+            for (auto w : xz_mask) r |= w;
+            return r != 0;
+        } else {
+            return false;
+        }
+    }
+
+    [[nodiscard]] unpacked_array<T, msb, lsb> to_unpacked() const {
+        unpacked_array<T, msb, lsb> result;
+        for (uint64_t i = 0; i < size; i++) result.value[i] = get(i);
+        return result;
+    }
+
+private:
+    static constexpr uint64_t element_words = (element_size + 63) / 64;
+    // elements per word for the narrow layout
+    static constexpr uint64_t per_word = stride <= 64 ? 64 / stride : 1;
+    // word period of a pattern repeated in every element
+    static constexpr uint64_t period = stride <= 64 ? 1 : stride / 64;
+
+    static constexpr uint64_t offset(int idx) {
+        return static_cast<uint32_t>(idx - util::min(msb, lsb));
+    }
+
+    template <typename U>
+    static auto &value_of(U &v) {
+        if constexpr (is_4state) {
+            return v.value;
+        } else {
+            return v;
+        }
+    }
+
+    static std::array<uint64_t, element_words> read(const std::vector<uint64_t> &block,
+                                                    uint64_t i) {
+        std::array<uint64_t, element_words> result;
+        if constexpr (stride <= 64) {
+            auto const shift = (i % per_word) * stride;
+            result[0] = (block[i / per_word] >> shift) & util::tail_mask(element_size);
+        } else {
+            std::copy_n(block.begin() + i * period, element_words, result.begin());
+        }
+        return result;
+    }
+
+    static void write(std::vector<uint64_t> &block, uint64_t i,
+                      const std::array<uint64_t, element_words> &v) {
+        if constexpr (stride <= 64) {
+            auto const shift = (i % per_word) * stride;
+            auto const mask = util::tail_mask(element_size) << shift;
+            auto &w = block[i / per_word];
+            w = (w & ~mask) | ((v[0] << shift) & mask);
+        } else {
+            std::copy_n(v.begin(), element_words, block.begin() + i * period);
+        }
+    }
+
+    // an element pattern repeated over the words it occupies
+    static std::array<uint64_t, period> broadcast(const std::array<uint64_t, element_words> &v) {
+        std::array<uint64_t, period> result = {};
+        if constexpr (stride <= 64) {
+            for (uint64_t i = 0; i < per_word; i++) result[0] |= v[0] << (i * stride);
+        } else {
+            std::copy_n(v.begin(), element_words, result.begin());
+        }
+        return result;
+    }
+
+    // the bits of word i that belong to an element
+    static constexpr uint64_t padding_mask(uint64_t i) {
+        constexpr auto pattern = [] {
+            std::array<uint64_t, period> result = {};
+            std::array<uint64_t, element_words> ones;
+            ones.fill(~0ull);
+            ones[element_words - 1] = util::tail_mask(element_size);
+            if constexpr (stride <= 64) {
+                for (uint64_t j = 0; j < per_word; j++) result[0] |= ones[0] << (j * stride);
+            } else {
+                std::copy_n(ones.begin(), element_words, result.begin());
+            }
+            return result;
+        }();
+        // the last word may be partly past the end of the array
+        auto const last = (size * stride) % 64;
+        auto const tail = i == words - 1 && last ? util::tail_mask(last) : ~0ull;
+        return pattern[i % period] & tail;
+    }
+};
+
+}  // namespace logic
+
+#endif  // LOGIC_SOA_HH
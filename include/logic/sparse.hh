@@ -0,0 +1,139 @@
+#ifndef LOGIC_SPARSE_HH
+#define LOGIC_SPARSE_HH
+
+#include <memory>
+#include <vector>
+
+#include "array.hh"
+
+namespace logic {
+
+/*
+ * a memory of 2^addr_bits elements that only allocates what is written. unpacked_array holds every
+ * element inline, so a 32-bit addressed memory can't exist and a 2^24 entry one overflows the
+ * stack. here the address space is split into pages of 2^page_bits elements, allocated on the
+ * first write to the page, and a two level page table. a lookup is two indexed loads and never
+ * allocates. untouched addresses read as x, or 0 for 2-state elements, the same as a new
+ * unpacked_array. move only, since a copy could be gigabytes
+ */
+template <typename T, int addr_bits, int page_bits = util::min(addr_bits, 10)>
+struct sparse_memory {
+    static_assert(addr_bits > 0 && addr_bits <= 48, "address space too large for the page table");
+    static_assert(page_bits > 0 && page_bits <= addr_bits);
+
+public:
+    static constexpr uint64_t size = 1ull << addr_bits;
+    static constexpr uint64_t page_size = 1ull << page_bits;
+    using page = std::array<T, page_size>;
+
+    sparse_memory() : tables_(table_count) {}
+    sparse_memory(sparse_memory &&) noexcept = default;
+    sparse_memory &operator=(sparse_memory &&) noexcept = default;
+
+    const T &operator[](uint64_t addr) const {
+        const static T x_ = T{};
+        auto const *p = find(addr);
+        return p ? (*p)[addr % page_size] : x_;
+    }
+
+    // an x or z address reads x, LRM 7.4.6
+    template <int msb, int lsb, bool signed_, bool array>
+    const T &operator[](const logic<msb, lsb, signed_, array> &addr) const {
+        const static T x_ = T{};
+        return addr.xz_mask.any_set() ? x_ : (*this)[addr.value];
+    }
+
+    template <int msb, int lsb, bool signed_, bool array>
+    const T &operator[](const bit<msb, lsb, signed_, array> &addr) const {
+        return (*this)[addr_of(addr)];
+    }
+
+    // writes past the end are dropped
+    template <typename V>
+    void update(uint64_t addr, const V &v) {
+        if (addr >= size) return;
+        auto &t = tables_[addr >> table_shift];
+        if (!t) t = std::make_unique<table>();
+        auto &p = t->pages[(addr >> page_bits) % table_size];
+        if (!p) {
+            p = std::make_unique<page>();
+            pages_++;
+        }
+        (*p)[addr % page_size] = v;
+    }
+
+    // writes to an x or z address are dropped
+    template <int msb, int lsb, bool signed_, bool array, typename V>
+    void update(const logic<msb, lsb, signed_, array> &addr, const V &v) {
+        if (!addr.xz_mask.any_set()) update(addr.value, v);
+    }
+
+    template <int msb, int lsb, bool signed_, bool array, typename V>
+    void update(const bit<msb, lsb, signed_, array> &addr, const V &v) {
+        update(addr_of(addr), v);
+    }
+
+    // the same as unpacked_array
+    template <uint64_t addr, typename V>
+    void update(const V &v) {
+        update(addr, v);
+    }
+
+    // number of allocated pages
+    [[nodiscard]] uint64_t pages() const { return pages_; }
+
+    // calls visit(base, page) for every allocated page in address order, where base is the
+    // address of page[0], e.g. to dump the written parts of the memory
+    template <typename F>
+    void for_each_page(F &&visit) const {
+        for (uint64_t t = 0; t < table_count; t++) {
+            if (!tables_[t]) continue;
+            for (uint64_t p = 0; p < table_size; p++) {
+                auto const &pg = tables_[t]->pages[p];
+                if (pg) visit(((t * table_size) + p) * page_size, static_cast<const page &>(*pg));
+            }
+        }
+    }
+
+    // every address reads x again
+    void clear() {
+        for (auto &t : tables_) t.reset();
+        pages_ = 0;
+    }
+
+private:
+    // the page number is split between the two levels, each about the square root of the page
+    // count, so neither table is large for a 48-bit address
+    static constexpr auto page_number_bits = addr_bits - page_bits;
+    static constexpr auto table_bits = page_number_bits / 2;
+    static constexpr uint64_t table_size = 1ull << table_bits;
+    static constexpr uint64_t table_count = 1ull << (page_number_bits - table_bits);
+    static constexpr auto table_shift = page_bits + table_bits;
+
+    struct table {
+        std::array<std::unique_ptr<page>, table_size> pages;
+    };
+
+    std::vector<std::unique_ptr<table>> tables_;
+    uint64_t pages_ = 0;
+
+    const page *find(uint64_t addr) const {
+        if (addr >= size) return nullptr;
+        auto const &t = tables_[addr >> table_shift];
+        return t ? t->pages[(addr >> page_bits) % table_size].get() : nullptr;
+    }
+
+    // addresses wider than the memory are out of range rather than truncated
+    template <int msb, int lsb, bool signed_, bool array>
+    static uint64_t addr_of(const bit<msb, lsb, signed_, array> &addr) {
+        auto const words = util::get_words(addr);
+        for (auto i = 1u; i < words.size(); i++) {
+            if (words[i]) return size;
+        }
+        return words[0];
+    }
+};
+
+}  // namespace logic
+
+#endif  // LOGIC_SPARSE_HH
@@ -7,10 +7,18 @@
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <vector>
 
+// keeps the stack frame of a cold path out of its caller
+#if defined(_MSC_VER)
+#define LOGIC_NOINLINE __declspec(noinline)
+#else
+#define LOGIC_NOINLINE __attribute__((noinline))
+#endif
+
 namespace logic {
 template <uint64_t size, bool signed_ = false>
 struct big_num;
@@ -48,6 +56,12 @@ constexpr T abs_diff(T a, T b) {
 
 constexpr bool native_num(uint64_t size) { return size <= big_num_threshold; }
 
+// bits in use of the most significant word
+constexpr uint64_t tail_mask(uint64_t size) {
+    return std::numeric_limits<uint64_t>::max() >>
+           ((big_num_threshold - size % big_num_threshold) % big_num_threshold);
+}
+
 inline uint64_t str_len(uint64_t size, std::string_view fmt) {
     auto pos = fmt.find_first_not_of("0123456789");
     if (pos == 0) {
@@ -137,6 +151,153 @@ struct get_holder_type<s, signed_, typename std::enable_if<gte(s, 65)>::type> {
     using type = big_num<s, signed_>;
 };
 
+/*
+ * compile time parsing of SystemVerilog literals, e.g. 8'shF0 or 4'b10xz, for the literal
+ * operator templates. the runtime constructors use parse_raw_str instead
+ */
+// a string literal as a template parameter
+template <std::size_t n>
+struct fixed_string {
+    char data[n] = {};
+    constexpr fixed_string(const char (&str)[n]) { std::copy_n(str, n, data); }  // NOLINT
+    [[nodiscard]] constexpr std::string_view view() const { return {data, n - 1}; }
+};
+
+constexpr bool literal_base(char c) {
+    auto const l = c | 0x20;
+    return l == 'b' || l == 'o' || l == 'd' || l == 'h';
+}
+
+struct literal_format {
+    uint64_t size;
+    bool signed_;
+    char base;
+    // where the digits start
+    uint64_t pos;
+    // false when the size is left out
+    bool sized;
+};
+
+// per LRM 5.7.1, unsized based literals are 32 bits. without a base the literal is a string,
+// 8 bits per character. s is the signed marker when a base follows it
+constexpr literal_format parse_literal_format(std::string_view str) {
+    // an index scan instead of find(), which gcc 12 can't constant evaluate under
+    // -fsanitize=undefined
+    uint64_t quote = 0;
+    while (quote < str.size() && str[quote] != '\'') quote++;
+    if (quote == str.size()) {
+        return {max<uint64_t>(str.size(), 1) * 8, false, 's', 0, true};
+    }
+    literal_format result = {0, false, 'b', quote + 1, false};
+    for (auto i = 0u; i < quote; i++) {
+        if (str[i] >= '0' && str[i] <= '9') result.size = result.size * 10 + (str[i] - '0');
+    }
+    result.sized = result.size != 0;
+    if (!result.sized) result.size = 32;
+    auto &pos = result.pos;
+    if (pos + 1 < str.size() && (str[pos] | 0x20) == 's' && literal_base(str[pos + 1])) {
+        result.signed_ = true;
+        pos++;
+    }
+    if (pos < str.size()) result.base = str[pos++];
+    return result;
+}
+
+// value and xz bits of a single digit in any base
+constexpr void parse_literal_digit(char c, uint64_t &value, uint64_t &xz_mask) {
+    auto const l = c | 0x20;
+    xz_mask = 0;
+    value = 0;
+    if (c >= '0' && c <= '9') {
+        value = c - '0';
+    } else if (l >= 'a' && l <= 'f') {
+        value = l - 'a' + 10;
+    } else if (l == 'x') {
+        xz_mask = 0xF;
+    } else if (l == 'z' || c == '?') {
+        value = 0xF;
+        xz_mask = 0xF;
+    }
+}
+
+template <uint64_t size>
+struct literal_words {
+    std::array<uint64_t, (size + 63) / 64> value{};
+    std::array<uint64_t, (size + 63) / 64> xz_mask{};
+
+    [[nodiscard]] constexpr bool xz() const {
+        return std::any_of(xz_mask.begin(), xz_mask.end(), [](auto w) { return w != 0; });
+    }
+};
+
+// the digits after the base, with the same results as parse_raw_str: digits past size are
+// dropped and missing ones are 0, or x or z when the leftmost digit starts with x or z
+template <uint64_t size>
+constexpr literal_words<size> parse_literal(std::string_view digits, char base) {
+    literal_words<size> result;
+    auto set = [&result](uint64_t i, uint64_t v, uint64_t xz) {
+        if (i >= size) return;
+        result.value[i / 64] |= (v & 1) << (i % 64);
+        result.xz_mask[i / 64] |= (xz & 1) << (i % 64);
+    };
+    uint64_t pos = 0;
+    switch (base | 0x20) {
+        case 'b':
+        case 'o':
+        case 'h': {
+            auto const stride = (base | 0x20) == 'b' ? 1 : (base | 0x20) == 'o' ? 3 : 4;
+            uint64_t v = 0, xz = 0;
+            for (auto i = digits.size(); i > 0; i--) {
+                if (digits[i - 1] == '_') continue;
+                parse_literal_digit(digits[i - 1], v, xz);
+                for (auto j = 0; j < stride; j++) set(pos + j, v >> j, xz >> j);
+                pos += stride;
+            }
+            // the last digit parsed is the leftmost one, LRM 5.7.1
+            if ((xz >> (stride - 1)) & 1) {
+                while (pos < size) set(pos++, v >> (stride - 1), 1);
+            }
+            break;
+        }
+        case 'd': {
+            for (auto c : digits) {
+                uint64_t v, xz;
+                parse_literal_digit(c, v, xz);
+                if (xz) {
+                    // 'dx and 'dz are the only legal four state decimals
+                    while (pos < size) set(pos++, v, xz);
+                    break;
+                }
+                if (c < '0' || c > '9') continue;
+                // value = value * 10 + digit
+                for (auto &w : result.value) {
+                    auto const t = static_cast<__uint128_t>(w) * 10 + v;
+                    w = static_cast<uint64_t>(t);
+                    v = static_cast<uint64_t>(t >> 64);
+                }
+            }
+            result.value.back() &= tail_mask(size);
+            break;
+        }
+        default: {
+            for (auto i = digits.size(); i > 0; i--, pos += 8) {
+                auto const c = static_cast<uint8_t>(digits[i - 1]);
+                for (auto j = 0; j < 8; j++) set(pos + j, c >> j, 0);
+            }
+        }
+    }
+    return result;
+}
+
+// raw bits into a native holder, sign extended for signed holders
+template <typename T>
+constexpr T native_value(uint64_t bits, uint64_t size) {
+    if constexpr (std::is_signed_v<T>) {
+        if (size < 64 && ((bits >> (size - 1)) & 1)) bits |= ~tail_mask(size);
+    }
+    return static_cast<T>(bits);
+}
+
 // string related stuff
 // for parsing native numbers
 // if four state detected, will set the value flag properly
@@ -144,6 +305,12 @@ uint64_t parse_raw_str(std::string_view value);
 uint64_t parse_xz_raw_str(std::string_view value);
 void parse_raw_str(std::string_view value, uint64_t size, uint64_t *ptr);
 void parse_xz_raw_str(std::string_view value, uint64_t size, uint64_t *ptr);
+// value and xz mask in a single pass. either of them can be null
+void parse_raw_str(std::string_view value, uint64_t size, uint64_t *ptr, uint64_t *xz_ptr);
+// only the digits of a literal, i.e. without the size and the base. an x or z in the leftmost
+// bit is extended up to pad_size bits instead of 0, LRM 5.7.1
+void parse_digits(std::string_view digits, char base, uint64_t size, uint64_t *value,
+                  uint64_t *xz_mask, uint64_t pad_size = std::numeric_limits<uint64_t>::max());
 
 std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, bool is_negative);
 std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, uint64_t xz_mask,
@@ -153,6 +320,64 @@ std::string to_string(std::string_view fmt, uint64_t size, const uint64_t *value
                       const uint64_t *xz_mask, bool is_negative);
 bool decimal_fmt(std::string_view fmt);
 
+// binary and hex digits are converted a word at a time with SIMD kernels when the cpu supports
+// them. the level can be lowered, e.g. to compare against the scalar code, but never raised past
+// what the cpu supports. returns the level in effect
+enum class simd_level { scalar, sse42, avx2 };
+simd_level simd_support();
+simd_level set_simd_level(simd_level level);
+
+// a format spec such as "0h" or "8d", parsed once so that it can be reused. width is the
+// requested field width, or -1 if there is none. a width of 0 turns the padding off, LRM 21.2.1.3
+struct format_spec {
+    char base = 's';
+    int64_t width = -1;
+};
+
+constexpr format_spec parse_format_spec(std::string_view fmt) {
+    format_spec result;
+    auto const pos = fmt.find_first_not_of("0123456789");
+    if (pos != std::string_view::npos) result.base = fmt[pos];
+    if (pos != 0) {
+        result.width = 0;
+        for (auto i = 0u; i < std::min(pos, fmt.size()); i++) {
+            result.width = result.width * 10 + (fmt[i] - '0');
+        }
+    }
+    return result;
+}
+
+constexpr bool decimal_fmt(format_spec spec) { return spec.base == 'd' || spec.base == 'D'; }
+
+// upper bound of the decimal digits of a size bit number, 30103 / 10^5 >= log10(2)
+constexpr uint64_t decimal_digits(uint64_t size) { return size * 30103 / 100000 + 1; }
+
+// words of scratch space the formatting of a size bit number needs. decimal digits of numbers
+// wider than a word are computed on a copy of the value, divided in place, and written to the
+// scratch before they are moved into the output. the other bases and single words need none
+constexpr uint64_t format_scratch_words(uint64_t size) {
+    auto const n = (size + 63) / 64;
+    return n <= 1 ? 1 : n + (3 * n + 64) + (decimal_digits(size) + 7) / 8;
+}
+
+// allocation free formatting into [first, last), using the same format spec as to_string. returns
+// the end of the output, or nullptr if it doesn't fit. format_size() characters always fit.
+// scratch holds format_scratch_words(size) words, and can be null unless the base is decimal
+uint64_t format_size(std::string_view fmt, uint64_t size);
+uint64_t format_size(format_spec spec, uint64_t size);
+char *format_to(char *first, char *last, std::string_view fmt, uint64_t size, uint64_t value,
+                bool is_negative);
+char *format_to(char *first, char *last, std::string_view fmt, uint64_t size, uint64_t value,
+                uint64_t xz_mask, bool is_negative);
+char *format_to(char *first, char *last, std::string_view fmt, uint64_t size,
+                const uint64_t *value, bool is_negative, uint64_t *scratch);
+char *format_to(char *first, char *last, std::string_view fmt, uint64_t size,
+                const uint64_t *value, const uint64_t *xz_mask, bool is_negative,
+                uint64_t *scratch);
+// xz_mask can be null for 2-state values
+char *format_to(char *first, char *last, format_spec spec, uint64_t size, const uint64_t *value,
+                const uint64_t *xz_mask, bool is_negative, uint64_t *scratch);
+
 }  // namespace util
 }  // namespace logic
 
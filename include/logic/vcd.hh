@@ -0,0 +1,76 @@
+#ifndef LOGIC_VCD_HH
+#define LOGIC_VCD_HH
+
+#include <memory>
+
+#include "logic.hh"
+
+namespace logic {
+
+/*
+ * value change dump writer, IEEE 1364 18. signals are registered by reference and sampled on
+ * every dump(), which compares their raw value and xz words against a shadow copy and queues
+ * only the ones that changed. a background thread turns the queued words into VCD text and
+ * writes it out, so the simulation thread never formats anything
+ */
+class vcd_writer {
+public:
+    // gzip writes a gzip compressed VCD instead, when the library is built with zlib
+    explicit vcd_writer(const std::string &filename, std::string_view timescale = "1ns",
+                        bool gzip = false);
+    ~vcd_writer();
+
+    vcd_writer(const vcd_writer &) = delete;
+    vcd_writer &operator=(const vcd_writer &) = delete;
+
+    [[nodiscard]] bool ok() const;
+    static bool gzip_supported();
+
+    // signals have to outlive the writer and be added before the first dump. scope is the dot
+    // separated hierarchy the signal is declared in, e.g. "top.cpu"
+    template <int msb, int lsb, bool signed_, bool array>
+    void add(const bit<msb, lsb, signed_, array> &signal, std::string_view name,
+             std::string_view scope = "top") {
+        add_signal(signal_of(signal), nullptr, msb, lsb, name, scope);
+    }
+
+    template <int msb, int lsb, bool signed_, bool array>
+    void add(const logic<msb, lsb, signed_, array> &signal, std::string_view name,
+             std::string_view scope = "top") {
+        add_signal(signal_of(signal.value), signal_of(signal.xz_mask).data, msb, lsb, name,
+                   scope);
+    }
+
+    // records the signals that changed since the last dump at time. the first dump records all
+    void dump(uint64_t time);
+    // writes everything out and closes the file
+    void close();
+
+private:
+    // where the words of a signal live. native holders are bytes wide, big numbers are words
+    struct signal_ref {
+        const void *data;
+        uint32_t size;
+        uint32_t bytes;
+    };
+
+    template <int msb, int lsb, bool signed_, bool array>
+    static signal_ref signal_of(const bit<msb, lsb, signed_, array> &b) {
+        using type = bit<msb, lsb, signed_, array>;
+        if constexpr (type::native_num) {
+            return {&b.value, type::size, sizeof(b.value)};
+        } else {
+            return {b.value.values.data(), type::size, 0};
+        }
+    }
+
+    void add_signal(signal_ref value, const void *xz_mask, int msb, int lsb,
+                    std::string_view name, std::string_view scope);
+
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+}  // namespace logic
+
+#endif  // LOGIC_VCD_HH
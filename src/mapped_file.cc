@@ -0,0 +1,50 @@
+#include "logic/mapped_file.hh"
+
+#include <fstream>
+#include <iterator>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LOGIC_MMAP
+#endif
+
+namespace logic::util {
+
+mapped_file::mapped_file(const std::string &filename, bool sequential) {
+#ifdef LOGIC_MMAP
+    auto const fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st = {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, st.st_size, sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+            map_ = p;
+            data_ = {static_cast<const char *>(p), static_cast<uint64_t>(st.st_size)};
+        }
+    }
+    ::close(fd);
+    if (map_ || st.st_size == 0) {
+        ok_ = true;
+        return;
+    }
+#else
+    (void)sequential;
+#endif
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream) return;
+    buffer_.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    data_ = buffer_;
+    ok_ = true;
+}
+
+mapped_file::~mapped_file() {
+#ifdef LOGIC_MMAP
+    if (map_) ::munmap(map_, data_.size());
+#endif
+}
+
+}  // namespace logic::util
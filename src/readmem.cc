@@ -0,0 +1,167 @@
+#include "logic/readmem.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include "logic/mapped_file.hh"
+
+namespace logic::util {
+
+constexpr bool is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+// calls on_address(address) for every @address and on_word(digits) for every word in text.
+// comments are skipped. returns false on a malformed address
+template <typename A, typename W>
+bool scan_memory(std::string_view text, A &&on_address, W &&on_word) {
+    uint64_t i = 0;
+    auto const n = text.size();
+    while (i < n) {
+        auto const c = text[i];
+        if (is_space(c)) {
+            i++;
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '/') {
+            auto const end = text.find('\n', i);
+            i = end == std::string_view::npos ? n : end + 1;
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '*') {
+            auto const end = text.find("*/", i + 2);
+            i = end == std::string_view::npos ? n : end + 2;
+        } else {
+            auto end = i;
+            while (end < n && !is_space(text[end]) && (end == i || text[end] != '/')) end++;
+            auto const token = text.substr(i, end - i);
+            if (c == '@') {
+                // addresses are always hex
+                uint64_t address = 0;
+                if (token.size() == 1) return false;
+                for (auto d : token.substr(1)) {
+                    if (d == '_') continue;
+                    auto const l = d | 0x20;
+                    if (!(d >= '0' && d <= '9') && !(l >= 'a' && l <= 'f')) return false;
+                    uint64_t v, xz;
+                    parse_literal_digit(d, v, xz);
+                    address = address * 16 + v;
+                }
+                on_address(address);
+            } else {
+                on_word(token);
+            }
+            i = end;
+        }
+    }
+    return true;
+}
+
+// below this, a file is not worth splitting
+constexpr uint64_t memory_chunk_size = 1 << 20;
+
+bool read_memory(const std::string &filename, uint64_t start, memory_visitor visit, void *context,
+                 uint64_t threads, bool descending) {
+    mapped_file file(filename, true);
+    if (!file.ok()) return false;
+    auto const text = file.data();
+    // the address of the word after one at address
+    auto next = [descending](uint64_t address) { return descending ? address - 1 : address + 1; };
+
+    // chunks end at line breaks, which is only safe without block comments as they can span
+    // lines. files with block comments are read in one go
+    if (threads == 0) {
+        threads = std::max<uint64_t>(std::thread::hardware_concurrency(), 1);
+        threads = std::min(threads, text.size() / memory_chunk_size + 1);
+    }
+    if (threads > 1 && text.find("/*") != std::string_view::npos) threads = 1;
+    std::vector<std::string_view> chunks;
+    uint64_t pos = 0;
+    for (uint64_t i = 1; i <= threads && pos < text.size(); i++) {
+        auto end = i == threads ? text.size() : text.size() * i / threads;
+        end = std::max(end, pos);
+        auto const line = text.find('\n', end);
+        end = line == std::string_view::npos ? text.size() : line + 1;
+        chunks.emplace_back(text.substr(pos, end - pos));
+        pos = end;
+    }
+
+    // first pass: the runs of consecutive words in each chunk, so that every chunk knows its
+    // first address and runs that overlap are found. a run starts at an @address, or at the start
+    // of the chunk
+    struct word_run {
+        bool has_address = false;
+        uint64_t address = 0;
+        uint64_t words = 0;
+    };
+    struct chunk_info {
+        std::vector<word_run> runs = {word_run{}};
+        bool ok = true;
+    };
+    std::vector<chunk_info> info(chunks.size());
+    auto run = [&](auto &&task) {
+        std::vector<std::thread> workers;
+        for (uint64_t i = 1; i < chunks.size(); i++) workers.emplace_back(task, i);
+        task(0);
+        for (auto &w : workers) w.join();
+    };
+    if (chunks.size() > 1) {
+        run([&](uint64_t i) {
+            auto &r = info[i];
+            r.ok = scan_memory(
+                chunks[i],
+                [&r](uint64_t address) { r.runs.push_back({true, address, 0}); },
+                [&r](std::string_view) { r.runs.back().words++; });
+        });
+    }
+    std::vector<uint64_t> addresses(chunks.size(), start);
+    for (uint64_t i = 1; i < chunks.size(); i++) {
+        auto const &last = info[i - 1].runs.back();
+        auto address = last.has_address ? last.address : addresses[i - 1];
+        addresses[i] = descending ? address - last.words : address + last.words;
+    }
+
+    // the last write to an address wins, so when an @address of one chunk goes back into the
+    // words of another, the chunks are read one after the other in file order
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    for (uint64_t i = 0; i < chunks.size(); i++) {
+        for (auto const &r : info[i].runs) {
+            if (!r.words) continue;
+            auto const first = r.has_address ? r.address : addresses[i];
+            if (descending) {
+                ranges.emplace_back(first >= r.words - 1 ? first - (r.words - 1) : 0, first);
+            } else {
+                ranges.emplace_back(first, first + (r.words - 1));
+            }
+        }
+    }
+    std::sort(ranges.begin(), ranges.end());
+    bool overlap = false;
+    for (uint64_t i = 1; i < ranges.size() && !overlap; i++) {
+        overlap = ranges[i].first <= ranges[i - 1].second;
+        ranges[i].second = std::max(ranges[i].second, ranges[i - 1].second);
+    }
+
+    // second pass: the words themselves
+    auto read_chunk = [&](uint64_t i) {
+        auto address = addresses[i];
+        info[i].ok &= scan_memory(
+            chunks[i], [&address](uint64_t a) { address = a; },
+            [&](std::string_view digits) {
+                visit(context, address, digits);
+                address = next(address);
+            });
+    };
+    if (overlap) {
+        for (uint64_t i = 0; i < chunks.size(); i++) read_chunk(i);
+    } else {
+        run(read_chunk);
+    }
+    return std::all_of(info.begin(), info.end(), [](auto const &r) { return r.ok; });
+}
+
+bool write_memory(const std::string &filename, std::string_view content) {
+    std::ofstream stream(filename, std::ios::binary);
+    if (!stream) return false;
+    stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return static_cast<bool>(stream);
+}
+
+}  // namespace logic::util
@@ -0,0 +1,51 @@
+#include "logic/serialize.hh"
+
+namespace logic {
+
+static constexpr std::string_view snapshot_magic = "LOGICSNP";
+static constexpr uint64_t snapshot_header_size = 16;
+
+snapshot_writer::snapshot_writer(const std::string &filename)
+    : stream_(filename, std::ios::binary) {
+    std::array<char, snapshot_header_size> header = {};
+    std::copy(snapshot_magic.begin(), snapshot_magic.end(), header.begin());
+    for (auto i = 0u; i < 4; i++) header[8 + i] = static_cast<char>(snapshot_version >> (i * 8));
+    stream_.write(header.data(), header.size());
+}
+
+bool snapshot_writer::close() {
+    stream_.close();
+    return ok();
+}
+
+snapshot_reader::snapshot_reader(const std::string &filename) : file_(filename) {
+    auto const data = file_.data();
+    if (!file_.ok() || data.size() < snapshot_header_size) return;
+    if (data.substr(0, snapshot_magic.size()) != snapshot_magic) return;
+    for (auto i = 0u; i < 4; i++) {
+        version_ |= static_cast<uint32_t>(static_cast<uint8_t>(data[8 + i])) << (i * 8);
+    }
+    ok_ = version_ >= 1 && version_ <= snapshot_version;
+    pos_ = snapshot_header_size;
+}
+
+const char *snapshot_reader::peek(util::record_header &header) const {
+    auto const data = file_.data();
+    if (!ok_ || data.size() - pos_ < sizeof(util::record_header)) return nullptr;
+    header = util::read_record_header(data.data() + pos_);
+    // the words of the record have to be in the file as well
+    auto const words = (header.size + 63) / 64 * ((header.flags & util::record_4state) ? 2 : 1);
+    auto const available = data.size() - pos_ - sizeof(util::record_header);
+    if (header.count > available / 8 / std::max<uint64_t>(words, 1)) return nullptr;
+    return data.data() + pos_;
+}
+
+bool snapshot_reader::skip() {
+    util::record_header header;
+    if (!peek(header)) return false;
+    auto const words = (header.size + 63) / 64 * ((header.flags & util::record_4state) ? 2 : 1);
+    pos_ += sizeof(util::record_header) + header.count * words * 8;
+    return true;
+}
+
+}  // namespace logic
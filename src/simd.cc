@@ -0,0 +1,357 @@
+#include "simd.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+#include "logic/big_num.hh"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define LOGIC_SIMD_X86
+#define LOGIC_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace logic::util {
+
+/*
+ * scalar kernels, which every other implementation falls back to
+ */
+// value and xz bits of every character, for binary (bit 0 and 4) and hex (low and high nibble)
+struct digit_class {
+    uint8_t bin;
+    uint8_t hex;
+};
+
+static constexpr auto digit_table = [] {
+    std::array<digit_class, 256> result{};
+    for (auto c = '0'; c <= '9'; c++) result[c].hex = c - '0';
+    for (auto c = 'a'; c <= 'f'; c++) result[c].hex = c - 'a' + 10;
+    for (auto c = 'A'; c <= 'F'; c++) result[c].hex = c - 'A' + 10;
+    result['1'].bin = 0x01;
+    for (auto c : {'x', 'X'}) {
+        result[c] = {0x10, 0xF0};
+    }
+    for (auto c : {'z', 'Z', '?'}) {
+        result[c] = {0x11, 0xFF};
+    }
+    return result;
+}();
+
+static constexpr char hex_chars[] = "0123456789abcdef";
+
+void parse_bin_scalar(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    for (auto w = words; w > 0; w--) {
+        uint64_t v = 0, xz = 0;
+        for (auto i = 0u; i < 64; i++) {
+            auto const d = digit_table[static_cast<uint8_t>(*digits++)].bin;
+            v = (v << 1) | (d & 1);
+            xz = (xz << 1) | (d >> 4);
+        }
+        value[w - 1] = v;
+        xz_mask[w - 1] = xz;
+    }
+}
+
+void parse_hex_scalar(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    for (auto w = words; w > 0; w--) {
+        uint64_t v = 0, xz = 0;
+        for (auto i = 0u; i < 16; i++) {
+            auto const d = digit_table[static_cast<uint8_t>(*digits++)].hex;
+            v = (v << 4) | (d & 0xF);
+            xz = (xz << 4) | (d >> 4);
+        }
+        value[w - 1] = v;
+        xz_mask[w - 1] = xz;
+    }
+}
+
+void format_bin_scalar(const uint64_t *value, const uint64_t *xz_mask, uint64_t words,
+                       char *out) {
+    for (auto w = words; w > 0; w--) {
+        auto const v = value[w - 1];
+        auto const xz = xz_mask ? xz_mask[w - 1] : 0;
+        for (auto i = 64; i > 0; i--) {
+            auto const b = (v >> (i - 1)) & 1;
+            *out++ = (xz >> (i - 1)) & 1 ? (b ? 'z' : 'x') : static_cast<char>('0' + b);
+        }
+    }
+}
+
+char hex_xz_digit(uint64_t v, uint64_t xz) {
+    if (xz == 0xF && v == 0) return 'x';
+    if (xz == 0xF && v == 0xF) return 'z';
+    return (xz & ~v) ? 'X' : 'Z';
+}
+
+void format_hex_scalar(const uint64_t *value, const uint64_t *xz_mask, uint64_t words,
+                       char *out) {
+    for (auto w = words; w > 0; w--) {
+        auto const v = value[w - 1];
+        auto const xz = xz_mask ? xz_mask[w - 1] : 0;
+        for (auto i = 16; i > 0; i--) {
+            auto const d = (v >> ((i - 1) * 4)) & 0xF;
+            auto const x = (xz >> ((i - 1) * 4)) & 0xF;
+            *out++ = x ? hex_xz_digit(d, x) : hex_chars[d];
+        }
+    }
+}
+
+static constexpr digit_kernels scalar_kernels = {parse_bin_scalar, parse_hex_scalar,
+                                                 format_bin_scalar, format_hex_scalar};
+
+#ifdef LOGIC_SIMD_X86
+/*
+ * SSE4.2 kernels, 16 characters per step
+ */
+// 0xFF for every byte in [lo, hi]. ASCII is below 0x80 so the signed compares are fine
+LOGIC_TARGET("sse4.2") inline __m128i in_range(__m128i c, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), c));
+}
+
+LOGIC_TARGET("sse4.2")
+void parse_bin_sse42(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    auto const lower = _mm_set1_epi8(0x20);
+    for (auto w = words; w > 0; w--) {
+        uint64_t v = 0, xz = 0;
+        for (auto i = 0u; i < 4; i++) {
+            auto const c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(digits + i * 16));
+            auto const l = _mm_or_si128(c, lower);
+            auto const z = _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('z')),
+                                        _mm_cmpeq_epi8(c, _mm_set1_epi8('?')));
+            auto const x = _mm_cmpeq_epi8(l, _mm_set1_epi8('x'));
+            auto const one = _mm_cmpeq_epi8(c, _mm_set1_epi8('1'));
+            // bit j of the mask is character j
+            v |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_or_si128(one, z))) << (i * 16);
+            xz |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_or_si128(x, z))) << (i * 16);
+        }
+        // the first character is the most significant bit
+        value[w - 1] = reverse_blocks<1>(v);
+        xz_mask[w - 1] = reverse_blocks<1>(xz);
+        digits += 64;
+    }
+}
+
+// 16 hex characters to their nibble values and xz nibbles, one per byte
+LOGIC_TARGET("sse4.2") inline void hex_nibbles(__m128i c, __m128i &v, __m128i &xz) {
+    auto const l = _mm_or_si128(c, _mm_set1_epi8(0x20));
+    auto const digit = _mm_and_si128(in_range(c, '0', '9'), _mm_sub_epi8(c, _mm_set1_epi8('0')));
+    auto const alpha =
+        _mm_and_si128(in_range(l, 'a', 'f'), _mm_sub_epi8(l, _mm_set1_epi8('a' - 10)));
+    auto const z = _mm_or_si128(_mm_cmpeq_epi8(l, _mm_set1_epi8('z')),
+                                _mm_cmpeq_epi8(c, _mm_set1_epi8('?')));
+    auto const x = _mm_cmpeq_epi8(l, _mm_set1_epi8('x'));
+    auto const nibble = _mm_set1_epi8(0xF);
+    v = _mm_or_si128(_mm_or_si128(digit, alpha), _mm_and_si128(z, nibble));
+    xz = _mm_and_si128(_mm_or_si128(x, z), nibble);
+}
+
+// packs 16 nibbles into a word, the first one being the most significant
+LOGIC_TARGET("sse4.2") inline uint64_t pack_nibbles(__m128i n) {
+    // each byte pair becomes (first << 4) | second
+    auto const pairs = _mm_maddubs_epi16(n, _mm_set1_epi16(0x0110));
+    auto const bytes = _mm_packus_epi16(pairs, pairs);
+    return __builtin_bswap64(static_cast<uint64_t>(_mm_cvtsi128_si64(bytes)));
+}
+
+LOGIC_TARGET("sse4.2")
+void parse_hex_sse42(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    for (auto w = words; w > 0; w--) {
+        __m128i v, xz;
+        hex_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)), v, xz);
+        value[w - 1] = pack_nibbles(v);
+        xz_mask[w - 1] = pack_nibbles(xz);
+        digits += 16;
+    }
+}
+
+// 0xFF for every byte whose bit is set, for 16 bits with the most significant one first
+LOGIC_TARGET("sse4.2") inline __m128i spread_bits(uint64_t bits) {
+    auto const b = _mm_set1_epi16(static_cast<int16_t>(bits));
+    auto const spread = _mm_shuffle_epi8(b, _mm_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1,
+                                                         1, 1, 1));
+    auto const select = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    return _mm_cmpeq_epi8(_mm_and_si128(spread, select), select);
+}
+
+LOGIC_TARGET("sse4.2")
+void format_bin_sse42(const uint64_t *value, const uint64_t *xz_mask, uint64_t words,
+                      char *out) {
+    for (auto w = words; w > 0; w--) {
+        auto const v = value[w - 1];
+        auto const xz = xz_mask ? xz_mask[w - 1] : 0;
+        for (auto i = 4; i > 0; i--) {
+            auto const shift = (i - 1) * 16;
+            auto const vb = spread_bits(v >> shift);
+            // '0' or '1', and 'x' or 'z' for the xz bits
+            auto c = _mm_sub_epi8(_mm_set1_epi8('0'), vb);
+            if ((xz >> shift) & 0xFFFF) {
+                auto const xc =
+                    _mm_add_epi8(_mm_set1_epi8('x'), _mm_and_si128(vb, _mm_set1_epi8(2)));
+                c = _mm_blendv_epi8(c, xc, spread_bits(xz >> shift));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), c);
+            out += 16;
+        }
+    }
+}
+
+// 16 nibbles of a word, one per byte, the most significant one first
+LOGIC_TARGET("sse4.2") inline __m128i unpack_nibbles(uint64_t w) {
+    auto const bytes = _mm_cvtsi64_si128(static_cast<int64_t>(__builtin_bswap64(w)));
+    auto const nibble = _mm_set1_epi8(0xF);
+    auto const hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+    auto const lo = _mm_and_si128(bytes, nibble);
+    return _mm_unpacklo_epi8(hi, lo);
+}
+
+LOGIC_TARGET("sse4.2")
+void format_hex_sse42(const uint64_t *value, const uint64_t *xz_mask, uint64_t words,
+                      char *out) {
+    auto const table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(hex_chars));
+    auto const zero = _mm_setzero_si128();
+    auto const nibble = _mm_set1_epi8(0xF);
+    for (auto w = words; w > 0; w--) {
+        auto const v = unpack_nibbles(value[w - 1]);
+        auto c = _mm_shuffle_epi8(table, v);
+        auto const xz_word = xz_mask ? xz_mask[w - 1] : 0;
+        if (xz_word) {
+            // same rules as hex_xz_digit, with the more specific cases applied last
+            auto const xz = unpack_nibbles(xz_word);
+            auto const any = _mm_xor_si128(_mm_cmpeq_epi8(xz, zero), _mm_set1_epi8(-1));
+            auto const has_x =
+                _mm_xor_si128(_mm_cmpeq_epi8(_mm_andnot_si128(v, xz), zero), _mm_set1_epi8(-1));
+            auto const full = _mm_cmpeq_epi8(xz, nibble);
+            c = _mm_blendv_epi8(c, _mm_set1_epi8('Z'), any);
+            c = _mm_blendv_epi8(c, _mm_set1_epi8('X'), _mm_and_si128(any, has_x));
+            c = _mm_blendv_epi8(c, _mm_set1_epi8('z'),
+                                _mm_and_si128(full, _mm_cmpeq_epi8(v, nibble)));
+            c = _mm_blendv_epi8(c, _mm_set1_epi8('x'),
+                                _mm_and_si128(full, _mm_cmpeq_epi8(v, zero)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), c);
+        out += 16;
+    }
+}
+
+static constexpr digit_kernels sse42_kernels = {parse_bin_sse42, parse_hex_sse42,
+                                                format_bin_sse42, format_hex_sse42};
+
+/*
+ * AVX2 kernels, 32 characters per step
+ */
+LOGIC_TARGET("avx2")
+void parse_bin_avx2(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    auto const lower = _mm256_set1_epi8(0x20);
+    for (auto w = words; w > 0; w--) {
+        uint64_t v = 0, xz = 0;
+        for (auto i = 0u; i < 2; i++) {
+            auto const c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(digits + i * 32));
+            auto const l = _mm256_or_si256(c, lower);
+            auto const z = _mm256_or_si256(_mm256_cmpeq_epi8(l, _mm256_set1_epi8('z')),
+                                           _mm256_cmpeq_epi8(c, _mm256_set1_epi8('?')));
+            auto const x = _mm256_cmpeq_epi8(l, _mm256_set1_epi8('x'));
+            auto const one = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('1'));
+            v |= static_cast<uint64_t>(static_cast<uint32_t>(
+                     _mm256_movemask_epi8(_mm256_or_si256(one, z))))
+                 << (i * 32);
+            xz |= static_cast<uint64_t>(static_cast<uint32_t>(
+                      _mm256_movemask_epi8(_mm256_or_si256(x, z))))
+                  << (i * 32);
+        }
+        value[w - 1] = reverse_blocks<1>(v);
+        xz_mask[w - 1] = reverse_blocks<1>(xz);
+        digits += 64;
+    }
+}
+
+LOGIC_TARGET("avx2")
+void parse_hex_avx2(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask) {
+    auto w = words;
+    for (; w >= 2; w -= 2) {
+        auto const c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(digits));
+        __m128i v[2], xz[2];
+        hex_nibbles(_mm256_castsi256_si128(c), v[0], xz[0]);
+        hex_nibbles(_mm256_extracti128_si256(c, 1), v[1], xz[1]);
+        value[w - 1] = pack_nibbles(v[0]);
+        xz_mask[w - 1] = pack_nibbles(xz[0]);
+        value[w - 2] = pack_nibbles(v[1]);
+        xz_mask[w - 2] = pack_nibbles(xz[1]);
+        digits += 32;
+    }
+    if (w) parse_hex_sse42(digits, w, value, xz_mask);
+}
+
+// 0xFF for every byte whose bit is set, for 32 bits with the most significant one first
+LOGIC_TARGET("avx2") inline __m256i spread_bits_avx2(uint64_t bits) {
+    auto const b = _mm256_set1_epi32(static_cast<int32_t>(bits));
+    auto const spread = _mm256_shuffle_epi8(
+        b, _mm256_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2,
+                           3, 3, 3, 3, 3, 3, 3, 3));
+    auto const select = _mm256_set1_epi64x(0x0102'0408'1020'4080);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(spread, select), select);
+}
+
+LOGIC_TARGET("avx2")
+void format_bin_avx2(const uint64_t *value, const uint64_t *xz_mask, uint64_t words, char *out) {
+    for (auto w = words; w > 0; w--) {
+        auto const v = value[w - 1];
+        auto const xz = xz_mask ? xz_mask[w - 1] : 0;
+        for (auto i = 2; i > 0; i--) {
+            auto const shift = (i - 1) * 32;
+            auto const vb = spread_bits_avx2(v >> shift);
+            auto c = _mm256_sub_epi8(_mm256_set1_epi8('0'), vb);
+            if ((xz >> shift) & 0xFFFF'FFFF) {
+                auto const xc = _mm256_add_epi8(_mm256_set1_epi8('x'),
+                                                _mm256_and_si256(vb, _mm256_set1_epi8(2)));
+                c = _mm256_blendv_epi8(c, xc, spread_bits_avx2(xz >> shift));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), c);
+            out += 32;
+        }
+    }
+}
+
+static constexpr digit_kernels avx2_kernels = {parse_bin_avx2, parse_hex_avx2, format_bin_avx2,
+                                               format_hex_sse42};
+#endif
+
+simd_level simd_support() {
+#ifdef LOGIC_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return simd_level::avx2;
+    if (__builtin_cpu_supports("sse4.2")) return simd_level::sse42;
+#endif
+    return simd_level::scalar;
+}
+
+const digit_kernels *kernels_for(simd_level level) {
+    switch (level) {
+#ifdef LOGIC_SIMD_X86
+        case simd_level::avx2:
+            return &avx2_kernels;
+        case simd_level::sse42:
+            return &sse42_kernels;
+#endif
+        default:
+            return &scalar_kernels;
+    }
+}
+
+std::atomic<const digit_kernels *> &active_kernels() {
+    static std::atomic<const digit_kernels *> kernels = kernels_for(simd_support());
+    return kernels;
+}
+
+simd_level set_simd_level(simd_level level) {
+    level = std::min(level, simd_support());
+    active_kernels().store(kernels_for(level), std::memory_order_relaxed);
+    return level;
+}
+
+const digit_kernels &get_digit_kernels() {
+    return *active_kernels().load(std::memory_order_relaxed);
+}
+
+}  // namespace logic::util
@@ -0,0 +1,28 @@
+#ifndef LOGIC_SIMD_HH
+#define LOGIC_SIMD_HH
+
+#include <cstdint>
+
+#include "logic/util.hh"
+
+namespace logic::util {
+
+// conversion between ASCII digits and whole words of value and xz bits. digits are most
+// significant first, while words are little-endian, so the last digits go into words[0].
+// x and X are x, z, Z and ? are z, any other character that is not a digit reads as 0
+struct digit_kernels {
+    // 64 digits per word
+    void (*parse_bin)(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask);
+    // 16 digits per word
+    void (*parse_hex)(const char *digits, uint64_t words, uint64_t *value, uint64_t *xz_mask);
+    // xz_mask can be null for 2-state values. x and z digits follow LRM 21.2.1.4
+    void (*format_bin)(const uint64_t *value, const uint64_t *xz_mask, uint64_t words, char *out);
+    void (*format_hex)(const uint64_t *value, const uint64_t *xz_mask, uint64_t words, char *out);
+};
+
+// the kernels picked by set_simd_level(), or the best ones the cpu supports
+const digit_kernels &get_digit_kernels();
+
+}  // namespace logic::util
+
+#endif  // LOGIC_SIMD_HH
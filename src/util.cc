@@ -1,250 +1,206 @@
 #include "logic/util.hh"
 
-#include <bitset>
+#include <charconv>
 #include <cmath>
-#include <optional>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "logic/big_num.hh"
+#include "simd.hh"
 
 namespace logic::util {
 
-constexpr std::pair<char, uint64_t> get_input_base(std::string_view value) {
-    char base = 'b';
-    uint64_t pos = 0;
-
-    auto p = value.find_first_of('\'');
-    if (p != std::string::npos) {
-        // need to find the next base values
-        value = value.substr(p + 1);
-        auto b = value.find_first_not_of("0123456789");
-        if (b != std::string::npos) {
-            base = value[b];
-            pos = b + 1 + p + 1;
-        }
-    } else {
-        base = 's';
+uint64_t get_stride(char base) {
+    switch (base) {
+        case 'b':
+        case 'B':
+            return 1;
+        case 'o':
+        case 'O':
+            return 3;
+        case 'h':
+        case 'H':
+        case 'x':
+        case 'X':
+            return 4;
+        case 's':
+        case 'S':
+            return 8;
+        default:
+            return 1;
     }
-
-    return {base, pos};
 }
 
-char get_output_base(std::string_view fmt) {
-    auto p = fmt.find_first_not_of("0123456789");
-    if (p == std::string::npos) {
-        return 'b';
+// value and xz bits of a single hex digit, which also covers octal and decimal
+void parse_digit(char c, uint64_t& value, uint64_t& xz_mask) {
+    auto const l = c | 0x20;
+    xz_mask = 0;
+    if (c >= '0' && c <= '9') {
+        value = c - '0';
+    } else if (l >= 'a' && l <= 'f') {
+        value = l - 'a' + 10;
+    } else if (l == 'x') {
+        value = 0;
+        xz_mask = 0xF;
+    } else if (l == 'z' || c == '?') {
+        value = 0xF;
+        xz_mask = 0xF;
     } else {
-        return fmt[p];
+        value = 0;
+    }
+}
+
+// sets bits [start, end) of words
+void set_bits(uint64_t* words, uint64_t start, uint64_t end) {
+    for (auto i = start; i < end;) {
+        auto const count = std::min<uint64_t>(64 - i % 64, end - i);
+        words[i / 64] |= tail_mask(count) << (i % 64);
+        i += count;
     }
 }
 
-constexpr uint64_t parse_raw_str_(std::string_view value, char base) {
-    uint64_t result = 0;
+// parses the digits of a literal, i.e. without the size and the base, into the n words of value
+// and xz bits that hold size bits. binary and hex digits go through the word kernels, the other
+// bases are rare enough to be parsed one digit at a time
+void parse_digits(std::string_view digits, char base, uint64_t size, uint64_t* value,
+                  uint64_t* xz_mask, uint64_t pad_size) {
+    auto const n = (size + 63) / 64;
+    // outputs the caller doesn't need still need somewhere to go
+    std::array<uint64_t, 16> stack;
+    std::vector<uint64_t> heap;
+    auto scratch = [&]() -> uint64_t* {
+        if (n <= stack.size()) return stack.data();
+        heap.resize(n);
+        return heap.data();
+    };
+    if (!value) value = scratch();
+    if (!xz_mask) xz_mask = scratch();
+    std::fill(value, value + n, 0);
+    std::fill(xz_mask, xz_mask + n, 0);
+
+    // underscores are only separators
+    std::string compact;
+    if (digits.find('_') != std::string_view::npos) {
+        std::copy_if(digits.begin(), digits.end(), std::back_inserter(compact),
+                     [](char c) { return c != '_'; });
+        digits = compact;
+    }
+    auto const len = digits.size();
+    pad_size = std::min(pad_size, size);
+
     switch (base) {
-        case 'd':
-        case 'D': {
-            uint64_t base10 = 1;
-            for (auto i = 0ull; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                if (c >= '0' && c <= '9') {
-                    uint64_t v = c - '0';
-                    result += v * base10;
-                    base10 *= 10;
-                }
-            }
-            break;
-        }
         case 'b':
-        case 'B': {
-            // need to take care of 1 and z
-            uint64_t idx = 0;
-            for (auto i = 0ull; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                if (c == '1' || c == 'z') {
-                    result |= 1ull << idx;
-                }
-                if (c != '_') idx++;
+        case 'B':
+        case 'h':
+        case 'H': {
+            auto const& kernels = get_digit_kernels();
+            auto const binary = base == 'b' || base == 'B';
+            auto const parse = binary ? kernels.parse_bin : kernels.parse_hex;
+            auto const per_word = binary ? 64u : 16u;
+            // whole words straight from the string, from the least significant end
+            auto const words = std::min<uint64_t>(len / per_word, n);
+            parse(digits.data() + len - words * per_word, words, value, xz_mask);
+            auto const rest = std::min<uint64_t>(len - words * per_word, per_word);
+            if (words < n && rest) {
+                // the leftover digits are zero extended into a full word
+                std::array<char, 64> word;
+                std::fill_n(word.begin(), per_word - rest, '0');
+                std::copy_n(digits.data() + len - words * per_word - rest, rest,
+                            word.begin() + per_word - rest);
+                parse(word.data(), 1, value + words, xz_mask + words);
             }
             break;
         }
         case 'o':
         case 'O': {
-            // same for x
-            uint64_t idx = 0;
-            for (auto i = 0ull; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                uint64_t s;
-                // this will be taken care of by the xz mask parsing
-                if (c == 'x' || c == 'X' || c == '_')
-                    s = 0;
-                else if (c == 'z' || c == 'Z')
-                    s = 0b111;
-                else
-                    s = c - '0';
-                result |= s << (idx * 3ull);
-                if (c != '_') idx++;
+            for (uint64_t i = 0; i < len && i * 3 < n * 64; i++) {
+                uint64_t v, xz;
+                parse_digit(digits[len - i - 1], v, xz);
+                v &= 0b111;
+                xz &= 0b111;
+                insert_bits(value, n, i * 3, 3, &v, 1);
+                insert_bits(xz_mask, n, i * 3, 3, &xz, 1);
             }
             break;
         }
-        case 'h':
-        case 'H': {
-            uint64_t idx = 0;
-            for (auto i = 0ull; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                uint64_t s = 0;
-                // this will be taken care of by the xz mask parsing
-                if (c == 'x' || c == 'X' || c == '_')
-                    s = 0;
-                else if (c == 'z' || c == 'Z')
-                    s = 0b1111;
-                else if (c >= '0' && c <= '9')
-                    s = c - '0';
-                else if (c >= 'a' && c <= 'f')
-                    s = c - 'a';
-                else if (c >= 'A' && c <= 'F')
-                    s = c - 'A' + 10;
-                result |= s << (idx * 4ull);
-                if (c != '_') idx++;
+        case 'd':
+        case 'D': {
+            if (len == 1 && (digits[0] != '0' && (digits[0] < '1' || digits[0] > '9'))) {
+                // 'dx and 'dz set every bit
+                uint64_t v, xz;
+                parse_digit(digits[0], v, xz);
+                if (xz) set_bits(xz_mask, 0, pad_size);
+                if (v == 0xF) set_bits(value, 0, pad_size);
+                break;
+            }
+            for (auto c : digits) {
+                if (c < '0' || c > '9') continue;
+                // value = value * 10 + digit
+                uint64_t carry = c - '0';
+                for (uint64_t i = 0; i < n; i++) {
+                    auto const t = static_cast<__uint128_t>(value[i]) * 10 + carry;
+                    value[i] = static_cast<uint64_t>(t);
+                    carry = static_cast<uint64_t>(t >> 64);
+                }
             }
             break;
         }
         case 's':
         case 'S': {
-            for (auto i = 0u; i < std::min<uint64_t>(8ul, value.size()); i++) {
-                uint64_t c = static_cast<uint8_t>(value[value.size() - i - 1]);
-                result |= c << (i * 8);
+            for (uint64_t i = 0; i < len && i * 8 < n * 64; i++) {
+                uint64_t const c = static_cast<uint8_t>(digits[len - i - 1]);
+                value[i / 8] |= c << (i % 8 * 8);
             }
+            break;
         }
         default:;
     }
 
-    return result;
-}
-
-uint64_t parse_raw_str(std::string_view value) {
-    auto [base, start_pos] = get_input_base(value);
-    return parse_raw_str_(value.substr(start_pos), base);
-}
-
-uint64_t parse_xz_raw_str_(std::string_view value, char base) {
-    uint64_t result = 0;
-
-    switch (base) {
-        case 'b':
-        case 'B': {
-            uint64_t idx = 0;
-            for (auto i = 0u; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                if (c == 'x' || c == 'z') {
-                    result |= 1u << idx;
-                }
-                if (c != '_') idx++;
-            }
-            break;
+    // an x or z in the leftmost bit pads instead of 0, LRM 5.7.1
+    auto const l = base | 0x20;
+    if (len > 0 && (l == 'b' || l == 'o' || l == 'h')) {
+        auto const stride = get_stride(base);
+        uint64_t v, xz;
+        parse_digit(digits[0], v, xz);
+        if ((xz >> (stride - 1)) & 1) {
+            set_bits(xz_mask, len * stride, pad_size);
+            if ((v >> (stride - 1)) & 1) set_bits(value, len * stride, pad_size);
         }
-        case 'o':
-        case 'O': {
-            // same for x
-            uint64_t idx = 0;
-            for (auto i = 0u; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                uint64_t s;
-                // this will be taken care of by the xz mask parsing
-                if (c == 'x' || c == 'X' || c == 'z' || c == 'Z') {
-                    s = 0b111;
-                    result |= s << (idx * 3);
-                }
-                if (c != '_') idx++;
-            }
-            break;
-        }
-        case 'h':
-        case 'H': {
-            uint64_t idx = 0;
-            for (auto i = 0u; i < value.size(); i++) {
-                auto c = value[value.size() - i - 1];
-                uint64_t s;
-                // this will be taken care of by the xz mask parsing
-                if (c == 'x' || c == 'X' || c == 'z' || c == 'Z') {
-                    s = 0b1111;
-                    result |= s << (idx * 4);
-                }
-                if (c != '_') idx++;
-            }
-        }
-        default:;
     }
 
-    return result;
+    value[n - 1] &= tail_mask(size);
+    xz_mask[n - 1] &= tail_mask(size);
 }
 
-uint64_t parse_xz_raw_str(std::string_view value) {
-    auto [base, start_pos] = get_input_base(value);
-    return parse_xz_raw_str_(value.substr(start_pos), base);
-}
-
-uint64_t get_stride(char base) {
-    switch (base) {
-        case 'b':
-        case 'B':
-            return 1;
-        case 'o':
-        case 'O':
-            return 3;
-        case 'h':
-        case 'H':
-        case 'x':
-        case 'X':
-            return 4;
-        case 's':
-        case 'S':
-            return 8;
-        default:
-            return 1;
-    }
+void parse_raw_str(std::string_view value, uint64_t size, uint64_t* ptr, uint64_t* xz_ptr) {
+    auto const format = parse_literal_format(value);
+    // padding stops at the size of the literal, the rest is zero extended
+    parse_digits(value.substr(format.pos), format.base, size, ptr, xz_ptr,
+                 format.sized ? format.size : size);
 }
 
 void parse_raw_str(std::string_view value, uint64_t size, uint64_t* ptr) {
-    // use existing functions to parse single uint64_t values, except for decimals.
-    // big number decimals are just inefficient, and I don't know why would anyone use it.
-    auto [base, start_pos] = get_input_base(value);
-    value = value.substr(start_pos);
-    auto remaining_size = value.size();
-    auto end = value.size();
-    auto const stride = get_stride(base);
-    auto const batch_size = 64 / stride;
-
-    auto num_array = (size % 64 == 0) ? size / 64 : (size / 64 + 1);
-    uint64_t idx = 0;
-    while (remaining_size > 0 && idx < num_array) {
-        auto begin = remaining_size >= batch_size ? remaining_size - batch_size : 0;
-        ptr[idx] = parse_raw_str_(value.substr(begin, end - begin), base);
-
-        idx++;
-        end = begin;
-        remaining_size = remaining_size > batch_size ? remaining_size - batch_size : 0;
-    }
+    parse_raw_str(value, size, ptr, nullptr);
 }
 
 void parse_xz_raw_str(std::string_view value, uint64_t size, uint64_t* ptr) {
-    // use existing functions to parse single uint64_t values, except for decimals.
-    // big number decimals are just inefficient, and I don't know why would anyone use it.
-    auto [base, start_pos] = get_input_base(value);
-    value = value.substr(start_pos);
-    auto remaining_size = value.size();
-    auto end = value.size();
-    auto const stride = get_stride(base);
-    auto const batch_size = 64 / stride;
-
-    auto num_array = (size % 64 == 0) ? size / 64 : (size / 64 + 1);
-    uint64_t idx = 0;
-    while (remaining_size > 0 && idx < num_array) {
-        auto begin = remaining_size >= batch_size ? remaining_size - batch_size : 0;
-        ptr[idx] = parse_xz_raw_str_(value.substr(begin, end - begin), base);
-
-        idx++;
-        end = begin;
-        remaining_size = remaining_size > batch_size ? remaining_size - batch_size : 0;
-    }
+    parse_raw_str(value, size, nullptr, ptr);
+}
+
+uint64_t parse_raw_str(std::string_view value) {
+    uint64_t result;
+    parse_raw_str(value, 64, &result, nullptr);
+    return result;
 }
 
+uint64_t parse_xz_raw_str(std::string_view value) {
+    uint64_t result;
+    parse_raw_str(value, 64, nullptr, &result);
+    return result;
+}
+
+
 constexpr std::array<uint64_t, 128> compute_decimal_size() {
     // we precompute 128 entries of decimal sizes. if larger than that we need to
     // recompute each time. no caching allowed for the sakes of concurrency since
@@ -270,27 +226,14 @@ constexpr std::array<uint64_t, 128> compute_decimal_size() {
 }
 
 static constexpr auto decimal_size_table = compute_decimal_size();
+static constexpr double log10_2 = 0.30102999566398119521;
 
-void parse_fmt(const std::string_view& fmt, uint64_t size, char& base, uint64_t& actual_size,
-               bool& padding) {
-    // if base not specified, we treat it as a raw string
-    base = 's';
+void parse_fmt(format_spec spec, uint64_t size, uint64_t& actual_size, bool& padding) {
     padding = true;  // per LRM 21.2.1.3, we need to perform padding by default
-    // need to find the base
-    auto pos = fmt.find_first_not_of("0123456789");
-    if (pos != std::string::npos) {
-        base = fmt[pos];
-    }
-    // now that we now the base, need to see what's requested size
-    std::optional<uint64_t> requested_size;
-    if (pos != 0) {
-        // don't copy here?
-        requested_size = std::stoul(std::string(fmt.substr(0, pos)));
-    }
 
     // compute actual size
     uint64_t possible_size;
-    switch (base) {
+    switch (spec.base) {
         case 'b':
         case 'B': {
             possible_size = size;
@@ -303,10 +246,10 @@ void parse_fmt(const std::string_view& fmt, uint64_t size, char& base, uint64_t&
         }
         case 'd':
         case 'D': {
-            // give up if the size is larger than 128
-            // will implement this in the future
-            if (size > 128) {
-                possible_size = size;
+            // 2^size - 1 has floor(size * log10(2)) + 1 digits, since 2^size is never a power
+            // of 10
+            if (size >= 128) {
+                possible_size = static_cast<uint64_t>(static_cast<double>(size) * log10_2) + 1;
             } else {
                 possible_size = decimal_size_table[size];
             }
@@ -324,439 +267,411 @@ void parse_fmt(const std::string_view& fmt, uint64_t size, char& base, uint64_t&
             possible_size = static_cast<uint64_t>(ceil(static_cast<double>(size) / 8.0));
             break;
         }
+        case 'c':
+        case 'C': {
+            possible_size = 1;
+            break;
+        }
         default:
             possible_size = size;
     }
 
     actual_size = possible_size;
-    if (requested_size) {
+    if (spec.width >= 0) {
         // need to compute the actual size and do a max, unless it's 0, which we don't do any
         // padding
-        if (*requested_size == 0) {
+        if (spec.width == 0) {
             padding = false;
         } else {
-            actual_size = std::max<uint64_t>(actual_size, *requested_size);
+            actual_size = std::max<uint64_t>(actual_size, spec.width);
         }
     }
 }
 
-std::string pad_result(bool is_negative, char base, uint64_t actual_size, bool padding,
-                       const std::stringstream& ss) {
-    auto result = ss.str();
-    if (is_negative && (base == 'd' || base == 'D')) {
-        result.append("-");
-        actual_size++;
+// decimal formatting for arbitrary width numbers. the number is cut into 19-digit chunks by
+// dividing by 10^19, which is the largest power of 10 that fits in a word. very wide numbers are
+// first split in halves by dividing by 10^(19 * 2^k), so that the cost is dominated by a few big
+// divisions instead of a quadratic number of short ones
+constexpr uint64_t decimal_chunk = 10'000'000'000'000'000'000ull;
+constexpr uint64_t decimal_chunk_digits = 19;
+// below this many words the short divisions win
+constexpr uint64_t decimal_split_threshold = 24;
+constexpr uint64_t decimal_power_levels = 12;
+
+// 10^(19 * 2^k), k = [0, decimal_power_levels). the table is built once on first use and never
+// changes afterwards, so it is safe to share across threads without any locking
+const std::vector<std::vector<uint64_t>>& decimal_powers() {
+    static const auto powers = [] {
+        std::vector<std::vector<uint64_t>> result;
+        result.emplace_back(1, decimal_chunk);
+        for (auto k = 1u; k < decimal_power_levels; k++) {
+            auto const& p = result.back();
+            std::vector<uint64_t> square(p.size() * 2);
+            mul_basecase(square.data(), square.size(), p.data(), p.size(), p.data(), p.size());
+            while (square.back() == 0) square.pop_back();
+            result.emplace_back(std::move(square));
+        }
+        return result;
+    }();
+    return powers;
+}
+
+// out[0, digits) = the lowest digits decimal digits of v, zero padded
+void write_decimal_chunk(uint64_t v, char* out, uint64_t digits) {
+    for (auto i = digits; i > 0; i--) {
+        out[i - 1] = static_cast<char>('0' + v % 10);
+        v /= 10;
     }
-    if (padding) {
-        if (result.size() < actual_size) {
-            auto const num_pad = actual_size - result.size();
-            auto pad_char = (base == 'd' || base == 'D' || base == 's' || base == 'S') ? " " : "0";
-            for (auto i = 0u; i < num_pad; i++) {
-                result.append(pad_char);
-            }
+}
+
+uint64_t trimmed_words(const uint64_t* a, uint64_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+// out[0, digits) = a[0, n) in decimal, zero padded. digits has to be large enough to hold the
+// value. a is used as scratch space, and so is t, which needs 3n + 64 words once n reaches the
+// split threshold. the low part of a split is written recursively and the high part takes the
+// place of a, so the remainder, at most half as wide as a, is the only recursion
+void write_decimal(uint64_t* a, uint64_t n, char* out, uint64_t digits, uint64_t* t) {
+    n = trimmed_words(a, n);
+    while (n >= decimal_split_threshold) {
+        // pick the largest power that is at most half as wide as a, so both halves are balanced
+        auto const& powers = decimal_powers();
+        uint64_t k = 0;
+        while (k + 1 < powers.size() && powers[k + 1].size() * 2 <= n + 1) k++;
+        auto const& p = powers[k];
+        auto const low_digits = decimal_chunk_digits << k;
+
+        auto const q_words = n - p.size() + 1;
+        auto* q = t;
+        auto* r = q + q_words;
+        auto* rest = r + p.size();
+        div_mod_n(q, r, a, n, p.data(), p.size(), rest);
+        if (digits <= low_digits) {
+            // the quotient has to be 0
+            write_decimal(r, p.size(), out, digits, rest);
+            return;
+        }
+        write_decimal(r, p.size(), out + digits - low_digits, low_digits, rest);
+        std::copy_n(q, q_words, a);
+        n = trimmed_words(a, q_words);
+        digits -= low_digits;
+    }
+
+    auto pos = digits;
+    while (n > 0 && pos > 0) {
+        __uint128_t rem = 0;
+        for (auto i = n; i > 0; i--) {
+            auto v = (rem << 64) | a[i - 1];
+            a[i - 1] = static_cast<uint64_t>(v / decimal_chunk);
+            rem = v % decimal_chunk;
+        }
+        auto const count = std::min(pos, decimal_chunk_digits);
+        write_decimal_chunk(static_cast<uint64_t>(rem), out + pos - count, count);
+        pos -= count;
+        n = trimmed_words(a, n);
+    }
+    std::fill(out, out + pos, '0');
+}
+
+// digit tables for the power of 2 bases. 2-state values are written a byte at a time
+static constexpr char hex_digits[] = "0123456789abcdef";
+
+static constexpr auto binary_table = [] {
+    std::array<std::array<char, 8>, 256> result{};
+    for (auto i = 0u; i < 256; i++) {
+        for (auto j = 0u; j < 8; j++) {
+            result[i][j] = (i >> (7 - j)) & 1 ? '1' : '0';
         }
     }
-    std::reverse(result.begin(), result.end());
     return result;
+}();
+
+static constexpr auto hex_table = [] {
+    std::array<std::array<char, 2>, 256> result{};
+    for (auto i = 0u; i < 256; i++) {
+        result[i] = {hex_digits[i >> 4], hex_digits[i & 0xF]};
+    }
+    return result;
+}();
+
+// bits [pos, pos + count) of w, count <= 64. bits at or past size are dropped, since the top word
+// of a native signed number can be sign extended
+uint64_t bits_at(const uint64_t* w, uint64_t size, uint64_t pos, uint64_t count) {
+    count = std::min(count, size - pos);
+    auto const idx = pos / 64;
+    auto const shift = pos % 64;
+    auto v = w[idx] >> shift;
+    if (shift + count > 64) v |= w[idx + 1] << (64 - shift);
+    return v & tail_mask(count);
 }
 
-std::string format_value_2power(char base, uint64_t value) {
-    std::ostringstream ss;
-    switch (base) {
-        case 'o':
-        case 'O': {
-            ss << std::oct << value;
-            break;
-        }
-        case 'x':
-        case 'h':
-        case 'X':
-        case 'H': {
-            ss << std::hex << value;
-            break;
-        }
-        default:;
+// LRM 21.2.1.4: a digit with all bits x (or z) shows as x (or z). a mix shows as X if any bit is
+// x, otherwise Z
+char xz_digit(uint64_t value, uint64_t xz_mask, uint64_t mask) {
+    if (xz_mask == mask) {
+        if (value == 0) return 'x';
+        if (value == mask) return 'z';
     }
-    return ss.str();
+    return (xz_mask & ~value) ? 'X' : 'Z';
 }
 
-std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, bool is_negative) {
-    char base;
-    uint64_t actual_size;
-    bool padding;
-    parse_fmt(fmt, size, base, actual_size, padding);
+// writes the padding and the sign of a field that ends with len characters of digits. returns
+// where the digits go, or nullptr if the field doesn't fit
+char* write_field(char* first, char* last, uint64_t len, bool is_negative, char pad,
+                  uint64_t actual_size, bool padding) {
+    auto const body = len + is_negative;
+    auto const width = padding ? std::max(body, actual_size + is_negative) : body;
+    if (static_cast<uint64_t>(last - first) < width) return nullptr;
+    auto* digits = first + width - len;
+    std::fill(first, digits - is_negative, pad);
+    if (is_negative) digits[-1] = '-';
+    return digits;
+}
 
-    // now print out the format
-    std::stringstream ss;
-    switch (base) {
-        case 'b':
-        case 'B': {
-            auto b = std::bitset<64>(value);
-            auto s = b.to_string().substr(64 - size);
-            // need to reverse it
-            std::reverse(s.begin(), s.end());
-            ss << s;
-            break;
-        }
-        case 'o':
-        case 'O':
-        case 'x':
-        case 'h':
-        case 'X':
-        case 'H': {
-            ss << format_value_2power(base, value);
-            break;
-        }
-        case 's':
-        case 'S':
-            for (auto i = 0u; i < size; i += 8) {
-                auto c = value >> (i * 8) & 0xFF;
-                ss << c;
+// digits [0, count) of a base 2^stride number, most significant first
+char* write_digits(char* out, uint64_t stride, uint64_t count, uint64_t size, const uint64_t* value,
+                   const uint64_t* xz_mask) {
+    for (auto i = count; i > 0;) {
+        if ((stride == 1 || stride == 4) && (i * stride) % 64 == 0 && i * stride <= size) {
+            // everything left is whole words
+            auto const& kernels = get_digit_kernels();
+            auto const words = i * stride / 64;
+            (stride == 1 ? kernels.format_bin : kernels.format_hex)(value, xz_mask, words, out);
+            return out + i;
+        }
+        // whole bytes of 2-state bits go through the tables
+        if (stride == 1 && i % 8 == 0) {
+            auto const lo = i - 8;
+            if (!xz_mask || !bits_at(xz_mask, size, lo, 8)) {
+                std::copy_n(binary_table[bits_at(value, size, lo, 8)].data(), 8, out);
+                out += 8;
+                i -= 8;
+                continue;
             }
-            break;
-        case 'd':
-        case 'D': {
-            if (value == 0) {
-                ss << 0;
-            } else {
-                while (value > 0) {
-                    auto r = value % 10;
-                    ss << r;
-                    value /= 10;
-                }
+        } else if (stride == 4 && i % 2 == 0 && i * 4 <= size) {
+            auto const lo = (i - 2) * 4;
+            if (!xz_mask || !bits_at(xz_mask, size, lo, 8)) {
+                std::copy_n(hex_table[bits_at(value, size, lo, 8)].data(), 2, out);
+                out += 2;
+                i -= 2;
+                continue;
             }
-            break;
         }
-        default:;
+        i--;
+        auto const pos = i * stride;
+        auto const bits = std::min(stride, size - pos);
+        auto const v = bits_at(value, size, pos, bits);
+        auto const xz = xz_mask ? bits_at(xz_mask, size, pos, bits) : 0;
+        *out++ = xz ? xz_digit(v, xz, tail_mask(bits)) : hex_digits[v];
     }
-    return pad_result(is_negative, base, actual_size, padding, ss);
-}
-
-uint64_t get_mask(uint64_t stride) { return std::numeric_limits<uint64_t>::max() >> (64 - stride); }
-
-std::string fmt_value(char base, uint64_t size, uint64_t value, uint64_t xz_mask) {
-    auto stride = get_stride(base);
-    const auto mask = get_mask(stride);
-    std::stringstream ss;
-    for (auto i = 0u; i < size; i += stride) {
-        auto v = (value >> i) & mask;
-        auto xz = (xz_mask >> i) & mask;
-        if (xz != 0) {
-            // need to see if it's all x or all z
-            if (xz == mask) {
-                if (v == 0) {
-                    ss << 'x';
-                } else if (v == mask) {
-                    ss << 'z';
-                } else {
-                    ss << 'X';
-                }
-            } else {
-                // need to check each one
-                // we have a mix. need to see if it contains x
-                bool has_x = false;
-                for (auto j = 0u; j < stride; j++) {
-                    auto bit = (v >> j) & 1;
-                    auto bit_xz = (xz >> j) & 1;
-                    if (bit_xz && !bit) {
-                        ss << 'X';
-                        has_x = true;
-                        break;
-                    }
-                }
-                if (!has_x) {
-                    ss << 'Z';
-                }
-            }
-        } else {
-            auto str = format_value_2power(base, v);
-            ss << str;
+    return out;
+}
+
+// digits needed by a base 2^stride number once the leading zeros are dropped
+uint64_t significant_digits(uint64_t stride, uint64_t size, const uint64_t* value,
+                            const uint64_t* xz_mask) {
+    auto const n = (size + 63) / 64;
+    for (auto i = n; i > 0; i--) {
+        auto const mask = i == n ? tail_mask(size) : ~0ull;
+        auto w = value[i - 1];
+        if (xz_mask) w |= xz_mask[i - 1];
+        w &= mask;
+        if (w) {
+            auto const highest = (i - 1) * 64 + 63 - static_cast<uint64_t>(__builtin_clzll(w));
+            return highest / stride + 1;
         }
     }
-    return ss.str();
-}
-
-std::string fmt_decimal(uint64_t size, uint64_t value, uint64_t xz_mask) {
-    if (xz_mask != 0) {
-        // need to test if all the bits are x/z
-        auto mask = std::numeric_limits<uint64_t>::max() >> (64 - size);
-        if (xz_mask == mask) {
-            // all x or zero
-            if (value == 0) {
-                return "x";
-            } else if (value == mask) {
-                return "z";
+    return 1;
+}
+
+char* format_decimal(char* first, char* last, uint64_t size, const uint64_t* value,
+                     const uint64_t* xz_mask, bool is_negative, uint64_t actual_size, bool padding,
+                     uint64_t* scratch) {
+    auto const n = (size + 63) / 64;
+    if (xz_mask) {
+        // the whole number is a single digit as soon as there is any x or z
+        bool all_xz = true, has_xz = false, has_x = false, all_zero = true, all_one = true;
+        for (auto i = 0u; i < n; i++) {
+            auto const mask = i == n - 1 ? tail_mask(size) : ~0ull;
+            auto const w = value[i] & mask;
+            auto const x = xz_mask[i] & mask;
+            all_xz = all_xz && x == mask;
+            has_xz = has_xz || x;
+            has_x = has_x || (x & ~w);
+            all_zero = all_zero && w == 0;
+            all_one = all_one && w == mask;
+        }
+        if (has_xz) {
+            char c;
+            if (all_xz && all_zero) {
+                c = 'x';
+            } else if (all_xz && all_one) {
+                c = 'z';
             } else {
-                return "X";
-            }
-        } else {
-            // some of them are actual digits
-            // need to check if it contains x or not
-            for (auto i = 0u; i < size; i++) {
-                auto v = (value >> i) & 1;
-                auto xz = (xz_mask >> i) & 1;
-                if (xz && !v) {
-                    return "X";
-                }
-            }
-            return "Z";
-        }
-    } else {
-        std::stringstream ss;
-        if (value == 0) {
-            ss << 0;
-        } else {
-            while (value > 0) {
-                auto r = value % 10;
-                ss << r;
-                value /= 10;
+                c = has_x ? 'X' : 'Z';
             }
+            auto* out = write_field(first, last, 1, false, ' ', actual_size, padding);
+            if (!out) return nullptr;
+            *out = c;
+            return out + 1;
         }
-        return ss.str();
     }
-}
 
-std::string fmt_char(uint64_t size, uint64_t value) {
-    std::stringstream ss;
-    auto num_chunk = static_cast<uint64_t>(std::ceil(static_cast<double>(size) / 8));
-    for (auto i = 0u; i < num_chunk; i++) {
-        auto c = static_cast<char>(static_cast<uint8_t>(value >> (8 * i) & 0xFF));
-        ss << c;
+    if (n == 1) {
+        char buf[20];
+        auto const r = std::to_chars(buf, buf + sizeof(buf), value[0] & tail_mask(size));
+        auto const len = static_cast<uint64_t>(r.ptr - buf);
+        auto* out = write_field(first, last, len, is_negative, ' ', actual_size, padding);
+        if (!out) return nullptr;
+        std::copy(buf, r.ptr, out);
+        return out + len;
     }
-    return ss.str();
+
+    // the zero padded digits are written to the scratch after the copy of the value and the
+    // division scratch, see format_scratch_words, then the significant ones are copied into place
+    auto const digits = decimal_digits(size);
+    auto* a = scratch;
+    std::copy(value, value + n, a);
+    a[n - 1] &= tail_mask(size);
+    auto* t = a + n;
+    auto* buffer = reinterpret_cast<char*>(t + 3 * n + 64);
+    auto* end = buffer + digits;
+    write_decimal(a, n, buffer, digits, t);
+    auto const* begin = std::find_if(buffer, end - 1, [](char c) { return c != '0'; });
+    auto const len = static_cast<uint64_t>(end - begin);
+    auto* out = write_field(first, last, len, is_negative, ' ', actual_size, padding);
+    if (!out) return nullptr;
+    std::copy_n(begin, len, out);
+    return out + len;
 }
 
-std::string to_string_(std::string_view fmt, uint64_t size, uint64_t value, uint64_t xz_mask,
-                       bool is_negative, bool use_padding) {
-    char base;
+char* format_words(char* first, char* last, format_spec spec, uint64_t size,
+                   const uint64_t* value, const uint64_t* xz_mask, bool is_negative,
+                   uint64_t* scratch) {
     uint64_t actual_size;
     bool padding;
-    parse_fmt(fmt, size, base, actual_size, padding);
-
-    std::stringstream ss;
+    parse_fmt(spec, size, actual_size, padding);
+    auto const base = spec.base;
 
-    // need to obey the rule of LRM 21.2.1.4
     switch (base) {
-        case 'b':
-        case 'B': {
-            for (auto i = 0u; i < size; i++) {
-                auto c = (value >> i) & 1;
-                auto xz = (xz_mask >> i) & 1;
-                if (xz == 0) {
-                    ss << c;
-                } else {
-                    ss << (c ? 'z' : 'x');
-                }
+        case 'd':
+        case 'D':
+            return format_decimal(first, last, size, value, xz_mask, is_negative, actual_size,
+                                  padding, scratch);
+        case 's':
+        case 'S': {
+            // the LRM does not specify the behavior if there is an x or z
+            auto const count = (size + 7) / 8;
+            auto* out = write_field(first, last, count, false, ' ', actual_size, padding);
+            if (!out) return nullptr;
+            for (auto i = count; i > 0; i--) {
+                *out++ = static_cast<char>(bits_at(value, size, (i - 1) * 8, 8));
             }
-            break;
+            return out;
         }
+        case 'c':
+        case 'C': {
+            // the low 8 bits as a character
+            auto* out = write_field(first, last, 1, false, ' ', actual_size, padding);
+            if (!out) return nullptr;
+            *out++ = static_cast<char>(bits_at(value, size, 0, std::min<uint64_t>(size, 8)));
+            return out;
+        }
+        case 'b':
+        case 'B':
         case 'o':
         case 'O':
         case 'h':
         case 'H':
         case 'x':
         case 'X': {
-            ss << fmt_value(base, size, value, xz_mask);
-            break;
-        }
-        // decimal is special
-        case 'd':
-        case 'D': {
-            ss << fmt_decimal(size, value, xz_mask);
-            break;
-        }
-        case 's':
-        case 'S': {
-            // the LRM does not specify the behavior if there is an x or z
-            ss << fmt_char(size, value);
-            break;
+            auto const stride = get_stride(base);
+            auto const count = padding ? (size + stride - 1) / stride
+                                       : significant_digits(stride, size, value, xz_mask);
+            auto* out = write_field(first, last, count, false, '0', actual_size, padding);
+            if (!out) return nullptr;
+            return write_digits(out, stride, count, size, value, xz_mask);
         }
         default:
-            break;
+            return first;
     }
+}
 
-    if (use_padding)
-        return pad_result(is_negative, base, actual_size, padding, ss);
-    else
-        return ss.str();
+uint64_t format_size(format_spec spec, uint64_t size) {
+    uint64_t actual_size;
+    bool padding;
+    parse_fmt(spec, size, actual_size, padding);
+    // room for the sign
+    return actual_size + 1;
 }
 
-std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, uint64_t xz_mask,
-                      bool is_negative) {
-    return to_string_(fmt, size, value, xz_mask, is_negative, true);
+uint64_t format_size(std::string_view fmt, uint64_t size) {
+    return format_size(parse_format_spec(fmt), size);
 }
 
-std::string to_string_(std::string_view fmt, uint64_t size, const uint64_t* value, bool is_negative,
-                       bool use_padding) {
-    char base;
-    uint64_t actual_size;
-    bool padding;
-    parse_fmt(fmt, size, base, actual_size, padding);
-
-    auto num_array = (size % 64 == 0) ? size / 64 : (size / 64 + 1);
-
-    std::stringstream ss;
-    if (base != 'd' && base != 'D') {
-        // notice that because in oct format, 3 is not a power of 2, we need to be extra careful
-        if (base == 'o' || base == 'O') {
-            auto num_chunks = static_cast<uint64_t>(std::ceil(static_cast<double>(size) / 3));
-            for (auto i = 0u; i < num_chunks; i++) {
-                auto start = i * 3;
-                auto value_idx = start / 64;
-                auto start_idx = start % 64;
-                // if it's across the 64-bit boundary
-                uint64_t v;
-                if ((64 - start_idx) < 3) {
-                    v = (value[value_idx] >> start_idx) & 0x7;
-                    v |= (value[value_idx + 1]) & (0x7 >> (64 - start_idx));
-                } else {
-                    v = (value[value_idx] >> start_idx) & 0x7;
-                }
-                auto s = to_string(fmt, 3, v, false);
-                ss << s;
-            }
-        } else {
-            for (auto i = 0u; i < num_array - 1; i++) {
-                ss << to_string(fmt, 64, value[i], false);
-            }
-            if (size % 64) {
-                ss << to_string(fmt, size % 64, value[num_array - 1], false);
-            }
-        }
-    } else {
-        // FIXME
-        // give up. display the least significant two parts
-        auto size_ = size > 128 ? 128 : size;
-        __uint128_t v = 0;
-        if (size_ > 64) {
-            v |= value[1];
-            v = v << 64;
-        }
-        v |= value[0];
-        auto q = v;
-        while (q != 0) {
-            auto r = q % 10;
-            ss << static_cast<uint64_t>(r);
-            q = q / 10;
-        }
-    }
+char* format_to(char* first, char* last, std::string_view fmt, uint64_t size, uint64_t value,
+                bool is_negative) {
+    return format_words(first, last, parse_format_spec(fmt), size, &value, nullptr, is_negative,
+                        nullptr);
+}
+
+char* format_to(char* first, char* last, std::string_view fmt, uint64_t size, uint64_t value,
+                uint64_t xz_mask, bool is_negative) {
+    return format_words(first, last, parse_format_spec(fmt), size, &value, &xz_mask, is_negative,
+                        nullptr);
+}
+
+char* format_to(char* first, char* last, std::string_view fmt, uint64_t size,
+                const uint64_t* value, bool is_negative, uint64_t* scratch) {
+    return format_words(first, last, parse_format_spec(fmt), size, value, nullptr, is_negative,
+                        scratch);
+}
 
-    if (use_padding)
-        return pad_result(is_negative, base, actual_size, padding, ss);
-    else
-        return ss.str();
+char* format_to(char* first, char* last, std::string_view fmt, uint64_t size,
+                const uint64_t* value, const uint64_t* xz_mask, bool is_negative,
+                uint64_t* scratch) {
+    return format_words(first, last, parse_format_spec(fmt), size, value, xz_mask, is_negative,
+                        scratch);
+}
+
+char* format_to(char* first, char* last, format_spec spec, uint64_t size, const uint64_t* value,
+                const uint64_t* xz_mask, bool is_negative, uint64_t* scratch) {
+    return format_words(first, last, spec, size, value, xz_mask, is_negative, scratch);
+}
+
+// the string versions are a single allocation on top of format_to, plus the scratch space of
+// wide values
+template <typename... Args>
+std::string format_string(std::string_view fmt, uint64_t size, Args... args) {
+    std::string result(format_size(fmt, size), '\0');
+    auto* end = format_to(result.data(), result.data() + result.size(), fmt, size, args...);
+    result.resize(static_cast<uint64_t>(end - result.data()));
+    return result;
+}
+
+std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, bool is_negative) {
+    return format_string(fmt, size, value, is_negative);
+}
+
+std::string to_string(std::string_view fmt, uint64_t size, uint64_t value, uint64_t xz_mask,
+                      bool is_negative) {
+    return format_string(fmt, size, value, xz_mask, is_negative);
 }
 
 std::string to_string(std::string_view fmt, uint64_t size, const uint64_t* value,
                       bool is_negative) {
-    return to_string_(fmt, size, value, is_negative, true);
+    std::vector<uint64_t> scratch(format_scratch_words(size));
+    return format_string(fmt, size, value, is_negative, scratch.data());
 }
 
 std::string to_string(std::string_view fmt, uint64_t size, const uint64_t* value,
                       const uint64_t* xz_mask, bool is_negative) {
-    char base;
-    uint64_t actual_size;
-    bool padding;
-    parse_fmt(fmt, size, base, actual_size, padding);
-
-    auto num_array = (size % 64 == 0) ? size / 64 : (size / 64 + 1);
-
-    std::stringstream ss;
-    if (base != 'd' && base != 'D') {
-        // notice that because in oct format, 3 is not a power of 2, we need to be extra careful
-        if (base == 'o' || base == 'O') {
-            auto num_chunks = static_cast<uint64_t>(std::ceil(static_cast<double>(size) / 3));
-            for (auto i = 0u; i < num_chunks; i++) {
-                auto start = i * 3;
-                auto value_idx = start / 64;
-                auto start_idx = start % 64;
-                // if it's across the 64-bit boundary
-                uint64_t v;
-                uint64_t xz;
-                if ((64 - start_idx) < 3) {
-                    v = (value[value_idx] >> start_idx) & 0x7;
-                    v |= (value[value_idx + 1]) & (0x7 >> (64 - start_idx));
-                    xz = (xz_mask[value_idx] >> start_idx) & 0x7;
-                    xz |= (xz_mask[value_idx + 1]) & (0x7 >> (64 - start_idx));
-                } else {
-                    v = (value[value_idx] >> start_idx) & 0x7;
-                    xz = (xz_mask[value_idx] >> start_idx) & 0x7;
-                }
-                auto s = to_string_(fmt, 3, v, xz, false, false);
-                ss << s;
-            }
-        } else {
-            for (auto i = 0u; i < num_array - 1; i++) {
-                ss << to_string_(fmt, 64, value[i], xz_mask[i], false, false);
-            }
-            if (size % 64) {
-                ss << to_string_(fmt, size % 64, value[num_array - 1], xz_mask[num_array - 1],
-                                 false, false);
-            }
-        }
-
-    } else {
-        // FIXME
-        // give up. display the least significant two parts
-        auto size_ = size > 128 ? 128 : size;
-        __uint128_t v = 0;
-        __uint128_t xz = 0;
-        if (size_ > 64) {
-            v |= value[1];
-            v = v << 64;
-            xz |= xz_mask[1];
-            xz = xz << 64;
-        }
-        v |= value[0];
-        xz |= xz_mask[0];
-        if (xz != 0) {
-            // contains x/z
-            if ((~xz) == 0) {
-                // all x or z
-                if (v == 0) {
-                    ss << 'x';
-                } else {
-                    if ((~v) == 0) {
-                        // all z
-                        ss << 'z';
-                    } else {
-                        ss << 'X';
-                    }
-                }
-            } else {
-                // has some real digits
-                bool has_x = false;
-                for (auto i = 0u; i < size_; i++) {
-                    auto x = (xz >> i) & 1;
-                    if (x) {
-                        auto vv = (v >> i) & 1;
-                        if (vv == 0) {
-                            has_x = true;
-                            break;
-                        }
-                    }
-                }
-                if (has_x)
-                    ss << "X";
-                else
-                    ss << "Z";
-            }
-        } else {
-            auto q = v;
-            while (q != 0) {
-                auto r = q % 10;
-                ss << static_cast<uint64_t>(r);
-                q = q / 10;
-            }
-        }
-    }
-
-    return pad_result(is_negative, base, actual_size, padding, ss);
+    std::vector<uint64_t> scratch(format_scratch_words(size));
+    return format_string(fmt, size, value, xz_mask, is_negative, scratch.data());
 }
 
-bool decimal_fmt(std::string_view fmt) {
-    auto base = get_output_base(fmt);
-    return base == 'd' || base == 'D';
-}
+bool decimal_fmt(std::string_view fmt) { return decimal_fmt(parse_format_spec(fmt)); }
 
 }  // namespace logic::util
\ No newline at end of file
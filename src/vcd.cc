@@ -0,0 +1,313 @@
+#include "logic/vcd.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#ifdef LOGIC_ZLIB
+#include <zlib.h>
+#endif
+
+namespace logic {
+
+// queued changes are blocks of words: a time marker is [time_tag, time], a change is
+// [signal index, value words..., xz words...] with xz words for 4-state signals only
+constexpr uint64_t time_tag = std::numeric_limits<uint64_t>::max();
+// a block is handed to the writer thread once it holds this many words
+constexpr uint64_t block_words = 1 << 16;
+// the simulation waits for the writer thread beyond this many queued blocks, to bound memory
+constexpr uint64_t max_pending_blocks = 16;
+constexpr uint64_t text_buffer_size = 1 << 20;
+
+struct vcd_writer::impl {
+    struct signal {
+        signal_ref value;
+        const void *xz_mask;
+        uint64_t words;
+        // offset of the value and xz words in the shadow copy
+        uint64_t shadow;
+        std::string id;
+        std::string name;
+        std::vector<std::string> scope;
+    };
+
+    std::FILE *file = nullptr;
+#ifdef LOGIC_ZLIB
+    gzFile gz = nullptr;
+#endif
+    std::string timescale;
+    std::vector<signal> signals;
+    std::vector<uint64_t> shadow;
+    bool started = false;
+    bool closed = false;
+
+    // simulation side
+    std::vector<uint64_t> block;
+    std::vector<uint64_t> sample;
+
+    // shared with the writer thread
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::deque<std::vector<uint64_t>> pending;
+    std::vector<std::vector<uint64_t>> free_blocks;
+    bool stop = false;
+    std::thread writer;
+
+    // writer side
+    std::string text;
+    std::vector<char> digits;
+
+    [[nodiscard]] bool ok() const {
+#ifdef LOGIC_ZLIB
+        if (gz) return true;
+#endif
+        return file != nullptr;
+    }
+
+    void write_out() {
+        if (text.empty()) return;
+#ifdef LOGIC_ZLIB
+        if (gz) {
+            gzwrite(gz, text.data(), static_cast<unsigned>(text.size()));
+            text.clear();
+            return;
+        }
+#endif
+        std::fwrite(text.data(), 1, text.size(), file);
+        text.clear();
+    }
+
+    // the header, with every signal in its scope
+    void write_header() {
+        text += "$timescale " + timescale + " $end\n";
+        std::vector<uint64_t> order(signals.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [this](auto a, auto b) { return signals[a].scope < signals[b].scope; });
+        std::vector<std::string> current;
+        for (auto i : order) {
+            auto const &s = signals[i];
+            auto common = 0u;
+            while (common < current.size() && common < s.scope.size() &&
+                   current[common] == s.scope[common]) {
+                common++;
+            }
+            for (auto j = current.size(); j > common; j--) text += "$upscope $end\n";
+            for (auto j = common; j < s.scope.size(); j++) {
+                text += "$scope module " + s.scope[j] + " $end\n";
+            }
+            current = s.scope;
+            text += "$var wire " + std::to_string(s.value.size) + " " + s.id + " " + s.name +
+                    " $end\n";
+        }
+        for (auto j = current.size(); j > 0; j--) text += "$upscope $end\n";
+        text += "$enddefinitions $end\n";
+    }
+
+    void write_change(const signal &s, const uint64_t *value, const uint64_t *xz_mask) {
+        auto const size = s.value.size;
+        if (size == 1) {
+            auto const v = value[0] & 1;
+            auto const xz = xz_mask ? xz_mask[0] & 1 : 0;
+            text += xz ? (v ? 'z' : 'x') : static_cast<char>('0' + v);
+        } else {
+            digits.resize(size + 1);
+            auto *end = util::format_to(digits.data(), digits.data() + digits.size(),
+                                        util::format_spec{'b', -1}, size, value, xz_mask, false,
+                                        nullptr);
+            // values are extended with their leading 0, x or z, LRM 21.7.2.1, while a leading 1
+            // is extended with 0
+            auto const *begin = digits.data();
+            while (end - begin > 1 && begin[0] == begin[1] && begin[0] != '1') begin++;
+            if (end - begin > 1 && begin[0] == '0' && begin[1] == '1') begin++;
+            text += 'b';
+            text.append(begin, static_cast<uint64_t>(end - begin));
+            text += ' ';
+        }
+        text += s.id;
+        text += '\n';
+    }
+
+    void write_block(const std::vector<uint64_t> &words) {
+        for (uint64_t i = 0; i < words.size();) {
+            if (words[i] == time_tag) {
+                text += '#';
+                text += std::to_string(words[i + 1]);
+                text += '\n';
+                i += 2;
+            } else {
+                auto const &s = signals[words[i]];
+                auto const *value = words.data() + i + 1;
+                auto const *xz_mask = s.xz_mask ? value + s.words : nullptr;
+                write_change(s, value, xz_mask);
+                i += 1 + s.words * (s.xz_mask ? 2 : 1);
+            }
+            if (text.size() >= text_buffer_size) write_out();
+        }
+    }
+
+    void run() {
+        text.reserve(text_buffer_size + 4096);
+        write_header();
+        while (true) {
+            std::vector<uint64_t> words;
+            {
+                std::unique_lock lock(mutex);
+                ready.wait(lock, [this] { return stop || !pending.empty(); });
+                if (pending.empty()) break;
+                words = std::move(pending.front());
+                pending.pop_front();
+            }
+            drained.notify_one();
+            write_block(words);
+            words.clear();
+            std::lock_guard lock(mutex);
+            free_blocks.emplace_back(std::move(words));
+        }
+        write_out();
+    }
+
+    // hands the current block to the writer thread
+    void submit() {
+        if (block.empty()) return;
+        std::unique_lock lock(mutex);
+        drained.wait(lock, [this] { return pending.size() < max_pending_blocks; });
+        pending.emplace_back(std::move(block));
+        if (free_blocks.empty()) {
+            block = {};
+            block.reserve(block_words * 2);
+        } else {
+            block = std::move(free_blocks.back());
+            free_blocks.pop_back();
+        }
+        lock.unlock();
+        ready.notify_one();
+    }
+
+    // the current words of a value or xz mask
+    static void read(const signal_ref &ref, const void *data, uint64_t words, uint64_t *out) {
+        auto load = [data]<typename T>(T v) {
+            std::memcpy(&v, data, sizeof(T));
+            return static_cast<uint64_t>(v);
+        };
+        if (ref.bytes) {
+            auto const v = ref.bytes == 1   ? load(uint8_t{})
+                           : ref.bytes == 2 ? load(uint16_t{})
+                           : ref.bytes == 4 ? load(uint32_t{})
+                                            : load(uint64_t{});
+            // signed holders are sign extended
+            out[0] = v & util::tail_mask(ref.size);
+        } else {
+            std::memcpy(out, data, words * sizeof(uint64_t));
+        }
+    }
+};
+
+vcd_writer::vcd_writer(const std::string &filename, std::string_view timescale, bool gzip)
+    : impl_(std::make_unique<impl>()) {
+    impl_->timescale = timescale;
+    if (gzip) {
+#ifdef LOGIC_ZLIB
+        impl_->gz = gzopen(filename.c_str(), "wb");
+#endif
+    } else {
+        impl_->file = std::fopen(filename.c_str(), "wb");
+    }
+    impl_->block.reserve(block_words * 2);
+}
+
+vcd_writer::~vcd_writer() { close(); }
+
+bool vcd_writer::ok() const { return impl_->ok(); }
+
+bool vcd_writer::gzip_supported() {
+#ifdef LOGIC_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void vcd_writer::add_signal(signal_ref value, const void *xz_mask, int msb, int lsb,
+                            std::string_view name, std::string_view scope) {
+    auto &signals = impl_->signals;
+    if (impl_->started) return;
+    impl::signal s;
+    s.value = value;
+    s.xz_mask = xz_mask;
+    s.words = (value.size + 63) / 64;
+    s.shadow = impl_->shadow.size();
+    impl_->shadow.resize(s.shadow + s.words * (xz_mask ? 2 : 1));
+    // identifiers are printable ASCII, in base 94
+    for (auto i = signals.size();; i /= 94) {
+        s.id += static_cast<char>('!' + i % 94);
+        if (i < 94) break;
+    }
+    s.name = name;
+    if (value.size > 1) s.name += " [" + std::to_string(msb) + ":" + std::to_string(lsb) + "]";
+    while (!scope.empty()) {
+        auto const dot = scope.find('.');
+        s.scope.emplace_back(scope.substr(0, dot));
+        scope = dot == std::string_view::npos ? std::string_view{} : scope.substr(dot + 1);
+    }
+    signals.emplace_back(std::move(s));
+}
+
+void vcd_writer::dump(uint64_t time) {
+    auto &d = *impl_;
+    if (d.closed || !d.ok()) return;
+    auto const first = !d.started;
+    if (first) {
+        d.started = true;
+        d.writer = std::thread([&d] { d.run(); });
+    }
+    auto const marker = d.block.size();
+    d.block.push_back(time_tag);
+    d.block.push_back(time);
+    for (uint64_t i = 0; i < d.signals.size(); i++) {
+        auto const &s = d.signals[i];
+        auto const total = s.words * (s.xz_mask ? 2 : 1);
+        d.sample.resize(total);
+        impl::read(s.value, s.value.data, s.words, d.sample.data());
+        if (s.xz_mask) impl::read(s.value, s.xz_mask, s.words, d.sample.data() + s.words);
+        auto *shadow = d.shadow.data() + s.shadow;
+        if (!first && std::equal(d.sample.begin(), d.sample.end(), shadow)) continue;
+        std::copy(d.sample.begin(), d.sample.end(), shadow);
+        d.block.push_back(i);
+        d.block.insert(d.block.end(), d.sample.begin(), d.sample.end());
+    }
+    // nothing changed, no need for the time either
+    if (d.block.size() == marker + 2) d.block.resize(marker);
+    if (d.block.size() >= block_words) d.submit();
+}
+
+void vcd_writer::close() {
+    auto &d = *impl_;
+    if (d.closed) return;
+    d.closed = true;
+    if (d.started) {
+        d.submit();
+        {
+            std::lock_guard lock(d.mutex);
+            d.stop = true;
+        }
+        d.ready.notify_one();
+        d.writer.join();
+    } else if (d.ok()) {
+        d.started = true;
+        d.write_header();
+        d.write_out();
+    }
+#ifdef LOGIC_ZLIB
+    if (d.gz) gzclose(d.gz);
+#endif
+    if (d.file) std::fclose(d.file);
+}
+
+}  // namespace logic
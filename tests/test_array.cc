@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
 #include <sstream>
 
 #include "gtest/gtest.h"
 #include "logic/array.hh"
+#include "logic/readmem.hh"
+#include "logic/sparse.hh"
 
 TEST(array, ctor) {  // NOLINT
     logic::packed_array<logic::logic<15, 0>, 3, 0> logic_array;
@@ -87,6 +93,56 @@ TEST(array, index) {  // NOLINT
         a = bit_array[idx];
         EXPECT_EQ(a.str(), "0000000000101010");
     }
+
+    {
+        // 13-bit elements straddle the words, and the array doesn't start at 0
+        using index = logic::logic<7, 0>;
+        logic::packed_array<logic::logic<12, 0>, 19, 4> logic_array;
+        for (auto i = 4; i <= 19; i++) {
+            logic_array.update(index(i), logic::logic<12, 0>(i * 100));
+        }
+        for (auto i = 4; i <= 19; i++) {
+            EXPECT_EQ(logic_array[index(i)].to_uint64(), i * 100u);
+        }
+        // the same bits as a constant slice
+        auto const s = logic_array.slice_array<9, 9>();
+        EXPECT_EQ(s.to_uint64(), 900u);
+
+        // out of range and x indices read x and don't write
+        auto const before = logic_array.str();
+        for (auto idx : {index(3), index(20), index(200), index("8'h1x")}) {
+            EXPECT_EQ(logic_array[idx].str(), std::string(13, 'x'));
+            logic_array.update(idx, logic::logic<12, 0>(0));
+        }
+        EXPECT_EQ(logic_array.str(), before);
+
+        // x and z in the written value
+        logic_array.update(index(5), logic::logic<12, 0>("13'b1_xz00_0000_0000"));
+        EXPECT_EQ(logic_array[index(5)].str(), "1xz0000000000");
+        EXPECT_EQ(logic_array[index(6)].to_uint64(), 600u);
+    }
+
+    {
+        // elements wider than a word, with a wide index
+        using index = logic::logic<99, 0>;
+        logic::packed_array<logic::bit<99, 0>, 3, 0> bit_array;
+        auto const v = logic::bit<99, 0>("100'hA_BCDE_F012_3456_789A_BCDE");
+        bit_array.update(index(2), v);
+        auto const a = bit_array[index(2)];
+        EXPECT_EQ(a, v);
+        EXPECT_EQ(bit_array[index(1)].to_uint64(), 0u);
+        EXPECT_EQ(bit_array[index("100'h1_0000_0000_0000_0002")].to_uint64(), 0u);
+        // x reads as 0 in a 2-state array
+        bit_array.update(index(3), logic::logic<99, 0>("100'hx1"));
+        EXPECT_EQ(bit_array[index(3)].to_uint64(), 1u);
+
+        // word aligned elements are copied
+        logic::packed_array<logic::logic<127, 0>, 2, 0> logic_array;
+        auto const w = logic::logic<127, 0>("128'h1234_5678_9ABC_DEF0_zzzz_0000_xxxx_1111");
+        logic_array.update(index(1), w);
+        EXPECT_EQ(logic_array[index(1)].str("h"), w.str("h"));
+        EXPECT_EQ(logic_array[index(2)].str("h"), std::string(32, 'x'));
+    }
 }
 
 TEST(unpacked_array, slice) {  // NOLINT
@@ -96,3 +152,194 @@ TEST(unpacked_array, slice) {  // NOLINT
     auto const &slice = logic_array[1];
     EXPECT_TRUE(slice == v);
 }
+
+TEST(unpacked_array, readmem) {  // NOLINT
+    auto const filename = (std::filesystem::temp_directory_path() / "logic_readmem.mem").string();
+    {
+        std::ofstream stream(filename);
+        stream << "// header comment\n"
+                  "dead_beef 1234\n"
+                  "@4 x0f0_z00? /* block\n"
+                  "comment */ 00000001\n"
+                  "@2 ff // trailing\n";
+    }
+    logic::unpacked_array<logic::logic<31, 0>, 0, 7> mem;
+    EXPECT_TRUE(logic::readmemh(filename, mem));
+    EXPECT_EQ(mem[0].str("h"), "deadbeef");
+    EXPECT_EQ(mem[1].str("h"), "00001234");
+    EXPECT_EQ(mem[2].str("h"), "000000ff");
+    EXPECT_EQ(mem[3].str("h"), "xxxxxxxx");
+    EXPECT_EQ(mem[4].str("h"), "x0f0z00z");
+    EXPECT_EQ(mem[5].str("h"), "00000001");
+
+    // x and z are 0 in a 2-state memory, and words out of range are dropped
+    logic::unpacked_array<logic::bit<31, 0>, 0, 4> bits;
+    EXPECT_TRUE(logic::readmemh(filename, bits, 1, 4));
+    EXPECT_EQ(bits[0].str("h"), "00000000");
+    EXPECT_EQ(bits[1].str("h"), "deadbeef");
+    EXPECT_EQ(bits[2].str("h"), "000000ff");
+    EXPECT_EQ(bits[4].str("h"), "00f00000");
+
+    // start > finish loads downwards, @address directives included
+    decltype(mem) down;
+    EXPECT_TRUE(logic::readmemh(filename, down, 7, 0));
+    EXPECT_EQ(down[7].str("h"), "deadbeef");
+    EXPECT_EQ(down[6].str("h"), "00001234");
+    EXPECT_EQ(down[4].str("h"), "x0f0z00z");
+    EXPECT_EQ(down[3].str("h"), "00000001");
+    EXPECT_EQ(down[2].str("h"), "000000ff");
+    EXPECT_EQ(down[5].str("h"), "xxxxxxxx");
+
+    EXPECT_FALSE(logic::readmemh(filename + ".missing", mem));
+
+    // addresses are hex digits and _ only
+    for (auto const *address : {"@1g", "@x", "@?", "@", "@1-"}) {
+        {
+            std::ofstream stream(filename);
+            stream << address << " 1\n";
+        }
+        EXPECT_FALSE(logic::readmemh(filename, mem)) << address;
+    }
+    {
+        std::ofstream stream(filename);
+        stream << "@A_f 1\n";
+    }
+    logic::unpacked_array<logic::logic<31, 0>, 0, 0xAF> wide;
+    EXPECT_TRUE(logic::readmemh(filename, wide));
+    EXPECT_EQ(wide[0xAF].str("h"), "00000001");
+    std::filesystem::remove(filename);
+}
+
+TEST(unpacked_array, writemem) {  // NOLINT
+    auto const filename =
+        (std::filesystem::temp_directory_path() / "logic_writemem.mem").string();
+    logic::unpacked_array<logic::logic<11, 0>, 3, 0> mem;
+    mem.update<0>(logic::logic<11, 0>("12'habc"));
+    mem.update<1>(logic::logic<11, 0>("12'b1010_xxxx_zzzz"));
+    mem.update<3>(logic::logic<11, 0>(7));
+    EXPECT_TRUE(logic::writememh(filename, mem));
+    {
+        std::ifstream stream(filename);
+        std::string content((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+        EXPECT_EQ(content, "abc\naxz\nxxx\n007\n");
+    }
+    decltype(mem) copy;
+    EXPECT_TRUE(logic::writememb(filename, mem));
+    EXPECT_TRUE(logic::readmemb(filename, copy));
+    for (auto i = 0; i < 4; i++) {
+        EXPECT_EQ(copy[i].str(), mem[i].str());
+    }
+    std::filesystem::remove(filename);
+}
+
+TEST(unpacked_array, readmem_parallel) {  // NOLINT
+    // split into chunks, with addresses that jump around
+    auto const filename =
+        (std::filesystem::temp_directory_path() / "logic_readmem_big.mem").string();
+    constexpr auto size = 1 << 17;
+    {
+        std::ofstream stream(filename);
+        for (auto i = 0; i < size; i++) {
+            if (i % 1000 == 0) stream << '@' << std::hex << i << '\n';
+            stream << logic::bit<63, 0>(i * 0x9E37'79B9ull).str("h") << '\n';
+        }
+    }
+    auto mem = std::make_unique<logic::unpacked_array<logic::logic<63, 0>, 0, size - 1>>();
+    EXPECT_TRUE(logic::readmemh(filename, *mem));
+
+    std::vector<uint64_t> words(size);
+    auto visit = [](void *p, uint64_t address, std::string_view digits) {
+        uint64_t v;
+        logic::util::parse_digits(digits, 'h', 64, &v, nullptr);
+        (*static_cast<std::vector<uint64_t> *>(p))[address] = v;
+    };
+    EXPECT_TRUE(logic::util::read_memory(filename, 0, visit, &words, 4));
+    for (auto i = 0; i < size; i++) {
+        EXPECT_EQ((*mem)[i].value.value, i * 0x9E37'79B9ull);
+        EXPECT_FALSE((*mem)[i].xz_mask.any_set());
+        EXPECT_EQ(words[i], i * 0x9E37'79B9ull);
+    }
+
+    // the same words loaded downwards. every chunk starts where the one before it stopped
+    {
+        std::ofstream stream(filename);
+        for (auto i = 0; i < size; i++) stream << std::hex << i << '\n';
+    }
+    EXPECT_TRUE(logic::util::read_memory(filename, size - 1, visit, &words, 4, true));
+    for (auto i = 0; i < size; i++) EXPECT_EQ(words[size - 1 - i], static_cast<uint64_t>(i));
+
+    // the last chunks go back over the words of the first ones, the last write has to win
+    {
+        std::ofstream stream(filename);
+        for (auto i = 0; i < size; i++) stream << std::hex << i << '\n';
+        stream << "@0\n";
+        for (auto i = 0; i < size; i++) stream << std::hex << i + 1 << '\n';
+    }
+    EXPECT_TRUE(logic::util::read_memory(filename, 0, visit, &words, 4));
+    for (auto i = 0; i < size; i++) EXPECT_EQ(words[i], static_cast<uint64_t>(i + 1));
+    std::filesystem::remove(filename);
+}
+
+TEST(sparse_memory, update) {  // NOLINT
+    // 2^32 64-bit words would be 32 GB
+    logic::sparse_memory<logic::logic<63, 0>, 32> mem;
+    EXPECT_EQ(mem.pages(), 0u);
+    EXPECT_EQ(mem[0xDEAD'BEEF].str("h"), std::string(16, 'x'));
+    EXPECT_EQ(mem.pages(), 0u);
+
+    mem.update(0xDEAD'BEEF, logic::logic<63, 0>(42));
+    mem.update<0xFFFF'FFFF>(logic::logic<63, 0>(1));
+    EXPECT_EQ(mem[0xDEAD'BEEF].to_uint64(), 42u);
+    EXPECT_EQ(mem[0xFFFF'FFFF].to_uint64(), 1u);
+    // the rest of the page is still x
+    EXPECT_EQ(mem[0xDEAD'BEEE].str("h"), std::string(16, 'x'));
+    EXPECT_EQ(mem.pages(), 2u);
+
+    // addresses past the end and x addresses
+    mem.update(1ull << 32, logic::logic<63, 0>(1));
+    EXPECT_EQ(mem[1ull << 32].str("h"), std::string(16, 'x'));
+    EXPECT_EQ(mem.pages(), 2u);
+    auto const addr = logic::logic<31, 0>(0xDEAD'BEEF);
+    EXPECT_EQ(mem[addr].to_uint64(), 42u);
+    auto const x_addr = logic::logic<31, 0>("32'hDEAD_BEEx");
+    EXPECT_EQ(mem[x_addr].str("h"), std::string(16, 'x'));
+    mem.update(logic::logic<31, 0>("32'hz"), logic::logic<63, 0>(0));
+    EXPECT_EQ(mem.pages(), 2u);
+    // wide addresses are out of range rather than truncated
+    auto const wide = logic::bit<99, 0>(0x10);
+    mem.update(wide, logic::logic<63, 0>(7));
+    EXPECT_EQ(mem[wide].to_uint64(), 7u);
+    auto const too_wide = logic::bit<99, 0>("100'h1_0000_0000_0000_0010");
+    EXPECT_EQ(mem[too_wide].str("h"), std::string(16, 'x'));
+
+    mem.clear();
+    EXPECT_EQ(mem.pages(), 0u);
+    EXPECT_EQ(mem[0xDEAD'BEEF].str("h"), std::string(16, 'x'));
+
+    // 2-state memories read 0
+    logic::sparse_memory<logic::bit<7, 0>, 24> bits;
+    EXPECT_EQ(bits[100].to_uint64(), 0u);
+}
+
+TEST(sparse_memory, for_each_page) {  // NOLINT
+    logic::sparse_memory<logic::logic<15, 0>, 40, 4> mem;
+    std::vector<uint64_t> addrs = {1ull << 39, 3, 0x12'3456'7890, 17, 4};
+    for (auto a : addrs) mem.update(a, logic::logic<15, 0>(a & 0xFFFF));
+    EXPECT_EQ(mem.pages(), 4u);
+
+    std::vector<uint64_t> bases, written;
+    mem.for_each_page([&](uint64_t base, auto const &page) {
+        bases.emplace_back(base);
+        for (uint64_t i = 0; i < page.size(); i++) {
+            if (!page[i].xz_mask.any_set()) {
+                written.emplace_back(base + i);
+                EXPECT_EQ(page[i].to_uint64(), (base + i) & 0xFFFF);
+            }
+        }
+    });
+    // in address order
+    EXPECT_EQ(bases, (std::vector<uint64_t>{0, 16, 0x12'3456'7890, 1ull << 39}));
+    std::sort(addrs.begin(), addrs.end());
+    EXPECT_EQ(written, addrs);
+}
@@ -0,0 +1,381 @@
+#include <random>
+
+#include "gtest/gtest.h"
+#include "logic/big_num.hh"
+#include "logic/bit.hh"
+#include "logic/modular.hh"
+
+template <uint64_t size>
+logic::big_num<size> random_big_num(std::mt19937_64 &rng) {
+    logic::big_num<size> result;
+    for (auto &v : result.values) v = rng();
+    result.mask_off();
+    return result;
+}
+
+// shift-and-add reference multiplication
+template <uint64_t size>
+logic::big_num<size> ref_multiply(const logic::big_num<size> &a, const logic::big_num<size> &b) {
+    logic::big_num<size> result;
+    for (auto i = 0u; i < size; i++) {
+        if (b[i]) result = result + (a << i);
+    }
+    return result;
+}
+
+template <uint64_t size>
+void test_multiply(std::mt19937_64 &rng) {
+    for (auto i = 0; i < 4; i++) {
+        auto a = random_big_num<size>(rng);
+        auto b = random_big_num<size>(rng);
+        auto c = a * b;
+        EXPECT_TRUE(c == ref_multiply(a, b));
+    }
+}
+
+// operands extended to twice their width, which take the full product path when balanced
+template <uint64_t size>
+void test_widening_multiply(std::mt19937_64 &rng) {
+    for (auto shift : {0ul, 64ul, size / 2}) {
+        auto a = random_big_num<size>(rng).template extend<2 * size>();
+        auto b = (random_big_num<size>(rng) >> shift).template extend<2 * size>();
+        EXPECT_TRUE(a * b == ref_multiply(a, b));
+        EXPECT_TRUE(b * a == ref_multiply(a, b));
+    }
+}
+
+TEST(big_num, multiply) {  // NOLINT
+    std::mt19937_64 rng(0);
+    // schoolbook
+    test_multiply<100>(rng);
+    test_multiply<1000>(rng);
+    test_multiply<2048 + 1>(rng);
+    test_multiply<4096 - 7>(rng);
+    // karatsuba based short product, including the odd splits
+    test_multiply<64 * logic::short_mul_threshold>(rng);
+    test_multiply<64 * logic::short_mul_threshold * 2 + 65>(rng);
+    // karatsuba full product
+    test_widening_multiply<64 * logic::karatsuba_threshold>(rng);
+    test_widening_multiply<64 * logic::karatsuba_threshold * 2 + 65>(rng);
+}
+
+TEST(big_num, multiply_one_word) {  // NOLINT
+    // the product of two words only keeps the low one
+    auto const a = logic::big_num<32>(0xFFFF'FFFFul);
+    EXPECT_EQ((a * a).values[0], 1u);
+    auto const b = logic::big_num<64>(0x1'0000'0003ul);
+    EXPECT_EQ((b * b).values[0], 0x6'0000'0009u);
+    auto const c = logic::big_num<64, true>(-3l);
+    EXPECT_TRUE(c * c == (logic::big_num<64, true>(9l)));
+    std::mt19937_64 rng(64);
+    test_multiply<32>(rng);
+    test_multiply<64>(rng);
+}
+
+TEST(big_num, multiply_karatsuba) {  // NOLINT
+    // full product against the schoolbook kernel
+    std::mt19937_64 rng(42);
+    for (auto n : {logic::karatsuba_threshold, logic::karatsuba_threshold * 2 + 1, 97ul}) {
+        std::vector<uint64_t> a(n), b(n), ref(2 * n), res(2 * n);
+        std::vector<uint64_t> scratch(logic::util::karatsuba_scratch_size(n));
+        for (auto i = 0u; i < n; i++) {
+            // all ones stresses the carry words
+            a[i] = i % 3 ? rng() : std::numeric_limits<uint64_t>::max();
+            b[i] = i % 5 ? rng() : std::numeric_limits<uint64_t>::max();
+        }
+        logic::util::mul_basecase(ref.data(), 2 * n, a.data(), n, b.data(), n);
+        logic::util::mul_karatsuba(res.data(), a.data(), b.data(), n, scratch.data());
+        EXPECT_EQ(ref, res);
+    }
+}
+
+template <uint64_t size>
+void test_div_mod(std::mt19937_64 &rng) {
+    for (auto divisor_words = 1u; divisor_words <= logic::big_num<size>::s; divisor_words++) {
+        auto a = random_big_num<size>(rng);
+        auto b = random_big_num<size>(rng);
+        for (auto i = divisor_words; i < b.s; i++) b.values[i] = 0;
+        // exercise the case where the divisor is already normalized
+        if (divisor_words % 2) b.values[divisor_words - 1] |= 1ull << 63;
+        b.mask_off();
+        if (!b.any_set()) continue;
+        auto [q, r] = a.div_mod(b);
+        EXPECT_TRUE(r < b);
+        EXPECT_TRUE(q * b + r == a);
+        EXPECT_TRUE(a / b == q);
+        EXPECT_TRUE(a % b == r);
+    }
+}
+
+TEST(big_num, div_mod) {  // NOLINT
+    std::mt19937_64 rng(0);
+    test_div_mod<100>(rng);
+    test_div_mod<1024>(rng);
+    test_div_mod<1000>(rng);
+
+    {
+        // q_hat overestimates, which requires the add back step
+        logic::big_num<192> a, b;
+        a.values = {0, 0, 0x8000000000000000};
+        b.values = {1, 0, 0x8000000000000000};
+        b = b >> 64;
+        b.values[1] = 0x8000000000000000;
+        auto [q, r] = a.div_mod(b);
+        EXPECT_TRUE(q * b + r == a);
+        EXPECT_TRUE(r < b);
+    }
+
+    {
+        // signed division truncates towards zero
+        using big_num = logic::big_num<128, true>;
+        auto a = big_num(-7l);
+        auto b = big_num(2l);
+        auto [q, r] = a.div_mod(b);
+        EXPECT_TRUE(q == big_num(-3l));
+        EXPECT_TRUE(r == big_num(-1l));
+        std::tie(q, r) = a.div_mod(-b);
+        EXPECT_TRUE(q == big_num(3l));
+        EXPECT_TRUE(r == big_num(-1l));
+    }
+
+    {
+        // divide by zero is zero
+        auto a = logic::big_num<128>(42ul);
+        auto [q, r] = a.div_mod(logic::big_num<128>(0ul));
+        EXPECT_FALSE(q.any_set());
+        EXPECT_FALSE(r.any_set());
+        // including when called directly, for a dividend that fits in a word and one that doesn't
+        auto const zero = logic::big_num<128>(0ul);
+        std::tie(q, r) = a.div_mod_unsigned(zero);
+        EXPECT_FALSE(q.any_set() || r.any_set());
+        std::tie(q, r) = (a << 100).div_mod_unsigned(zero);
+        EXPECT_FALSE(q.any_set() || r.any_set());
+        std::tie(q, r) = zero.div_mod_unsigned(zero);
+        EXPECT_FALSE(q.any_set() || r.any_set());
+    }
+}
+
+// modular multiplication through the double width product
+template <uint64_t size>
+logic::big_num<size> ref_mulmod(const logic::big_num<size> &a, const logic::big_num<size> &b,
+                                const logic::big_num<size> &m) {
+    auto product = a.template extend<size * 2>() * b.template extend<size * 2>();
+    return (product % m.template extend<size * 2>()).template slice<size - 1, 0>();
+}
+
+template <uint64_t size>
+logic::big_num<size> ref_powmod(const logic::big_num<size> &a, uint64_t e,
+                                const logic::big_num<size> &m) {
+    logic::big_num<size> result = logic::big_num<size>(1u) % m;
+    auto base = a % m;
+    for (; e; e >>= 1) {
+        if (e & 1) result = ref_mulmod(result, base, m);
+        base = ref_mulmod(base, base, m);
+    }
+    return result;
+}
+
+template <uint64_t size>
+void test_modular(std::mt19937_64 &rng) {
+    for (auto i = 0; i < 4; i++) {
+        auto a = random_big_num<size>(rng);
+        auto b = random_big_num<size>(rng);
+        auto m = random_big_num<size>(rng);
+        // short modulus and odd/even modulus
+        if (i == 1) m = m >> (size / 2);
+        m.values[0] |= 1;
+        if (i == 3) m.values[0] &= ~1ull;
+        auto ref = ref_mulmod(a, b, m);
+        EXPECT_TRUE(logic::mulmod(a, b, m) == ref);
+        EXPECT_TRUE(logic::barrett<size>(m).mulmod(a, b) == ref);
+        if (m.values[0] & 1) {
+            EXPECT_TRUE(logic::montgomery<size>(m).mulmod(a, b) == ref);
+        }
+        // exercise different window sizes
+        for (auto bits : {1u, 7u, 30u, 64u}) {
+            auto e = rng() >> (64 - bits);
+            auto res = logic::powmod(a, logic::big_num<64>(e), m);
+            EXPECT_TRUE(res == ref_powmod(a, e, m));
+        }
+    }
+}
+
+TEST(big_num, mulmod_powmod) {  // NOLINT
+    std::mt19937_64 rng(0);
+    test_modular<65>(rng);
+    test_modular<128>(rng);
+    test_modular<300>(rng);
+    test_modular<1024>(rng);
+    test_modular<64 * logic::karatsuba_threshold>(rng);
+}
+
+TEST(big_num, powmod_large_exponent) {  // NOLINT
+    // Fermat's little theorem with the prime 2^127 - 1: a^(p - 1) = 1 mod p
+    using big_num = logic::big_num<128>;
+    big_num p;
+    p.values = {std::numeric_limits<uint64_t>::max(), std::numeric_limits<uint64_t>::max() >> 1};
+    auto p_1 = p - big_num(1u);
+    logic::montgomery<128> ctx(p);
+    std::mt19937_64 rng(1);
+    for (auto i = 0; i < 4; i++) {
+        auto a = random_big_num<128>(rng) % p;
+        if (!a.any_set()) continue;
+        EXPECT_TRUE(ctx.powmod(a, p_1) == big_num(1u));
+        EXPECT_TRUE(logic::barrett<128>(p).powmod(a, p_1) == big_num(1u));
+        // a^p = a
+        EXPECT_TRUE(logic::powmod(a, p, p) == a);
+    }
+    // Montgomery form round trip
+    auto a = random_big_num<128>(rng) % p;
+    EXPECT_TRUE(ctx.from_montgomery(ctx.to_montgomery(a)) == a);
+}
+
+TEST(big_num, modular_edge_cases) {  // NOLINT
+    using big_num = logic::big_num<256>;
+    big_num a(12345u), zero, one(1u);
+    // zero modulus produces zero, the same as division
+    EXPECT_FALSE(logic::mulmod(a, a, zero).any_set());
+    EXPECT_FALSE(logic::powmod(a, a, zero).any_set());
+    // everything is 0 mod 1
+    EXPECT_FALSE(logic::powmod(a, zero, one).any_set());
+    EXPECT_FALSE(logic::powmod(a, a, one).any_set());
+    // a^0 = 1
+    EXPECT_TRUE(logic::powmod(a, zero, big_num(7u)) == one);
+    EXPECT_TRUE(logic::powmod(a, zero, big_num(8u)) == one);
+    EXPECT_FALSE(logic::montgomery<256>(big_num(8u)).valid());
+}
+
+TEST(big_num, modular_bit) {  // NOLINT
+    // native
+    logic::bit<31, 0> a(123456789u), m(1000000007u);
+    EXPECT_EQ(logic::mulmod(a, a, m).to_uint64(), 123456789ull * 123456789ull % 1000000007ull);
+    EXPECT_EQ(logic::powmod(a, logic::bit<7, 0>(3u), m).to_uint64(),
+              123456789ull * 123456789ull % 1000000007ull * 123456789ull % 1000000007ull);
+    // big number, with a native exponent
+    logic::bit<127, 0> b(123456789u), n(1000000007u);
+    EXPECT_EQ(logic::powmod(b, logic::bit<7, 0>(3u), n).to_uint64(),
+              123456789ull * 123456789ull % 1000000007ull * 123456789ull % 1000000007ull);
+    EXPECT_EQ(logic::mulmod(b, b, n).to_uint64(), 123456789ull * 123456789ull % 1000000007ull);
+}
+
+TEST(big_num, add_sub) {  // NOLINT
+    std::mt19937_64 rng(0);
+    using big_num = logic::big_num<300>;
+    for (auto i = 0; i < 16; i++) {
+        auto a = random_big_num<300>(rng);
+        auto b = random_big_num<300>(rng);
+        // long carry and borrow chains
+        if (i % 4 == 0) a.mask();
+        if (i % 4 == 1) b.unmask();
+        // word by word reference
+        big_num ref;
+        __uint128_t carry = 0;
+        for (auto j = 0u; j < big_num::s; j++) {
+            carry += static_cast<__uint128_t>(a.values[j]) + b.values[j];
+            ref.values[j] = static_cast<uint64_t>(carry);
+            carry >>= 64;
+        }
+        ref.mask_off();
+        EXPECT_TRUE(a + b == ref);
+        EXPECT_TRUE(ref - b == a);
+        EXPECT_TRUE(a - b == a + b.negate());
+        EXPECT_FALSE((a + a.negate()).any_set());
+
+        auto c = a;
+        c += b;
+        EXPECT_TRUE(c == ref);
+        c -= b;
+        EXPECT_TRUE(c == a);
+    }
+
+    big_num a;
+    a.mask();
+    ++a;
+    EXPECT_FALSE(a.any_set());
+    --a;
+    EXPECT_TRUE(a.all_set());
+    // mixed size, the shorter one gets sign extended
+    logic::big_num<100, true> b(-1l);
+    a.unmask();
+    a += b;
+    EXPECT_TRUE(a.all_set());
+}
+
+template <uint64_t size>
+void test_reduction(std::mt19937_64 &rng) {
+    logic::big_num<size> a;
+    a.mask();
+    EXPECT_TRUE(a.r_and());
+    EXPECT_EQ(a.popcount(), size);
+    EXPECT_EQ(a.r_xor(), size % 2 == 1);
+    // clear any single bit, including the top one
+    for (auto i : {0ul, size / 2, size - 1}) {
+        auto b = a;
+        b.set(i, false);
+        EXPECT_FALSE(b.r_and());
+        EXPECT_EQ(b.r_xor(), size % 2 == 0);
+    }
+    for (auto i = 0; i < 8; i++) {
+        auto b = random_big_num<size>(rng);
+        uint64_t count = 0;
+        for (auto j = 0u; j < size; j++) count += b[j];
+        EXPECT_EQ(b.popcount(), count);
+        EXPECT_EQ(b.r_xor(), count % 2 == 1);
+    }
+}
+
+TEST(big_num, reduction) {  // NOLINT
+    std::mt19937_64 rng(0);
+    test_reduction<65>(rng);
+    test_reduction<128>(rng);
+    test_reduction<1000>(rng);
+    test_reduction<64 * 1024>(rng);
+
+    // bit forwards to the big number
+    logic::bit<199, 0> a(0u);
+    a = ~a;
+    EXPECT_TRUE(a.r_and());
+    EXPECT_FALSE(a.r_xor());
+    // sign extended native holder
+    logic::bit<7, 0, true> b(-1);
+    EXPECT_TRUE(b.r_and());
+    EXPECT_EQ(b.popcount(), 8);
+    EXPECT_FALSE(b.r_xor());
+    logic::bit<4, 0, true> c(-1);
+    c.mask_off();
+    EXPECT_TRUE(c.r_and());
+    EXPECT_TRUE(c.r_xor());
+}
+
+template <uint64_t size, uint64_t a, uint64_t b>
+void test_slice(const logic::big_num<size> &v) {
+    auto s = v.template slice<a, b>();
+    auto r = v.template slice<a - b + 1>(b, a);
+    for (auto i = 0u; i <= a - b; i++) {
+        EXPECT_EQ(s[i], v[i + b]);
+        EXPECT_EQ(r[i], v[i + b]);
+    }
+}
+
+TEST(big_num, slice_concat) {  // NOLINT
+    std::mt19937_64 rng(0);
+    auto v = random_big_num<300>(rng);
+    test_slice<300, 63, 0>(v);
+    test_slice<300, 127, 64>(v);
+    test_slice<300, 130, 3>(v);
+    test_slice<300, 299, 1>(v);
+    test_slice<300, 299, 299>(v);
+    test_slice<300, 200, 137>(v);
+    // runtime slice past the end is 0
+    auto r = v.slice<100>(250, 349);
+    for (auto i = 0u; i < 100; i++) EXPECT_EQ(r[i], i < 50 && v[i + 250]);
+
+    auto w = random_big_num<77>(rng);
+    auto c = v.concat(w);
+    for (auto i = 0u; i < 377; i++) EXPECT_EQ(c[i], i < 77 ? w[i] : v[i - 77]);
+
+    logic::big_num<200> d;
+    d.mask();
+    logic::util::copy(d, v, 37, 150);
+    for (auto i = 0u; i < 200; i++) EXPECT_EQ(d[i], i <= 113 ? v[i + 37] : true);
+}
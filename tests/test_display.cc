@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+#include "logic/display.hh"
+
+using namespace logic::literals;
+
+TEST(display, compile) {  // NOLINT
+    using fmt = logic::static_display_format<"a: %0h, b: %d%%">;
+    static_assert(fmt::arg_count() == 2);
+    static_assert(fmt::items.size() == 5);
+    EXPECT_EQ(fmt::items[0].length, 3);
+    EXPECT_EQ(fmt::items[1].spec.base, 'h');
+    EXPECT_EQ(fmt::items[1].spec.width, 0);
+    EXPECT_EQ(fmt::items[3].spec.width, -1);
+
+    logic::display_format runtime("%5d %m");
+    EXPECT_EQ(runtime.arg_count(), 1);
+}
+
+TEST(display, format) {  // NOLINT
+    auto a = logic::logic<15, 0>(0x1F);
+    auto b = logic::bit<7, 0, true>(-5);
+    EXPECT_EQ((logic::sformatf<"a=%0h b=%d">(a, b)), "a=1f b=  -5");
+    EXPECT_EQ((logic::sformatf<"%h|%b|%o">(a, "4'b10x1"_logic, "6'o17"_bit)), "001f|10x1|17");
+    EXPECT_EQ((logic::sformatf<"%0d%%">(42)), "42%");
+    EXPECT_EQ((logic::sformatf<"%s!">(logic::bit<15, 0>(0x6869))), "hi!");
+    EXPECT_EQ((logic::sformatf<"[%c][%4s]">(logic::bit<7, 0>('A'), "ab")), "[A][  ab]");
+    EXPECT_EQ((logic::sformatf<"%t">(logic::bit<3, 0>(7))), " 7");
+
+    // the x/z rules are the same as str()
+    auto x = logic::logic<127, 0>("128'h1234_5678_9abc_def0_xxxx_zzzz_0123_z56x");
+    EXPECT_EQ((logic::sformatf<"%h %d">(x, x)), x.str("h") + " " + x.str("d"));
+
+    logic::display_format fmt("value: %0h, %0b\n");
+    EXPECT_EQ(fmt.format(a, "3'b1z0"_logic), "value: 1f, 1z0\n");
+    EXPECT_EQ(fmt.format(std::make_tuple(logic::bit<3, 0>(9), logic::bit<1, 0>(2))),
+              "value: 9, 10\n");
+    // missing arguments print nothing, extra ones are dropped
+    EXPECT_EQ(fmt.format(a), "value: 1f, \n");
+    EXPECT_EQ(fmt.format(a, a, a), "value: 1f, 11111\n");
+}
+
+TEST(display, format_to) {  // NOLINT
+    std::array<char, 16> buffer;
+    auto v = logic::logic<31, 0>(0xdead'beef);
+    auto *end = logic::sformatf_to<"<%h>">(buffer.begin(), buffer.end(), v);
+    ASSERT_NE(end, nullptr);
+    EXPECT_EQ(std::string_view(buffer.data(), end - buffer.data()), "<deadbeef>");
+    // too small
+    EXPECT_EQ((logic::sformatf_to<"<%b>">(buffer.begin(), buffer.end(), v)), nullptr);
+}
@@ -0,0 +1,214 @@
+#include <random>
+
+#include "gtest/gtest.h"
+#include "logic/interleaved.hh"
+
+// 0, 1, x and z in the 4-state truth tables of LRM 11.4.8
+constexpr std::string_view states = "01xz";
+
+char and_bit(char a, char b) {
+    if (a == '0' || b == '0') return '0';
+    return a == '1' && b == '1' ? '1' : 'x';
+}
+
+char or_bit(char a, char b) {
+    if (a == '1' || b == '1') return '1';
+    return a == '0' && b == '0' ? '0' : 'x';
+}
+
+char xor_bit(char a, char b) {
+    if (a > '1' || b > '1') return 'x';
+    return a == b ? '0' : '1';
+}
+
+template <int size>
+std::string random_digits(std::mt19937 &rng) {
+    std::string result(size, '0');
+    for (auto &c : result) c = states[rng() % states.size()];
+    return result;
+}
+
+template <int size>
+void check_bitwise() {
+    std::mt19937 rng(size);
+    auto const a_digits = random_digits<size>(rng);
+    auto const b_digits = random_digits<size>(rng);
+    logic::interleaved_logic<size - 1, 0> a(std::to_string(size) + "'b" + a_digits);
+    logic::interleaved_logic<size - 1, 0> b(std::to_string(size) + "'b" + b_digits);
+    EXPECT_EQ(a.str(), a_digits);
+
+    std::string and_, or_, xor_, not_;
+    for (auto i = 0u; i < size; i++) {
+        and_ += and_bit(a_digits[i], b_digits[i]);
+        or_ += or_bit(a_digits[i], b_digits[i]);
+        xor_ += xor_bit(a_digits[i], b_digits[i]);
+        not_ += xor_bit(a_digits[i], '1');
+    }
+    EXPECT_EQ((a & b).str(), and_);
+    EXPECT_EQ((a | b).str(), or_);
+    EXPECT_EQ((a ^ b).str(), xor_);
+    EXPECT_EQ((~a).str(), not_);
+}
+
+TEST(interleaved, bitwise) {  // NOLINT
+    check_bitwise<1>();
+    check_bitwise<13>();
+    check_bitwise<64>();
+    check_bitwise<100>();
+    check_bitwise<1000>();
+}
+
+TEST(interleaved, layout) {  // NOLINT
+    // word pairs in the VPI aval/bval encoding
+    logic::interleaved_logic<67, 0> a("68'b0xz10");
+    EXPECT_EQ(sizeof(a), 2 * 2 * sizeof(uint64_t));
+    EXPECT_EQ(a.values[0].aval, 0b1010u);
+    EXPECT_EQ(a.values[0].bval, 0b1100u);
+    EXPECT_EQ(a.values[1].aval, 0u);
+    EXPECT_EQ(a.values[1].bval, 0u);
+
+    // round trips through logic
+    auto l = logic::logic<67, 0>("68'hz_1234_5678_9abc_def0_xxxx");
+    EXPECT_TRUE(logic::interleaved(l).to_logic().match(l));
+    logic::interleaved_logic<11, 0, true> s(-42);
+    EXPECT_EQ(s.str("d"), "  -42");
+    EXPECT_EQ(s.values[0].aval, 0xFD6u);
+
+    // everything is x by default
+    logic::interleaved_logic<99, 0> x;
+    EXPECT_EQ(x.str("h"), std::string(25, 'x'));
+}
+
+TEST(interleaved, bits) {  // NOLINT
+    logic::interleaved_logic<69, 0> a(0);
+    a.set(0, true);
+    a.set(65, logic::logic<0>::x_());
+    a.set(69, logic::logic<0>("1'bz"));
+    EXPECT_EQ(a[0].str(), "1");
+    EXPECT_EQ(a[1].str(), "0");
+    EXPECT_EQ(a[65].str(), "x");
+    EXPECT_EQ(a[69].str(), "z");
+    EXPECT_EQ(a[70].str(), "x");
+    a.set(65, false);
+    EXPECT_EQ(a[65].str(), "0");
+
+    // little endian ranges index the same way as logic
+    logic::interleaved_logic<0, 3> b("4'b1000");
+    EXPECT_EQ(b[0].str(), "1");
+    EXPECT_EQ(b[3].str(), "0");
+}
+
+TEST(interleaved, reduction) {  // NOLINT
+    auto const ones = ~logic::interleaved_logic<129, 0>(0);
+    EXPECT_EQ(ones.r_and().str(), "1");
+    EXPECT_EQ(ones.r_or().str(), "1");
+    EXPECT_EQ(ones.r_xor().str(), "0");
+    auto a = ones;
+    a.set(128, logic::logic<0>::x_());
+    EXPECT_EQ(a.r_and().str(), "x");
+    EXPECT_EQ(a.r_or().str(), "1");
+    EXPECT_EQ(a.r_xor().str(), "x");
+    a.set(3, false);
+    EXPECT_EQ(a.r_and().str(), "0");
+
+    logic::interleaved_logic<129, 0> b(0);
+    EXPECT_EQ(b.r_or().str(), "0");
+    EXPECT_FALSE(static_cast<bool>(b));
+    EXPECT_EQ((!b).str(), "1");
+    b.set(100, logic::logic<0>("1'bz"));
+    EXPECT_EQ(b.r_or().str(), "x");
+    EXPECT_EQ((!b).str(), "x");
+}
+
+TEST(interleaved, compare) {  // NOLINT
+    logic::interleaved_logic<99, 0> a(42), b(42), c(43);
+    EXPECT_EQ((a == b).str(), "1");
+    EXPECT_EQ((a != c).str(), "1");
+    EXPECT_TRUE(a.match(b));
+    b.set(99, logic::logic<0>::x_());
+    EXPECT_EQ((a == b).str(), "x");
+    EXPECT_FALSE(a.match(b));
+    EXPECT_EQ((a < c).str(), "1");
+    EXPECT_EQ((a >= c).str(), "0");
+    EXPECT_EQ((a < b).str(), "x");
+
+    // comparisons are logic<0> for any width or layout, the same as logic
+    logic::interleaved_logic<7, 0> d(42);
+    logic::logic<99, 0> l(42);
+    static_assert(std::is_same_v<decltype(a == b), logic::logic<0>>);
+    static_assert(std::is_same_v<decltype(a == d), logic::logic<0>>);
+    static_assert(std::is_same_v<decltype(a < c), logic::logic<0>>);
+    static_assert(std::is_same_v<decltype(l != a), logic::logic<0>>);
+    EXPECT_EQ((a == d).str(), "1");
+    EXPECT_EQ((c != d).str(), "1");
+    EXPECT_EQ((l == a).str(), "1");
+    EXPECT_EQ((l <= a).str(), "1");
+    EXPECT_EQ((c > l).str(), "1");
+}
+
+TEST(interleaved, arithmetic) {  // NOLINT
+    // everything else goes through logic and has the same result types
+    logic::interleaved_logic<99, 0> a(1000), b(24);
+    logic::interleaved_logic<7, 0> c(2);
+    EXPECT_EQ((a + b).str("d"), (a.to_logic() + b.to_logic()).str("d"));
+    EXPECT_EQ((a - b).to_logic().to_uint64(), 976u);
+    EXPECT_EQ((a * c).to_logic().to_uint64(), 2000u);
+    EXPECT_EQ((a / b).to_logic().to_uint64(), 41u);
+    EXPECT_EQ((a % b).to_logic().to_uint64(), 16u);
+    EXPECT_EQ((a << c).to_logic().to_uint64(), 4000u);
+    EXPECT_EQ((a >> c).to_logic().to_uint64(), 250u);
+    EXPECT_EQ((a & c).to_logic().to_uint64(), 0u);
+    b.set(0, logic::logic<0>::x_());
+    EXPECT_EQ((a + b).str("h"), std::string(25, 'x'));
+
+    // compound assignment keeps the type
+    a |= ~b;
+    EXPECT_EQ(a.str().back(), 'x');
+    a.fill_x();
+    EXPECT_TRUE(a.any_xz());
+}
+
+TEST(interleaved, mixed_operands) {  // NOLINT
+    logic::interleaved_logic<99, 0> a("100'b1x0z");
+    logic::logic<99, 0> l("100'b1100");
+    logic::bit<99, 0> b(6);
+
+    // logic and bit operands on either side, results stay interleaved
+    auto r = a & l;
+    static_assert(std::is_same_v<decltype(r), logic::interleaved_logic<99, 0>>);
+    EXPECT_EQ((r.to_logic().slice<3, 0>().str()), "1x00");
+    EXPECT_EQ(((l | a).to_logic().slice<3, 0>().str()), "110x");
+    EXPECT_EQ(((a ^ b).to_logic().slice<3, 0>().str()), "1x1x");
+    EXPECT_EQ((a + l).str("h"), (a.to_logic() + l).str("h"));
+
+    // integer operands
+    logic::interleaved_logic<7, 0> c(0b1010);
+    EXPECT_EQ((c & 0b0110).to_logic().to_uint64(), 0b0010u);
+    EXPECT_EQ((0b0101 | c).to_logic().to_uint64(), 0b1111u);
+    EXPECT_EQ((c ^ 0xFF).to_logic().to_uint64(), 0xF5u);
+    EXPECT_EQ((c << 3).to_logic().to_uint64(), 0b1010000u);
+    EXPECT_EQ((c >> 1u).to_logic().to_uint64(), 0b101u);
+    auto wide = logic::interleaved_logic<99, 0>(1) << 70;
+    EXPECT_EQ((wide.slice<71, 69>().str()), "010");
+
+    // unary operators
+    EXPECT_EQ((-c).to_logic().to_uint64(), 0xF6u);
+    EXPECT_EQ((+c).to_logic().to_uint64(), 0b1010u);
+    EXPECT_EQ((!c).str(), "0");
+    EXPECT_EQ((-a).str("h"), std::string(25, 'x'));
+}
+
+TEST(interleaved, slice_concat) {  // NOLINT
+    logic::interleaved_logic<99, 0> a("100'b1x0z");
+    auto s = a.slice<3, 1>();
+    static_assert(std::is_same_v<decltype(s), logic::interleaved_logic<2, 0>>);
+    EXPECT_EQ(s.str(), "1x0");
+    EXPECT_EQ(a.slice<4>(3, 0).str(), "1x0z");
+    EXPECT_EQ(a.slice<4>(98, 95).str(), "0000");
+
+    // operands in either layout
+    logic::interleaved_logic<1, 0> b("2'bz1");
+    auto c = b.concat(logic::logic<1, 0>("2'b0x"), logic::bit<1, 0>(2), s);
+    static_assert(std::is_same_v<decltype(c), logic::interleaved_logic<8, 0>>);
+    EXPECT_EQ(c.str(), "z10x101x0");
+}
@@ -0,0 +1,174 @@
+#include <random>
+
+#include "gtest/gtest.h"
+#include "logic/lanes.hh"
+
+// every lane is checked against its own scalar evaluation
+
+// 0, 1, x and z in the 4-state truth tables of LRM 11.4.8
+constexpr std::string_view states = "01xz";
+
+char and_bit(char a, char b) {
+    if (a == '0' || b == '0') return '0';
+    return a == '1' && b == '1' ? '1' : 'x';
+}
+
+char or_bit(char a, char b) {
+    if (a == '1' || b == '1') return '1';
+    return a == '0' && b == '0' ? '0' : 'x';
+}
+
+char xor_bit(char a, char b) {
+    if (a > '1' || b > '1') return 'x';
+    return a == b ? '0' : '1';
+}
+
+TEST(lanes, single) {  // NOLINT
+    // not a multiple of 64, so the last word is partial
+    logic::lanes<100> a;
+    EXPECT_FALSE(a.any());
+    a.set(0, true);
+    a.set(99, true);
+    EXPECT_TRUE(a[0]);
+    EXPECT_TRUE(a[99]);
+    EXPECT_FALSE(a[50]);
+    EXPECT_EQ(a.count(), 2u);
+
+    auto const b = ~a;
+    EXPECT_EQ(b.count(), 98u);
+    EXPECT_EQ(b.values[1] >> 36, 0u);
+    EXPECT_TRUE((a | b).all());
+    EXPECT_FALSE((a & b).any());
+    EXPECT_EQ(a ^ b, logic::lanes<100>(true));
+    EXPECT_EQ(a.and_not(b), b);
+
+    auto const sel = logic::lanes<100>(true);
+    EXPECT_EQ(logic::mux(sel, a, b), a);
+    EXPECT_EQ(logic::mux(~sel, a, b), b);
+}
+
+template <uint64_t L>
+void check_bit_lanes() {
+    constexpr auto size = 13;
+    using value = logic::bit<size - 1, 0>;
+    std::mt19937 rng(L);
+    logic::bit_lanes<size, L> a, b;
+    logic::lanes<L> sel;
+    for (uint64_t l = 0; l < L; l++) {
+        a.set_lane(l, value(rng() % (1 << size)));
+        // some lanes equal
+        b.set_lane(l, l % 4 ? value(rng() % (1 << size)) : a.lane(l));
+        sel.set(l, rng() & 1);
+    }
+    auto const and_ = a & b, or_ = a | b, xor_ = a ^ b, not_ = ~a;
+    auto const mux = logic::mux(sel, a, b);
+    auto const eq = a.eq(b);
+    auto const r_and = (a | b).r_and(), r_or = a.r_or(), r_xor = a.r_xor();
+    for (uint64_t l = 0; l < L; l++) {
+        auto const x = a.lane(l), y = b.lane(l);
+        EXPECT_EQ(and_.lane(l), x & y);
+        EXPECT_EQ(or_.lane(l), x | y);
+        EXPECT_EQ(xor_.lane(l), x ^ y);
+        // ~ leaves the unused bits of a native value set, so compare the digits
+        EXPECT_EQ(not_.lane(l).str(), (~x).str());
+        EXPECT_EQ(mux.lane(l), sel[l] ? x : y);
+        EXPECT_EQ(eq[l], x == y);
+        EXPECT_EQ(r_and[l], (x | y).r_and());
+        EXPECT_EQ(r_or[l], x.r_or());
+        EXPECT_EQ(r_xor[l], x.r_xor());
+    }
+}
+
+TEST(lanes, bit) {  // NOLINT
+    check_bit_lanes<64>();
+    check_bit_lanes<100>();
+    check_bit_lanes<512>();
+
+    // the same value in every lane
+    auto const v = logic::bit<7, 0>(0xA5);
+    logic::bit_lanes<8, 256> a(v);
+    EXPECT_EQ(a.lane(0), v);
+    EXPECT_EQ(a.lane(255), v);
+    EXPECT_TRUE(a[0].all());
+    EXPECT_FALSE(a[1].any());
+}
+
+template <uint64_t L>
+void check_logic_lanes() {
+    constexpr auto size = 5;
+    std::mt19937 rng(L);
+    auto random_digits = [&rng](uint64_t n) {
+        std::string result(n, '0');
+        for (auto &c : result) c = states[rng() % states.size()];
+        return result;
+    };
+    auto literal = [](std::string const &digits) {
+        return std::to_string(digits.size()).append("'b").append(digits);
+    };
+
+    logic::logic_lanes<size, L> a, b;
+    logic::logic_lanes<1, L> sel;
+    std::vector<std::string> a_digits, b_digits, sel_digits;
+    for (uint64_t l = 0; l < L; l++) {
+        a_digits.emplace_back(random_digits(size));
+        // mostly known bits, so that == and the reductions aren't x everywhere
+        b_digits.emplace_back(l % 2 ? random_digits(size) : a_digits.back());
+        for (auto &c : b_digits.back()) c = c > '1' && l % 3 ? '1' : c;
+        sel_digits.emplace_back(random_digits(1));
+        a.set_lane(l, logic::logic<size - 1, 0>(literal(a_digits.back())));
+        b.set_lane(l, logic::logic<size - 1, 0>(literal(b_digits.back())));
+        sel.set_lane(l, logic::logic<0>(literal(sel_digits.back())));
+    }
+    auto const and_ = a & b, or_ = a | b, xor_ = a ^ b, not_ = ~a;
+    auto const mux = logic::mux(sel, a, b);
+    auto const eq = a.eq(b);
+    auto const match = a.match(b);
+    auto const r_and = b.r_and(), r_or = b.r_or(), r_xor = b.r_xor();
+    for (uint64_t l = 0; l < L; l++) {
+        auto const &x = a_digits[l], &y = b_digits[l];
+        EXPECT_EQ(a.lane(l).str(), x);
+        std::string and_str, or_str, xor_str, not_str, mux_str;
+        char and_r = '1', or_r = '0', xor_r = '0';
+        bool known = true;
+        for (auto i = 0; i < size; i++) {
+            and_str += and_bit(x[i], y[i]);
+            or_str += or_bit(x[i], y[i]);
+            xor_str += xor_bit(x[i], y[i]);
+            not_str += xor_bit(x[i], '1');
+            // an x or z select keeps the bits both sides agree on
+            auto const s = sel_digits[l][0];
+            auto const agree = x[i] == y[i] && x[i] <= '1' ? x[i] : 'x';
+            mux_str += s == '1' ? x[i] : s == '0' ? y[i] : agree;
+            and_r = and_bit(and_r, y[i]);
+            or_r = or_bit(or_r, y[i]);
+            xor_r = xor_bit(xor_r, y[i]);
+            known = known && x[i] <= '1' && y[i] <= '1';
+        }
+        EXPECT_EQ(and_.lane(l).str(), and_str);
+        EXPECT_EQ(or_.lane(l).str(), or_str);
+        EXPECT_EQ(xor_.lane(l).str(), xor_str);
+        EXPECT_EQ(not_.lane(l).str(), not_str);
+        EXPECT_EQ(mux.lane(l).str(), mux_str);
+        EXPECT_EQ(eq.lane(l).str(), known ? (x == y ? "1" : "0") : "x");
+        EXPECT_EQ(match[l], x == y);
+        EXPECT_EQ(r_and.lane(l).str(), std::string(1, and_r));
+        EXPECT_EQ(r_or.lane(l).str(), std::string(1, or_r));
+        EXPECT_EQ(r_xor.lane(l).str(), std::string(1, xor_r));
+    }
+}
+
+TEST(lanes, logic) {  // NOLINT
+    check_logic_lanes<64>();
+    check_logic_lanes<100>();
+    check_logic_lanes<256>();
+
+    // x by default
+    logic::logic_lanes<3, 64> x;
+    EXPECT_EQ(x.lane(10).str(), "xxx");
+    EXPECT_TRUE(x.xz().all());
+    logic::logic_lanes<3, 64> a(logic::logic<2, 0>("3'b1z0"));
+    EXPECT_EQ(a.lane(63).str(), "1z0");
+    logic::logic_lanes<3, 64> b(logic::bit_lanes<3, 64>(logic::bit<2, 0>(5)));
+    EXPECT_EQ(b.lane(0).str(), "101");
+    EXPECT_FALSE(b.xz().any());
+}
@@ -1,8 +1,26 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <random>
 #include <sstream>
 
 #include "gtest/gtest.h"
 #include "logic/logic.hh"
 
+// counts heap allocations, to check that format_to doesn't allocate
+std::atomic<uint64_t> allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    if (auto *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
 TEST(logic, size) {  // NOLINT
     EXPECT_EQ(sizeof(logic::logic<4 - 1, 0>), 1 * 2);
     EXPECT_EQ(sizeof(logic::logic<8 - 1, 0>), 1 * 2);
@@ -46,7 +64,8 @@ TEST(logic, init) {  // NOLINT
         logic::logic<40 - 1, 0> l(v);
         auto s = l.str();
         std::stringstream ss;
-        for (auto i = 0u; i < 40u - v.size() + 2; i++) ss << '0';
+        // the leftmost x pads the unsized literal, LRM 5.7.1
+        for (auto i = 0u; i < 40u - v.size() + 2; i++) ss << 'x';
         ss << "xx1010";
         EXPECT_EQ(s, ss.str());
     }
@@ -58,7 +77,8 @@ TEST(logic, init) {  // NOLINT
         logic::logic<128 - 1, 0> l(v);
         auto s = l.str();
         std::stringstream ss;
-        for (auto i = 0u; i < 128u - v.size() + 2; i++) ss << '0';
+        // the leftmost x pads the unsized literal, LRM 5.7.1
+        for (auto i = 0u; i < 128u - v.size() + 2; i++) ss << 'x';
         ss << "xx1010";
         EXPECT_EQ(s, ss.str());
     }
@@ -124,6 +144,61 @@ TEST(logic, literal) {  // NOLINT
         auto v = 42_logic;
         EXPECT_EQ(v.value.value, 42ul);
     }
+    {
+        // width, signedness and value all come from the literal at compile time
+        constexpr auto v = "4'b10xz"_logic;
+        static_assert(v.size == 4 && !v.is_signed);
+        EXPECT_EQ(v.str(), "10xz");
+        constexpr auto b = "8'shF0"_bit;
+        static_assert(b.size == 8 && b.is_signed);
+        EXPECT_EQ(b.value, -16);
+        EXPECT_EQ("4'sb1000"_bit.value, -8);
+        EXPECT_EQ("'d42"_logic.size, 32);
+        EXPECT_EQ("6'o7_7"_bit.value, 63);
+        EXPECT_EQ("8'd255"_logic.str("d"), "255");
+    }
+    {
+        constexpr auto v = "128'hdead_beef"_logic;
+        static_assert(v.size == 128);
+        EXPECT_EQ(v.str("h"), "000000000000000000000000deadbeef");
+        EXPECT_FALSE(v.xz_mask.any_set());
+        auto const s = "100'sd1267650600228229401496703205375"_bit;
+        EXPECT_TRUE(s.negative());
+        EXPECT_EQ(s, (logic::bit<99, 0, true>(-1)));
+        // the same as the runtime parser
+        using runtime = logic::logic<71, 0>;
+        EXPECT_EQ("72'h1?_dead_beef_x0f0_0001"_logic.str("h"),
+                  runtime("72'h1?_dead_beef_x0f0_0001").str("h"));
+    }
+    {
+        // a leftmost x or z is extended to the size, LRM 5.7.1
+        EXPECT_EQ("8'bz1"_logic.str(), "zzzzzzz1");
+        EXPECT_EQ("70'hx"_logic.str(), std::string(70, 'x'));
+        EXPECT_EQ("8'dz"_logic.str(), "zzzzzzzz");
+        EXPECT_EQ("9'o?1"_logic.str(), "zzzzzz001");
+        EXPECT_EQ("8'b1x"_logic.str(), "0000001x");
+        EXPECT_EQ("8'h1x"_logic.str(), "0001xxxx");
+        // and the same at runtime, where the padding stops at the size of the literal
+        EXPECT_EQ((logic::logic<7, 0>("8'bz1").str()), "zzzzzzz1");
+        EXPECT_EQ((logic::logic<69, 0>("70'hx").str()), std::string(70, 'x'));
+        EXPECT_EQ((logic::logic<8, 0>("9'o?1").str()), "zzzzzz001");
+        EXPECT_EQ((logic::logic<7, 0>("8'b1x").str()), "0000001x");
+        EXPECT_EQ((logic::logic<15, 0>("8'bz1").str()), "00000000zzzzzzz1");
+        EXPECT_EQ((logic::logic<99, 0>("70'dx").str()),
+                  std::string(30, '0') + std::string(70, 'x'));
+        EXPECT_EQ((logic::logic<15, 0>("'hx").str()), std::string(16, 'x'));
+        EXPECT_EQ((logic::logic<99, 0>("'bz").str()), std::string(100, 'z'));
+    }
+}
+
+// msb first, one character per bit
+template <typename T>
+std::string bits_of(const T &v) {
+    std::string result;
+    for (auto i = static_cast<int>(v.size) - 1; i >= 0; i--) {
+        result += v[i].str();
+    }
+    return result;
 }
 
 TEST(logic, concat) {  // NOLINT
@@ -132,6 +207,92 @@ TEST(logic, concat) {  // NOLINT
         auto b = a.concat(logic::logic<4 - 1, 0>(2), logic::logic<4 - 1, 0>(3));
         EXPECT_EQ("000100100011", b.str());
     }
+    {
+        // mixed bit and logic operands, sign of the operands doesn't matter
+        logic::logic<3, 0> a("4'b1x0z");
+        logic::bit<2, 0, true> b(-1);
+        logic::logic<0> c;
+        auto d = a.concat(b, c, logic::bit<1, 0>(2));
+        EXPECT_EQ(d.size, 10);
+        EXPECT_EQ("1x0z111x10", d.str());
+    }
+    {
+        // across word boundaries
+        logic::logic<59, 0> a;
+        a.value = logic::bit<59, 0>(0xABCDEF);
+        a.xz_mask = logic::bit<59, 0>(0);
+        logic::bit<99, 0> b(0x12345);
+        logic::logic<6, 0> c("7'bz1x0101");
+        auto d = a.concat(b, c);
+        EXPECT_EQ(d.size, 167);
+        EXPECT_EQ(bits_of(d), bits_of(a) + bits_of(b) + "z1x0101");
+        auto e = logic::concat(b, logic::bit<27, 0>(0xFFF'FFFF));
+        EXPECT_EQ(e.size, 128);
+        EXPECT_EQ(e.value.values[0], 0x1234'5FFF'FFFFull);
+        EXPECT_EQ(e.value.values[1], 0ull);
+    }
+}
+
+// reference streaming through the string form, slices are cut from the lsb, LRM 11.4.14.2
+std::string stream_left_str(const std::string &bits, uint64_t slice) {
+    std::string result;
+    for (uint64_t end = bits.size(); end > 0; end -= std::min(end, slice)) {
+        auto const start = end - std::min(end, slice);
+        result += bits.substr(start, end - start);
+    }
+    return result;
+}
+
+template <uint64_t size, uint64_t slice>
+void test_stream(std::mt19937 &gen) {
+    logic::logic<size - 1, 0> a;
+    for (auto i = 0u; i < size; i++) {
+        auto const v = gen() % 4;
+        a.value.set(i, v & 1);
+        a.xz_mask.set(i, v & 2);
+    }
+    auto const bits = bits_of(a);
+    EXPECT_EQ(bits_of(a.template stream_left<slice>()), stream_left_str(bits, slice))
+        << size << " " << slice;
+    EXPECT_EQ(bits_of(a.template stream_right<slice>()), bits);
+    EXPECT_EQ(bits_of(a.value.template stream_left<slice>()),
+              stream_left_str(bits_of(a.value), slice));
+}
+
+template <uint64_t size>
+void test_stream(std::mt19937 &gen) {
+    test_stream<size, 1>(gen);
+    test_stream<size, 2>(gen);
+    test_stream<size, 3>(gen);
+    test_stream<size, 8>(gen);
+    test_stream<size, 16>(gen);
+    test_stream<size, 64>(gen);
+    test_stream<size, 100>(gen);
+}
+
+TEST(logic, stream) {  // NOLINT
+    {
+        logic::bit<7, 0> a(0b1100'1010);
+        EXPECT_EQ(a.stream_left().str(), "01010011");
+        EXPECT_EQ(logic::stream_left<4>(a).str(), "10101100");
+        EXPECT_EQ(logic::stream_left<3>(a).str(), "01000111");
+        // the short slice is the msb part and ends up at the bottom
+        logic::logic<5, 0> d("6'b110101");
+        EXPECT_EQ(logic::stream_left<4>(d).str(), "010111");
+        logic::logic<15, 0> b("16'hAB_xz");
+        EXPECT_EQ(logic::stream_left<8>(b).str("h"), "xzab");
+        auto c = logic::stream_left<8>(logic::bit<7, 0>(0x12), b);
+        EXPECT_EQ(c.str("h"), "xzab12");
+        EXPECT_EQ(logic::stream_right(logic::bit<7, 0, true>(-1), b).str("h"), "ffabxz");
+    }
+    std::mt19937 gen(42);
+    test_stream<1>(gen);
+    test_stream<7>(gen);
+    test_stream<64>(gen);
+    test_stream<65>(gen);
+    test_stream<128>(gen);
+    test_stream<200>(gen);
+    test_stream<1000>(gen);
 }
 
 TEST(logic, mask) {  // NOLINT
@@ -418,6 +579,36 @@ TEST(logic, not_) {  // NOLINT
     }
 }
 
+TEST(logic, known) {  // NOLINT
+    logic::logic<3, 0> a{"4'b1010"}, b{"4'b01x0"};
+    EXPECT_TRUE(a.known());
+    EXPECT_FALSE(b.known());
+    EXPECT_TRUE(a.known(a));
+    EXPECT_FALSE(a.known(b));
+    EXPECT_FALSE(b.known(a));
+
+    // wide values take the 2-state path when neither side has x or z
+    logic::logic<129, 0> c{"130'h3_0000_0000_0000_0000_ffff_ffff_0000_1234"};
+    logic::logic<129, 0> d{"130'h1_ffff_ffff_ffff_ffff_0000_ffff_0000_00ff"};
+    EXPECT_TRUE(c.known(d));
+    EXPECT_EQ((c & d).str("h"), "100000000000000000000ffff00000034");
+    EXPECT_EQ((c | d).str("h"), "3ffffffffffffffffffffffff000012ff");
+    EXPECT_EQ((c ^ d).str("h"), "2ffffffffffffffffffff0000000012cb");
+    EXPECT_EQ((~c).str("h"), "0ffffffffffffffff00000000ffffedcb");
+    EXPECT_EQ((c << logic::logic<7, 0>(4)).str("h"), "0000000000000000ffffffff000012340");
+    EXPECT_TRUE((c & d).known());
+
+    logic::logic<129, 0> e{"130'h0_0000_0000_0000_0000_0000_0000_0000_00zx"};
+    EXPECT_FALSE(c.known(e));
+    EXPECT_FALSE(e.known(c));
+    EXPECT_EQ((c & e).str("h"), "0000000000000000000000000000000XX");
+    EXPECT_EQ((c | e).str("h"), "30000000000000000ffffffff000012XX");
+    EXPECT_EQ((~e).str("h"), "3ffffffffffffffffffffffffffffffxx");
+    EXPECT_EQ((c + e).str("h"), std::string(33, 'x'));
+    EXPECT_EQ((c == e).str(), "x");
+    EXPECT_EQ((c < d).str(), "0");
+}
+
 TEST(logic, r_and) {  // NOLINT
     {
         logic::logic<4 - 1, 0> a{"'b1001"};
@@ -444,6 +635,66 @@ TEST(logic, r_and) {  // NOLINT
     }
 }
 
+// bit by bit reference of the 4-state reductions
+template <int size>
+void test_reduction(std::mt19937 &rng) {
+    for (auto i = 0; i < 64; i++) {
+        logic::logic<size - 1, 0> a(0u);
+        // mostly known bits with the occasional x/z, so every outcome shows up
+        for (auto j = 0; j < size; j++) {
+            auto r = rng() % (i % 2 ? 8 : 64);
+            if (r == 0) {
+                a.set_x(j);
+            } else if (r == 1) {
+                a.set_z(j);
+            } else if (i % 4 < 2 || r == 2) {
+                // all ones except the occasional 0
+                a.value.set(j, r != 2);
+            } else {
+                a.value.set(j, r % 2);
+            }
+        }
+        char and_ = '1', or_ = '0', xor_ = '0';
+        bool has_xz = false;
+        for (auto j = 0; j < size; j++) {
+            if (a.xz_mask[j]) {
+                has_xz = true;
+            } else if (a.value[j]) {
+                or_ = '1';
+                xor_ = xor_ == '0' ? '1' : '0';
+            } else {
+                and_ = '0';
+            }
+        }
+        if (has_xz) {
+            if (and_ == '1') and_ = 'x';
+            if (or_ == '0') or_ = 'x';
+            xor_ = 'x';
+        }
+        EXPECT_EQ(a.r_and().str(), std::string(1, and_));
+        EXPECT_EQ(a.r_or().str(), std::string(1, or_));
+        EXPECT_EQ(a.r_xor().str(), std::string(1, xor_));
+    }
+}
+
+TEST(logic, reduction_words) {  // NOLINT
+    std::mt19937 rng(0);
+    test_reduction<1>(rng);
+    test_reduction<7>(rng);
+    test_reduction<32>(rng);
+    test_reduction<64>(rng);
+    test_reduction<65>(rng);
+    test_reduction<200>(rng);
+    test_reduction<1024>(rng);
+
+    // a known 0 wins over x, no matter where it is
+    using two = logic::logic<1, 0>;
+    using three = logic::logic<2, 0>;
+    EXPECT_EQ(two("'b0x").r_and().str(), "0");
+    EXPECT_EQ(two("'b1x").r_or().str(), "1");
+    EXPECT_EQ(three("'b111").r_xor().str(), "1");
+}
+
 TEST(logic, r_nand) {  // NOLINT
     {
         logic::logic<4 - 1, 0> a{"'b1001"};
@@ -706,12 +957,30 @@ TEST(logic, arithmetic_shift_right) {  // NOLINT
         logic::logic<120 - 1, 0> b{42ul};
         auto c = a.ashr(b);
         ss = {};
-        for (auto i = 0; i < 42; i++) ss << '1';
-        for (auto i = 42; i < 420; i++) ss << '0';
+        // 42 sign-filled bits plus the sign bit itself
+        for (auto i = 0; i < 43; i++) ss << '1';
+        for (auto i = 43; i < 420; i++) ss << '0';
         EXPECT_EQ(c.str(), ss.str());
     }
 }
 
+TEST(logic, shift_word_boundary) {  // NOLINT
+    // pattern that is not periodic in 64 bits so that misplaced words show up
+    std::string ref;
+    for (auto i = 0; i < 200; i++) ref.push_back((i % 3 == 0 || i % 7 == 0) ? '1' : '0');
+    logic::logic<200 - 1, 0, true> a{"'b" + ref};
+    for (auto amount : {0u, 1u, 7u, 63u, 64u, 65u, 127u, 128u, 130u, 199u, 200u}) {
+        logic::logic<31, 0> b{amount};
+        auto const n = std::min<uint64_t>(amount, 200);
+        auto l = a << b;
+        EXPECT_EQ(l.str(), ref.substr(n) + std::string(n, '0'));
+        auto r = a >> b;
+        EXPECT_EQ(r.str(), std::string(n, '0') + ref.substr(0, 200 - n));
+        auto ar = a.ashr(b);
+        EXPECT_EQ(ar.str(), std::string(n, '1') + ref.substr(0, 200 - n));
+    }
+}
+
 TEST(logic, equal) {  // NOLINT
     {
         logic::logic a{true};
@@ -1020,6 +1289,125 @@ TEST(logic, mod) {  // NOLINT
     }
 }
 
+TEST(logic, div_mod) {  // NOLINT
+    using namespace logic::literals;
+    {
+        logic::logic<300 - 1, 0> a{0u};
+        a = ~a;
+        auto b = 42_logic;
+        auto [q, r] = a.div_mod(b);
+        EXPECT_TRUE(q.match(a / b));
+        EXPECT_TRUE(r.match(a % b));
+    }
+
+    {
+        auto [q, r] = (100_logic).div_mod(42_logic);
+        EXPECT_EQ(q, 2_logic);
+        EXPECT_EQ(r, 16_logic);
+    }
+
+    {
+        // x and divide by zero
+        auto [q, r] = (100_logic).div_mod(0_logic);
+        EXPECT_EQ(q.str(), std::string(32, 'x'));
+        EXPECT_EQ(r.str(), std::string(32, 'x'));
+        std::tie(q, r) = (100_logic).div_mod(logic::logic<31, 0, true>("'bx"));
+        EXPECT_EQ(q.str(), std::string(32, 'x'));
+    }
+}
+
+TEST(logic, pow) {  // NOLINT
+    using namespace logic::literals;
+    {
+        // LRM Table 11-4, native
+        using num = logic::logic<7, 0, true>;
+        auto pow = [](int8_t a, int8_t b) { return num(a).pow(num(b)); };
+        EXPECT_EQ(pow(-3, 3), num(-27));
+        EXPECT_EQ(pow(-3, 2), num(9));
+        EXPECT_EQ(pow(-1, 3), num(-1));
+        EXPECT_EQ(pow(-1, 4), num(1));
+        EXPECT_EQ(pow(-1, -3), num(-1));
+        EXPECT_EQ(pow(-1, -4), num(1));
+        EXPECT_EQ(pow(-3, -1), num(0));
+        EXPECT_EQ(pow(3, -1), num(0));
+        EXPECT_EQ(pow(1, -5), num(1));
+        EXPECT_EQ(pow(0, 5), num(0));
+        EXPECT_EQ(pow(0, 0), num(1));
+        EXPECT_EQ(pow(-5, 0), num(1));
+        EXPECT_EQ(pow(0, -1).str(), "xxxxxxxx");
+        // wraps around, and the exponent doesn't affect the result type
+        EXPECT_EQ((3_logic).pow(logic::logic<99, 0>(21u)), 10460353203_logic);
+        EXPECT_EQ((2_logic).pow(logic::bit<5, 0>(40u)), 0_logic);
+        EXPECT_EQ((2_logic).pow(logic::bit<5, 0>(40u)).size, 32);
+        // a wide exponent keeps a native base on the native path
+        auto const huge = logic::logic<99, 0>(1) << logic::logic<7, 0>(70);
+        EXPECT_EQ((3_logic).pow(huge), 1_logic);
+        EXPECT_EQ((3_logic).pow(huge + logic::logic<99, 0>(21u)), 10460353203_logic);
+        EXPECT_EQ((2_logic).pow(huge), 0_logic);
+        EXPECT_EQ((0_logic).pow(huge), 0_logic);
+        EXPECT_EQ((num(-1)).pow(huge + logic::logic<99, 0>(1u)), num(-1));
+        EXPECT_EQ((num(-1)).pow(logic::logic<99, 0, true>(-3)), num(-1));
+    }
+    {
+        // big numbers
+        using num = logic::logic<99, 0, true>;
+        num three(3), minus_one(-1), minus_three(-3), zero(0);
+        auto r = num(1);
+        for (auto i = 0; i < 50; i++) r = r * three;
+        EXPECT_EQ(three.pow(logic::logic<7, 0>(50u)), r);
+        EXPECT_EQ(minus_three.pow(logic::logic<7, 0>(3u)), num(-27));
+        EXPECT_EQ(minus_one.pow(num(-7)), minus_one);
+        EXPECT_EQ(minus_one.pow(num(-8)), num(1));
+        EXPECT_EQ(three.pow(num(-2)), zero);
+        std::string top(100, '0');
+        top[0] = '1';
+        EXPECT_EQ(num(2).pow(logic::logic<7, 0>(99u)).str(), top);
+        EXPECT_EQ(num(2).pow(logic::logic<7, 0>(100u)), zero);
+        EXPECT_EQ(zero.pow(num(-2)).str(), std::string(100, 'x'));
+        EXPECT_EQ(three.pow(logic::logic<7, 0>("'bx")).str(), std::string(100, 'x'));
+    }
+}
+
+TEST(logic, inplace_add_sub) {  // NOLINT
+    using namespace logic::literals;
+    {
+        using num = logic::logic<7, 0>;
+        num a(255u);
+        ++a;
+        EXPECT_EQ(a, num(0u));
+        --a;
+        EXPECT_EQ(a, num(255u));
+        a += 2_logic;
+        EXPECT_EQ(a, num(1u));
+        a -= logic::bit<1, 0>(2u);
+        EXPECT_EQ(a, num(255u));
+    }
+    {
+        using num = logic::logic<199, 0>;
+        num a(0u);
+        --a;
+        EXPECT_EQ(a.str(), std::string(200, '1'));
+        ++a;
+        EXPECT_EQ(a, num(0u));
+        a -= 1_logic;
+        EXPECT_EQ(a.str(), std::string(200, '1'));
+        a += logic::bit<199, 0>(2u);
+        EXPECT_EQ(a, num(1u));
+        auto b = a++;
+        EXPECT_EQ(b, num(1u));
+        EXPECT_EQ(a, num(2u));
+    }
+    {
+        // any x/z turns the whole value into x
+        logic::logic<99, 0> a("100'b1x");
+        ++a;
+        EXPECT_EQ(a.str(), std::string(100, 'x'));
+        logic::logic<99, 0> b(1u);
+        b += logic::logic<3, 0>("4'bz");
+        EXPECT_EQ(b.str(), std::string(100, 'x'));
+    }
+}
+
 // we only need to implement > since the reset are based off that
 TEST(logic, gt) {  // NOLINT
     using namespace logic::literals;
@@ -1134,6 +1522,44 @@ TEST(logic, update) {  // NOLINT
     }
 }
 
+TEST(logic, update_words) {  // NOLINT
+    // crosses word boundaries with x/z in the source
+    logic::logic<299, 0> a(0u);
+    logic::logic<99, 0> b;
+    for (auto i = 0; i < 100; i++) {
+        if (i % 7 == 0) {
+            b.set_x(i);
+        } else if (i % 11 == 0) {
+            b.set_z(i);
+        } else {
+            b.set(i, i % 3 == 0);
+        }
+    }
+    a.update<170, 60>(b);
+    for (auto i = 0; i < 300; i++) {
+        auto expected = (i >= 60 && i < 160) ? b[i - 60].str() : "0";
+        EXPECT_EQ(a[i].str(), expected);
+    }
+    // runtime version, truncating the source
+    logic::logic<299, 0> c;
+    c.update(200, 130, b);
+    for (auto i = 0; i < 300; i++) {
+        auto expected = i < 130 || i > 200 ? "x" : b[i - 130].str();
+        EXPECT_EQ(c[i].str(), expected);
+    }
+    // and zero extending it
+    logic::logic<299, 0> e;
+    e.update(250, 130, b);
+    for (auto i = 0; i < 300; i++) {
+        auto expected = i < 130 || i > 250 ? "x" : (i < 230 ? b[i - 130].str() : "0");
+        EXPECT_EQ(e[i].str(), expected);
+    }
+    // native
+    logic::logic<31, 0> d(0u);
+    d.update<20, 5>(logic::logic<7, 0>("8'bzx10_1101"));
+    EXPECT_EQ(d.str(), "00000000000" "00000000zx101101" "00000");
+}
+
 TEST(logic, to_uint64) {  // NOLINT
     using namespace logic::literals;
     auto a = 42_logic;
@@ -1156,6 +1582,11 @@ TEST(logic, string_init) {  // NOLINT
 
     auto e = logic::logic<31, 0>("20'b001_0101");
     EXPECT_EQ(e.to_uint64(), 21);
+
+    // s marks a signed literal rather than a string
+    auto f = logic::logic<7, 0, true>("8'shF0");
+    EXPECT_EQ(f.str("h"), "f0");
+    EXPECT_FALSE(f.xz_mask.any_set());
 }
 
 TEST(logic, format) {  // NOLINT
@@ -1228,6 +1659,189 @@ TEST(logic, format) {  // NOLINT
     }
 }
 
+// one digit at a time, as a reference for the chunked decimal formatting
+template <uint64_t size>
+std::string naive_decimal(logic::bit<size - 1, 0> v) {
+    std::string result;
+    auto words = v.value.values;
+    bool non_zero = true;
+    while (non_zero) {
+        __uint128_t rem = 0;
+        non_zero = false;
+        for (auto i = words.size(); i > 0; i--) {
+            auto cur = (rem << 64) | words[i - 1];
+            words[i - 1] = static_cast<uint64_t>(cur / 10);
+            rem = cur % 10;
+            non_zero = non_zero || words[i - 1];
+        }
+        result.push_back(static_cast<char>('0' + static_cast<int>(rem)));
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+template <uint64_t size>
+void test_format_decimal(std::mt19937_64 &gen) {
+    logic::bit<size - 1, 0> a;
+    for (auto &w : a.value.values) w = gen();
+    a.value.mask_off();
+    EXPECT_EQ(a.str("0d"), naive_decimal<size>(a)) << size;
+    // powers of 10 have long runs of zeros across the chunk boundaries
+    logic::bit<size - 1, 0> p(1);
+    for (auto i = 0u; i < size * 3 / 10; i++) {
+        p = p * logic::bit<size - 1, 0>(10);
+    }
+    std::string expected(size * 3 / 10 + 1, '0');
+    expected[0] = '1';
+    EXPECT_EQ(p.str("0d"), expected) << size;
+}
+
+TEST(logic, format_decimal) {  // NOLINT
+    {
+        logic::bit<127, 0> a;
+        a.value.values = {~0ull, ~0ull};
+        EXPECT_EQ(a.str("d"), "340282366920938463463374607431768211455");
+        logic::bit<255, 0> b;
+        b.value.values = {~0ull, ~0ull, ~0ull, ~0ull};
+        EXPECT_EQ(b.str("d"),
+                  "115792089237316195423570985008687907853269984665640564039457584007913129639935");
+        // padding follows the width of the largest value
+        using b256 = logic::bit<255, 0>;
+        EXPECT_EQ(b256(42).str("d"), std::string(76, ' ') + "42");
+        EXPECT_EQ(b256(0).str("0d"), "0");
+        EXPECT_EQ((-logic::bit<199, 0, true>(1234567)).str("0d"), "-1234567");
+    }
+    {
+        // x and z
+        logic::logic<199, 0> a;
+        EXPECT_EQ(a.str("0d"), "x");
+        a.value.value.values[1] = 1;
+        EXPECT_EQ(a.str("0d"), "X");
+        a = logic::logic<199, 0>(42);
+        a.xz_mask.set(150, true);
+        a.value.set(150, true);
+        EXPECT_EQ(a.str("0d"), "Z");
+        a.value.set(150, false);
+        EXPECT_EQ(a.str("0d"), "X");
+        a.xz_mask.set(150, false);
+        EXPECT_EQ(a.str("0d"), "42");
+    }
+    std::mt19937_64 gen(42);
+    test_format_decimal<65>(gen);
+    test_format_decimal<128>(gen);
+    test_format_decimal<256>(gen);
+    test_format_decimal<1000>(gen);
+    test_format_decimal<4096>(gen);
+    test_format_decimal<10000>(gen);
+}
+
+TEST(logic, format_to) {  // NOLINT
+    {
+        std::array<char, 32> buf{};
+        logic::bit<11, 0> a(0x2A5);
+        auto *end = a.format_to(buf.begin(), buf.end(), "h");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "2a5");
+        end = a.format_to(buf.begin(), buf.end(), "8o");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "00001245");
+        end = (-logic::bit<11, 0, true>(42)).format_to(buf.begin(), buf.end(), "d");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "  -42");
+        // doesn't fit
+        EXPECT_EQ(a.format_to(buf.begin(), buf.begin() + 11), nullptr);
+        end = a.format_to(buf.begin(), buf.begin() + 12);
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "001010100101");
+    }
+    {
+        std::array<char, 32> buf{};
+        logic::logic<11, 0> a("12'b1x0z_zzzz_xxxx");
+        auto *end = a.format_to(buf.begin(), buf.end(), "h");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "Xzx");
+        end = a.format_to(buf.begin(), buf.end(), "o");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), "XzXx");
+        EXPECT_EQ(a.format_to(buf.begin(), buf.begin() + 2, "h"), nullptr);
+    }
+    {
+        // multiple words, most significant word first
+        logic::bit<99, 0> a(0x12345);
+        a.value.values[1] = 0xF'0000'0001;
+        EXPECT_EQ(a.str("h"), "f00000001" + std::string("0000000000012345"));
+        EXPECT_EQ(a.str("0h"), "f00000001" + std::string("0000000000012345"));
+        using b100 = logic::bit<99, 0>;
+        EXPECT_EQ(b100(5).str("0b"), "101");
+        EXPECT_EQ(b100(5).str("0h"), "5");
+        EXPECT_EQ(b100(0).str("0h"), "0");
+        logic::logic<99, 0> b(0x12345);
+        b.xz_mask.set(99, true);
+        EXPECT_EQ(b.str("h"), "X000000000000000000012345");
+        for (auto i = 96; i < 99; i++) b.xz_mask.set(i, true);
+        EXPECT_EQ(b.str("0h"), "x000000000000000000012345");
+    }
+    {
+        // wide values don't allocate in any base, only the str() result does
+        std::mt19937_64 gen(1024);
+        logic::bit<1023, 0> a;
+        logic::logic<4095, 0, true> b;
+        for (auto &v : a.value.values) v = gen();
+        for (auto &v : b.value.value.values) v = gen();
+        b.xz_mask.value.values = {};
+        auto const a_b = a.str("b"), a_d = a.str("d"), b_d = b.str("d"), b_h = b.str("h");
+        std::array<char, 4200> buf{};
+        auto const before = allocations.load();
+        auto *end = a.format_to(buf.begin(), buf.end(), "b");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), a_b);
+        end = a.format_to(buf.begin(), buf.end(), "d");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), a_d);
+        end = b.format_to(buf.begin(), buf.end(), "d");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), b_d);
+        end = b.format_to(buf.begin(), buf.end(), "h");
+        EXPECT_EQ(std::string_view(buf.data(), end - buf.data()), b_h);
+        EXPECT_EQ(allocations.load(), before);
+    }
+}
+
+TEST(logic, format_to_iterator) {  // NOLINT
+    // what the std::formatter writes, including fields wider than the digits
+    auto format = [](auto const &v, std::string_view fmt) {
+        std::string result;
+        logic::util::format_to_iterator(std::back_inserter(result), v,
+                                        logic::util::parse_format_spec(fmt));
+        return result;
+    };
+    logic::bit<11, 0> a(0x2A5);
+    EXPECT_EQ(format(a, "h"), "2a5");
+    EXPECT_EQ(format(a, "b"), "001010100101");
+    EXPECT_EQ(format(a, "0b"), "1010100101");
+    EXPECT_EQ(format(a, "8o"), "00001245");
+    EXPECT_EQ(format(a, "2h"), "2a5");
+    EXPECT_EQ(format(a, "20b"), "00000000001010100101");
+    EXPECT_EQ(format(a, "20b"), a.str("20b"));
+    auto const n = -logic::bit<11, 0, true>(42);
+    EXPECT_EQ(format(n, "d"), "  -42");
+    EXPECT_EQ(format(n, "0d"), "-42");
+    EXPECT_EQ(format(n, "20d"), n.str("20d"));
+    logic::logic<11, 0> b("12'b1x0z_zzzz_xxxx");
+    EXPECT_EQ(format(b, "h"), "Xzx");
+    EXPECT_EQ(format(b, "16b"), b.str("16b"));
+    EXPECT_EQ(format(b, "d"), b.str("d"));
+    logic::logic<4095, 0> c(0x1234);
+    EXPECT_EQ(format(c, "d"), c.str("d"));
+    EXPECT_EQ(format(c, "b"), c.str("b"));
+    EXPECT_EQ(format(c, "5000h"), c.str("5000h"));
+}
+
+#if __cpp_lib_format
+TEST(logic, std_format) {  // NOLINT
+    logic::bit<11, 0> a(0x2A5);
+    EXPECT_EQ(std::format("{}", a), "001010100101");
+    EXPECT_EQ(std::format("{:h} {:8o}", a, a), "2a5 00001245");
+    EXPECT_EQ(std::format("{:d}", -logic::bit<11, 0, true>(42)), "  -42");
+    logic::logic<11, 0> b("12'b1x0z_zzzz_xxxx");
+    EXPECT_EQ(std::format("{:h}", b), "Xzx");
+    EXPECT_EQ(std::format("{:16b}", b), b.str("16b"));
+    EXPECT_THROW(static_cast<void>(std::vformat("{:q}", std::make_format_args(a))),
+                 std::format_error);
+}
+#endif
+
 TEST(logic, match) {  // NOLINT
     logic::logic<31, 0> a;
     logic::logic<31, 0> b;
@@ -13,4 +13,13 @@ TEST(regression, boolean) {  // NOLINT
         correct = false;
     }
     EXPECT_TRUE(correct);
-}
\ No newline at end of file
+}
+
+TEST(regression, single_bit) {  // NOLINT
+    // bit<0> holds a bool, which doesn't shift or multiply
+    logic::bit<0> a(1), b(1), zero(0);
+    EXPECT_EQ((a << zero).value, true);
+    EXPECT_EQ((a << b).value, false);
+    EXPECT_EQ((a * b).value, true);
+    EXPECT_EQ((a * zero).value, false);
+}
@@ -0,0 +1,93 @@
+#include <filesystem>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "logic/serialize.hh"
+
+template <typename T>
+T round_trip(const T &v) {
+    std::array<char, logic::serialized_size<T>()> buffer;
+    auto *end = logic::serialize(v, buffer.data());
+    EXPECT_EQ(end, buffer.data() + buffer.size());
+    T result;
+    EXPECT_EQ(logic::deserialize(result, buffer.data(), end), end);
+    return result;
+}
+
+TEST(serialize, value) {  // NOLINT
+    auto a = logic::bit<11, 0, true>(-42);
+    EXPECT_EQ(round_trip(a).str("d"), "  -42");
+    auto b = logic::logic<3, 0>("4'b1xz0");
+    EXPECT_EQ(round_trip(b).str(), "1xz0");
+    auto c = logic::logic<199, 0>("200'hz_1234_5678_9abc_def0_xxxx_0000_ffff");
+    EXPECT_EQ(round_trip(c).str("h"), c.str("h"));
+    auto d = logic::big_num<130, true>(-1);
+    EXPECT_EQ(round_trip(d).values, d.values);
+    auto e = logic::packed_array<logic::logic<7, 0>, 3, 0>("32'hdead_xxzz");
+    EXPECT_EQ(round_trip(e).str("h"), "deadxxzz");
+
+    // the record is width tagged and little-endian
+    std::array<char, logic::serialized_size<logic::bit<15, 0>>()> buffer;
+    static_assert(buffer.size() == 24);
+    logic::serialize(logic::bit<15, 0>(0x1234), buffer.data());
+    EXPECT_EQ(buffer[0], 16);
+    EXPECT_EQ(buffer[16], 0x34);
+    EXPECT_EQ(buffer[17], 0x12);
+
+    // width and state have to match
+    logic::bit<16, 0> wrong_width;
+    logic::logic<15, 0> wrong_state;
+    EXPECT_EQ(logic::deserialize(wrong_width, buffer.data(), buffer.data() + buffer.size()),
+              nullptr);
+    EXPECT_EQ(logic::deserialize(wrong_state, buffer.data(), buffer.data() + buffer.size()),
+              nullptr);
+    logic::bit<15, 0> truncated;
+    EXPECT_EQ(logic::deserialize(truncated, buffer.data(), buffer.data() + buffer.size() - 1),
+              nullptr);
+}
+
+TEST(serialize, snapshot) {  // NOLINT
+    auto const filename = (std::filesystem::temp_directory_path() / "logic_snapshot.bin").string();
+    auto a = logic::logic<31, 0>("32'hxxxx_1234");
+    auto mem = std::make_unique<logic::unpacked_array<logic::logic<99, 0>, 0, 1023>>();
+    for (auto i = 0; i < 1024; i++) {
+        mem->value[i] = logic::logic<99, 0>(i * 3);
+        if (i % 7 == 0) mem->value[i].xz_mask.value.values[1] = i;
+    }
+    auto b = logic::bit<0>(true);
+    {
+        logic::snapshot_writer writer(filename);
+        EXPECT_TRUE(writer.write(a));
+        EXPECT_TRUE(writer.write(*mem));
+        EXPECT_TRUE(writer.write(b));
+        EXPECT_TRUE(writer.close());
+    }
+
+    logic::snapshot_reader reader(filename);
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(reader.version(), logic::snapshot_version);
+    logic::logic<31, 0> a_;
+    EXPECT_FALSE(reader.read(b));
+    EXPECT_TRUE(reader.read(a_));
+    EXPECT_EQ(a_.str("h"), "xxxx1234");
+
+    // the memory is read lazily, one element at a time
+    auto record = reader.map<logic::logic<99, 0>>();
+    ASSERT_TRUE(record);
+    EXPECT_EQ(record.size(), 1024);
+    for (auto i : {0, 1, 7, 500, 1023}) {
+        EXPECT_EQ(record[i].str("h"), mem->value[i].str("h"));
+    }
+    std::array<logic::logic<99, 0>, 4> some;
+    record.read(20, some.size(), some.begin());
+    EXPECT_EQ(some[1].str("h"), mem->value[21].str("h"));
+
+    logic::bit<0> b_;
+    EXPECT_TRUE(reader.read(b_));
+    EXPECT_TRUE(b_.value);
+    EXPECT_TRUE(reader.done());
+    EXPECT_FALSE(reader.skip());
+
+    std::filesystem::remove(filename);
+    EXPECT_FALSE(logic::snapshot_reader(filename).ok());
+}
@@ -0,0 +1,150 @@
+#include <random>
+
+#include "gtest/gtest.h"
+#include "logic/soa.hh"
+
+// 0, 1, x and z in the 4-state truth tables of LRM 11.4.8
+constexpr std::string_view states = "01xz";
+
+char and_bit(char a, char b) {
+    if (a == '0' || b == '0') return '0';
+    return a == '1' && b == '1' ? '1' : 'x';
+}
+
+char or_bit(char a, char b) {
+    if (a == '1' || b == '1') return '1';
+    return a == '0' && b == '0' ? '0' : 'x';
+}
+
+char xor_bit(char a, char b) {
+    if (a > '1' || b > '1') return 'x';
+    return a == b ? '0' : '1';
+}
+
+// element-wise operators against the truth tables, for narrow, word sized and wide elements
+template <int width, int count>
+void check_bitwise() {
+    using T = logic::logic<width - 1, 0>;
+    std::mt19937 rng(width);
+    logic::soa_array<T, count - 1, 0> a, b;
+    std::vector<std::string> a_digits, b_digits;
+    for (auto i = 0; i < count; i++) {
+        for (auto *digits : {&a_digits, &b_digits}) {
+            std::string d(width, '0');
+            for (auto &c : d) c = states[rng() % states.size()];
+            digits->emplace_back(d);
+        }
+        a[i] = T(std::to_string(width).append("'b").append(a_digits.back()));
+        b[i] = T(std::to_string(width).append("'b").append(b_digits.back()));
+    }
+    auto const and_ = a & b, or_ = a | b, xor_ = a ^ b, not_ = ~a;
+    for (auto i = 0; i < count; i++) {
+        auto const &x = a_digits[i], &y = b_digits[i];
+        EXPECT_EQ(a[i].str(), x);
+        std::string and_str, or_str, xor_str, not_str;
+        for (auto j = 0; j < width; j++) {
+            and_str += and_bit(x[j], y[j]);
+            or_str += or_bit(x[j], y[j]);
+            xor_str += xor_bit(x[j], y[j]);
+            not_str += xor_bit(x[j], '1');
+        }
+        EXPECT_EQ(and_[i].str(), and_str);
+        EXPECT_EQ(or_[i].str(), or_str);
+        EXPECT_EQ(xor_[i].str(), xor_str);
+        EXPECT_EQ(not_[i].str(), not_str);
+    }
+}
+
+TEST(soa_array, bitwise) {  // NOLINT
+    check_bitwise<1, 100>();
+    check_bitwise<3, 77>();
+    check_bitwise<8, 50>();
+    check_bitwise<64, 10>();
+    check_bitwise<100, 10>();
+}
+
+TEST(soa_array, layout) {  // NOLINT
+    // 3-bit elements take 4 bits, so 16 of them fit in a word
+    logic::soa_array<logic::logic<2, 0>, 99, 0> a;
+    EXPECT_EQ(a.stride, 4u);
+    EXPECT_EQ(a.value.size(), 7u);
+    EXPECT_EQ(a.xz_mask.size(), 7u);
+    // everything is x, without touching the padding
+    EXPECT_TRUE(a.any_x());
+    EXPECT_EQ(a.xz_mask[0], 0x7777'7777'7777'7777u);
+    EXPECT_EQ(a.xz_mask[6], 0x7777u);
+    EXPECT_EQ(a[99].str(), "xxx");
+
+    // 2-state elements have no xz block
+    logic::soa_array<logic::bit<99, 0>, 9, 0> b;
+    EXPECT_EQ(b.stride, 128u);
+    EXPECT_TRUE(b.xz_mask.empty());
+    EXPECT_FALSE(b.any_x());
+    EXPECT_EQ(b[0].str("h"), std::string(25, '0'));
+}
+
+TEST(soa_array, fill) {  // NOLINT
+    logic::soa_array<logic::logic<7, 0>, 1000, 1> a;
+    a.fill(logic::logic<7, 0>(0x5A));
+    EXPECT_FALSE(a.any_x());
+    EXPECT_EQ(a[1].str("h"), "5a");
+    EXPECT_EQ(a[1000].str("h"), "5a");
+
+    // only the low nibble is written
+    a.fill(logic::logic<7, 0>("8'hzx"), logic::bit<7, 0>(0x0F));
+    EXPECT_EQ(a[500].str("h"), "5x");
+    EXPECT_TRUE(a.any_x());
+    a.fill(logic::logic<7, 0>(0), logic::bit<7, 0>(0x0F));
+    EXPECT_EQ(a[500].str("h"), "50");
+    EXPECT_FALSE(a.any_x());
+
+    a.fill_x();
+    EXPECT_EQ(a[2].str("h"), "xx");
+
+    // the unused slots of the last word are never filled, so overwriting every element clears
+    // any_x
+    logic::soa_array<logic::logic<2, 0>, 0, 4> c;
+    c.fill(logic::logic<2, 0>());
+    EXPECT_TRUE(c.any_x());
+    for (auto i = 0; i <= 4; i++) c[i] = 1;
+    EXPECT_FALSE(c.any_x());
+    EXPECT_EQ(c.xz_mask[0], 0u);
+    EXPECT_EQ(c.value[0], 0x1'1111u);
+
+    logic::soa_array<logic::logic<99, 0>, 4, 0> b;
+    b.fill(logic::logic<99, 0>(42));
+    EXPECT_FALSE(b.any_x());
+    EXPECT_EQ(b[4].get().to_uint64(), 42u);
+}
+
+TEST(soa_array, reference) {  // NOLINT
+    logic::soa_array<logic::logic<11, 0>, 15, 0> a;
+    a[3] = 100;
+    a[4] = logic::logic<11, 0>(20);
+    // elements work in expressions the same way as logic
+    EXPECT_EQ((a[3] + a[4]).to_uint64(), 120u);
+    EXPECT_EQ((a[3] == logic::logic<11, 0>(100)).str(), "1");
+    EXPECT_EQ((logic::logic<11, 0>(100) == a[3]).str(), "1");
+    EXPECT_EQ((a[3] < a[4]).str(), "0");
+    EXPECT_EQ((a[3] == a[5]).str(), "x");
+    EXPECT_EQ((~a[4]).to_uint64(), 0xFEBu);
+    logic::logic<11, 0> l = a[3];
+    EXPECT_EQ(l.to_uint64(), 100u);
+    a[3] += logic::logic<11, 0>(1);
+    a[3] &= logic::logic<11, 0>(0xF);
+    EXPECT_EQ(a[3].get().to_uint64(), 5u);
+    a[5] = a[3];
+    EXPECT_EQ(a[5].get().to_uint64(), 5u);
+
+    // out of range reads are x and writes are dropped
+    a[16] = 1;
+    EXPECT_EQ(a[16].str(), std::string(12, 'x'));
+
+    // round trips through unpacked_array
+    auto const u = a.to_unpacked();
+    EXPECT_EQ(u[3].to_uint64(), 5u);
+    EXPECT_EQ(u[0].str(), std::string(12, 'x'));
+    logic::soa_array<logic::logic<11, 0>, 15, 0> b(u);
+    EXPECT_EQ(b.value, a.value);
+    EXPECT_EQ(b.xz_mask, a.xz_mask);
+}
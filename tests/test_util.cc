@@ -1,6 +1,8 @@
+#include <random>
 #include <sstream>
 
 #include "gtest/gtest.h"
+#include "logic/logic.hh"
 #include "logic/util.hh"
 
 TEST(util, int_parsing) {  // NOLINT
@@ -25,10 +27,11 @@ TEST(util, int_parsing) {  // NOLINT
         EXPECT_EQ(v, 10);
         v = logic::util::parse_raw_str("100'ox2");
         EXPECT_EQ(v, 2);
+        // the leftmost z pads all 64 bits
         v = logic::util::parse_raw_str("100'oz2");
-        EXPECT_EQ(v, 0b111'010);
+        EXPECT_EQ(v, std::numeric_limits<uint64_t>::max() << 3 | 0b010);
         v = logic::util::parse_xz_raw_str("100'oz2");
-        EXPECT_EQ(v, 0b111'000);
+        EXPECT_EQ(v, std::numeric_limits<uint64_t>::max() << 3);
     }
     {
         auto v = logic::util::parse_raw_str("100'hFFFF");
@@ -79,4 +82,75 @@ TEST(util, parse_raw_string) {  // NOLINT
     logic::util::parse_raw_str("ABCDEFGHIJKLMNOP", 128, data.data());
     EXPECT_EQ(data[0], 0x494a4b4c4d4e4f50);
     EXPECT_EQ(data[1], 0x4142434445464748);
-}
\ No newline at end of file
+}
+
+TEST(util, hex_digits) {  // NOLINT
+    auto v = logic::util::parse_raw_str("16'hab_Cd");
+    EXPECT_EQ(v, 0xABCD);
+    std::array<uint64_t, 2> data = {}, xz = {};
+    logic::util::parse_raw_str("72'h1?_dead_beef_x0f0_0001", 72, data.data(), xz.data());
+    EXPECT_EQ(data[0], 0xdeadbeef00f00001);
+    EXPECT_EQ(data[1], 0x1F);
+    EXPECT_EQ(xz[0], 0xF0000000);
+    EXPECT_EQ(xz[1], 0xF);
+}
+
+// every simd level has to agree with the scalar code, in both directions
+TEST(util, simd_kernels) {  // NOLINT
+    using logic::util::simd_level;
+    std::mt19937 gen(42);
+    constexpr std::string_view bin_chars = "01xzXZ?";
+    constexpr std::string_view hex_chars = "0123456789abcdefABCDEFxzXZ?";
+    std::vector<std::string> inputs;
+    for (auto len : {1, 63, 64, 65, 200, 1024}) {
+        for (auto chars : {bin_chars, hex_chars}) {
+            std::string s = chars == bin_chars ? "'b" : "'h";
+            for (auto i = 0; i < len; i++) {
+                s += chars[gen() % chars.size()];
+                if (gen() % 16 == 0) s += '_';
+            }
+            inputs.emplace_back(std::move(s));
+        }
+    }
+
+    auto const support = logic::util::simd_support();
+    std::vector<std::array<uint64_t, 64>> expected;
+    std::string expected_hex;
+    for (auto level : {simd_level::scalar, simd_level::sse42, simd_level::avx2}) {
+        if (level > support) continue;
+        EXPECT_EQ(logic::util::set_simd_level(level), level);
+        for (auto i = 0u; i < inputs.size(); i++) {
+            std::array<uint64_t, 64> words = {};
+            logic::util::parse_raw_str(inputs[i], 2048, words.data(), words.data() + 32);
+            if (level == simd_level::scalar) {
+                expected.emplace_back(words);
+            } else {
+                EXPECT_EQ(words, expected[i]) << inputs[i];
+            }
+        }
+
+        // the same value for every level
+        using wide = logic::logic<1999, 0>;
+        wide a;
+        std::mt19937 value_gen(7);
+        for (auto i = 0; i < 2000; i++) {
+            auto const v = value_gen() % 4;
+            a.value.set(i, v & 1);
+            a.xz_mask.set(i, v & 2);
+        }
+        auto const bits = a.str("b");
+        for (auto i = 0; i < 2000; i++) {
+            EXPECT_EQ(bits[1999 - i], a[i].str()[0]);
+        }
+        if (level == simd_level::scalar) {
+            expected_hex = a.str("h");
+        } else {
+            EXPECT_EQ(a.str("h"), expected_hex);
+        }
+        // round trip. a hex digit with mixed x and z bits doesn't keep them apart
+        EXPECT_EQ(wide(std::string("2000'b") + bits).str("b"), bits);
+        a.xz_mask = wide(0).xz_mask;
+        EXPECT_EQ(wide(std::string("2000'h") + a.str("h")).value, a.value);
+    }
+    logic::util::set_simd_level(support);
+}
@@ -0,0 +1,94 @@
+#include <filesystem>
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "logic/vcd.hh"
+
+std::string read_file(const std::string &filename) {
+    std::ifstream stream(filename);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+TEST(vcd, dump) {  // NOLINT
+    auto const filename = (std::filesystem::temp_directory_path() / "logic_dump.vcd").string();
+    logic::logic<0> clk(false);
+    logic::bit<7, 0, true> count(0);
+    logic::logic<99, 0> wide;
+    {
+        logic::vcd_writer vcd(filename, "1ps");
+        ASSERT_TRUE(vcd.ok());
+        vcd.add(clk, "clk");
+        vcd.add(count, "count", "top.cpu");
+        vcd.add(wide, "wide", "top.cpu.alu");
+        vcd.dump(0);
+        clk = logic::logic<0>(true);
+        count = logic::bit<7, 0, true>(-1);
+        vcd.dump(5);
+        // nothing changed
+        vcd.dump(7);
+        wide = logic::logic<99, 0>("100'b0x1");
+        vcd.dump(10);
+        count = logic::bit<7, 0, true>(2);
+        wide.xz_mask.clear();
+        vcd.dump(15);
+    }
+    EXPECT_EQ(read_file(filename),
+              "$timescale 1ps $end\n"
+              "$scope module top $end\n"
+              "$var wire 1 ! clk $end\n"
+              "$scope module cpu $end\n"
+              "$var wire 8 \" count [7:0] $end\n"
+              "$scope module alu $end\n"
+              "$var wire 100 # wide [99:0] $end\n"
+              "$upscope $end\n"
+              "$upscope $end\n"
+              "$upscope $end\n"
+              "$enddefinitions $end\n"
+              "#0\n"
+              "0!\n"
+              "b0 \"\n"
+              "bx #\n"
+              "#5\n"
+              "1!\n"
+              "b11111111 \"\n"
+              "#10\n"
+              "b0x1 #\n"
+              "#15\n"
+              "b10 \"\n"
+              "b1 #\n");
+    std::filesystem::remove(filename);
+}
+
+TEST(vcd, many_changes) {  // NOLINT
+    // enough changes to go through several blocks of the writer thread
+    auto const filename = (std::filesystem::temp_directory_path() / "logic_many.vcd").string();
+    using counter_type = logic::bit<31, 0>;
+    counter_type counter(0);
+    constexpr auto cycles = 100000;
+    {
+        logic::vcd_writer vcd(filename);
+        vcd.add(counter, "counter");
+        for (auto i = 0; i < cycles; i++) {
+            counter = counter_type(i);
+            vcd.dump(i);
+        }
+    }
+    std::ifstream stream(filename);
+    std::string line;
+    auto changes = 0;
+    while (std::getline(stream, line)) {
+        if (line.ends_with(" !")) {
+            EXPECT_EQ(line.front(), 'b');
+            EXPECT_EQ(line.substr(1, line.size() - 3), counter_type(changes).str("0b"));
+            changes++;
+        }
+    }
+    EXPECT_EQ(changes, cycles);
+    std::filesystem::remove(filename);
+
+    if (logic::vcd_writer::gzip_supported()) {
+        logic::vcd_writer vcd(filename + ".gz", "1ns", true);
+        EXPECT_TRUE(vcd.ok());
+        std::filesystem::remove(filename + ".gz");
+    }
+}